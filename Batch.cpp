@@ -2,6 +2,7 @@
 // Created by Bryn McKerracher on 4/10/2021.
 //
 
+#include <algorithm>
 #include <iostream>
 #include "Batch.h"
 
@@ -17,6 +18,44 @@ void Batch::addOps(const std::vector<Op::Code> &codes, int lineNum) {
 }
 
 size_t Batch::addConstant(const Value& value) {
+    if (isDeduplicated(value)) {
+        auto [index, inserted] = constantIndices.try_emplace(value, constantPool.size());
+        if (!inserted) return index->second;
+    }
     constantPool.push_back(value);
     return constantPool.size() - 1;
 }
+
+void Batch::rewind(size_t opcodeCount, size_t constantCount) {
+    opcodes.resize(opcodeCount);
+    lines.resize(opcodeCount);
+    for (size_t index = constantCount; index < constantPool.size(); ++index) {
+        if (isDeduplicated(constantPool[index])) {
+            constantIndices.erase(constantPool[index]);
+        }
+    }
+    constantPool.resize(constantCount);
+}
+
+void Batch::measureStack() {
+    size_t depth = 0;
+    maxStackDepth = 0;
+    for (size_t index = 0; index < opcodes.size(); index += Op::instructionLength(opcodes[index])) {
+        depth += Op::stackEffect(&opcodes[index]);
+        maxStackDepth = std::max(maxStackDepth, depth);
+    }
+}
+
+size_t Batch::ConstantHash::operator()(const Value &value) const {
+    if (value.type() == Value::Type::STRING) return std::hash<std::string>()(value.asString());
+    return std::hash<uint64_t>()(value.bits);
+}
+
+bool Batch::ConstantEqual::operator()(const Value &lhs, const Value &rhs) const {
+    if (lhs.bits == rhs.bits) return true;
+    return lhs.type() == Value::Type::STRING && rhs.type() == Value::Type::STRING && lhs.asString() == rhs.asString();
+}
+
+bool Batch::isDeduplicated(const Value &value) {
+    return value.type() != Value::Type::MATRIXF && value.type() != Value::Type::MATRIXD;
+}
@@ -8,6 +8,7 @@
  * @brief The Batch class, contains information about a code batch.
  */
 
+#include <unordered_map>
 #include <vector>
 #include "common.h"
 #include "Ops.h"
@@ -19,6 +20,10 @@
  *
  * The compiler creates these from parsing information for the VM to interpret.
  *
+ * Equal numbers, booleans, nulls and strings share a single constant pool entry, so
+ * repeated literals don't grow the pool or push indices into the 32-bit Constant32 range.
+ * Matrices are always given their own entry rather than being hashed element-wise.
+ *
  * @class Batch Contains information about a batch of code.
  * @brief Holds the constant pool and bytecode stream for a code batch.
  */
@@ -27,6 +32,7 @@ public:
     std::vector<Op::Code> opcodes;   ///< The bytestream of Op::Codes for this batch.
     std::vector<Value> constantPool; ///< The list of all constants defined in this batch.
     std::vector<int> lines;          ///< Line numbers for all instructions (One line number per instruction).
+    size_t maxStackDepth = 0;        ///< The most values on the stack at once while the batch runs, set by measureStack().
 
     /**
      * Pushes an Op::Code to the back of the bytestream.
@@ -51,13 +57,58 @@ public:
     void addOps(const std::vector<Op::Code>& codes, int lineNum);
 
     /**
-     * Pushes a constant onto the back of the constant pool and returns its index.
+     * Returns the index of an equal constant already in the pool, otherwise pushes
+     * the constant onto the back of the constant pool and returns its index.
      *
      * @brief Adds a constant to the constant pool.
      * @param value The constant to be added to the pool.
      * @return The index of the constant in the pool.
      */
     size_t addConstant(const Value& value);
+
+    /**
+     * Used by the compiler to replace code it has already emitted, such as
+     * when folding constant expressions.
+     *
+     * @brief Removes every Op::Code and constant added after the given counts.
+     * @param opcodeCount The number of Op::Codes to keep.
+     * @param constantCount The number of constants to keep.
+     */
+    void rewind(size_t opcodeCount, size_t constantCount);
+
+    /**
+     * Titan has no jumps, so following each instruction's Op::stackEffect() in order gives
+     * the depth of the stack at every instruction. The VM checks maxStackDepth against its
+     * fixed-size stack once before the batch runs, rather than on every push.
+     *
+     * @brief Sets maxStackDepth to the deepest the stack gets while the batch runs.
+     */
+    void measureStack();
+
+private:
+    /**
+     * @brief Hashes constants by their bits, or by their characters for strings.
+     */
+    struct ConstantHash {
+        size_t operator()(const Value& value) const;
+    };
+
+    /**
+     * Unlike Value::operator==, numbers are compared bit for bit so that
+     * 0 and -0 stay distinct and NaN constants can be shared.
+     *
+     * @brief Tests whether two constants can share a pool entry.
+     */
+    struct ConstantEqual {
+        bool operator()(const Value& lhs, const Value& rhs) const;
+    };
+
+    std::unordered_map<Value, size_t, ConstantHash, ConstantEqual> constantIndices; ///< Pool index of each deduplicated constant.
+
+    /**
+     * @brief Returns true if the constant is looked up in constantIndices.
+     */
+    static bool isDeduplicated(const Value& value);
 };
 
 #endif //TITANPLUSPLUS_BATCH_H
@@ -0,0 +1,374 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "BatchFile.h"
+#include "Builtins.h"
+#include "Memory.h"
+
+namespace {
+const char Magic[4] = {'T', 'T', 'N', 'B'}; ///< First four bytes of every batch file.
+
+/**
+ * @brief The fixed-size header at the start of every batch file.
+ */
+struct Header {
+    char magic[4];        ///< Always Magic.
+    uint32_t version;     ///< BatchFile::Version of the writer.
+    uint32_t opCodeSize;  ///< sizeof(Op::Code) of the writer.
+    uint32_t opCodeCount; ///< Op::Code::SIZE of the writer, changes whenever an op code is added.
+    uint64_t opcodes;     ///< Number of entries in the Op::Code stream.
+    uint64_t constants;   ///< Number of constants in the constant pool.
+    uint64_t globals;     ///< Number of global names.
+};
+
+/**
+ * @brief Writes the raw bytes of a trivially copyable value.
+ */
+template <typename T>
+void write(std::ofstream& stream, const T& value) {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * @brief Writes a length-prefixed string.
+ */
+void writeString(std::ofstream& stream, const std::string& string) {
+    write<uint64_t>(stream, string.size());
+    stream.write(string.data(), (std::streamsize)string.size());
+}
+
+/**
+ * @brief Writes a matrix's width, entry count and raw entries.
+ */
+template <typename T>
+void writeMatrix(std::ofstream& stream, const Matrix<T>& matrix) {
+    write<int32_t>(stream, matrix.getWidth());
+    write<uint64_t>(stream, matrix.size());
+    stream.write(reinterpret_cast<const char*>(matrix.data()), (std::streamsize)(matrix.size() * sizeof(T)));
+}
+
+/**
+ * @brief A bounds-checked cursor over a mapped batch file.
+ */
+class Reader {
+public:
+    explicit Reader(const MappedFile& file) : position(file.data()), end(file.data() + file.size()) {}
+
+    /**
+     * @brief Returns a pointer to the next size bytes and skips over them, or nullptr if the file is too short.
+     */
+    const char* take(size_t size) {
+        if ((size_t)(end - position) < size) return nullptr;
+        const char* bytes = position;
+        position += size;
+        return bytes;
+    }
+
+    /**
+     * @brief Reads a trivially copyable value.
+     */
+    template <typename T>
+    bool read(T& value) {
+        const char* bytes = take(sizeof(T));
+        if (bytes == nullptr) return false;
+        std::memcpy(&value, bytes, sizeof(T));
+        return true;
+    }
+
+    /**
+     * @brief Reads a length-prefixed string, viewing it in place in the mapping.
+     */
+    bool readString(std::string_view& string) {
+        uint64_t length = 0;
+        if (!read(length)) return false;
+        const char* bytes = take(length);
+        if (bytes == nullptr) return false;
+        string = {bytes, length};
+        return true;
+    }
+
+    /**
+     * @brief Reads a matrix written by writeMatrix().
+     */
+    template <typename T>
+    bool readMatrix(Matrix<T>& matrix) {
+        int32_t width = 0;
+        uint64_t entries = 0;
+        if (!read(width) || !read(entries) || width <= 0 || entries % width != 0) return false;
+        const char* bytes = take(entries * sizeof(T));
+        if (bytes == nullptr) return false;
+        matrix = Matrix<T>(width, (int)(entries / width));
+        std::memcpy(matrix.data(), bytes, entries * sizeof(T));
+        return true;
+    }
+
+private:
+    const char* position; ///< The next unread byte.
+    const char* end;      ///< One past the last byte of the file.
+};
+
+/**
+ * @brief Reads one constant written by BatchFile::save().
+ */
+bool readConstant(Reader& reader, Strings& strings, Value& constant) {
+    uint8_t type = 0;
+    if (!reader.read(type)) return false;
+    switch (type) {
+        case Value::Type::BOOL: {
+            uint8_t value = 0;
+            if (!reader.read(value)) return false;
+            constant = Value::fromBool(value != 0);
+            return true;
+        }
+        case Value::Type::NIL: {
+            constant = Value::fromNull();
+            return true;
+        }
+        case Value::Type::NUMBER: {
+            double value = 0;
+            if (!reader.read(value)) return false;
+            constant = Value::fromNumber(value);
+            return true;
+        }
+        case Value::Type::STRING: {
+            std::string_view value;
+            if (!reader.readString(value)) return false;
+            constant = strings.intern(value);
+            return true;
+        }
+        case Value::Type::MATRIXF: {
+            MatrixF value(0, 0);
+            if (!reader.readMatrix(value)) return false;
+            constant = Value::fromMatrixF(std::move(value));
+            return true;
+        }
+        case Value::Type::MATRIXD: {
+            MatrixD value(0, 0);
+            if (!reader.readMatrix(value)) return false;
+            constant = Value::fromMatrixD(std::move(value));
+            return true;
+        }
+        default: return false;
+    }
+}
+
+/**
+ * @brief Returns the index operand of the instruction at index, and writes a new one if newIndex isn't null.
+ */
+size_t instructionOperand(Batch& batch, size_t index, const size_t* newIndex = nullptr) {
+    Op::Code* operands = &batch.opcodes[index + 1];
+    if (Op::instructionLength(batch.opcodes[index]) == 3) {
+        if (newIndex != nullptr) {
+            auto codes = Memory::toOpCodes(*newIndex);
+            operands[0] = codes[0];
+            operands[1] = codes[1];
+        }
+        return Memory::toValue<size_t>(operands[0], operands[1]);
+    }
+    if (newIndex != nullptr) {
+        operands[0] = (Op::Code)*newIndex;
+    }
+    return operands[0];
+}
+
+/**
+ * @brief Checks every instruction's operands are in range and moves global slots to the running VM's slots.
+ */
+bool relocate(Batch& batch, const std::vector<size_t>& slots) {
+    for (size_t index = 0; index < batch.opcodes.size(); index += Op::instructionLength(batch.opcodes[index])) {
+        const Op::Code op = batch.opcodes[index];
+        if (op >= Op::Code::SIZE || index + Op::instructionLength(op) > batch.opcodes.size()) return false;
+
+        switch (op) {
+            case Op::Code::AddConstant:
+            case Op::Code::Constant:
+            case Op::Code::Constant32:
+            case Op::Code::DivideConstant:
+            case Op::Code::MultiplyConstant:
+            case Op::Code::SubtractConstant: {
+                if (instructionOperand(batch, index) >= batch.constantPool.size()) return false;
+                break;
+            }
+            case Op::Code::CallBuiltin: {
+                if ((size_t)batch.opcodes[index + 1] >= Builtins::Function::SIZE) return false;
+                break;
+            }
+            case Op::Code::GetGlobalAddConstant: {
+                //Two short operands, a slot then a constant index.
+                const size_t slot = batch.opcodes[index + 1];
+                if (slot >= slots.size() || batch.opcodes[index + 2] >= batch.constantPool.size()) return false;
+                if (slots[slot] >= 1 << (sizeof(Op::Code) * 8)) return false;
+                batch.opcodes[index + 1] = (Op::Code)slots[slot];
+                break;
+            }
+            case Op::Code::DefineGlobal:
+            case Op::Code::DefineGlobal32:
+            case Op::Code::GetGlobal:
+            case Op::Code::GetGlobal32:
+            case Op::Code::SetGlobal:
+            case Op::Code::SetGlobal32: {
+                const size_t slot = instructionOperand(batch, index);
+                if (slot >= slots.size()) return false;
+                //Short-form operands can't hold a slot that has moved past a single Op::Code.
+                if (Op::instructionLength(op) == 2 && slots[slot] >= 1 << (sizeof(Op::Code) * 8)) return false;
+                instructionOperand(batch, index, &slots[slot]);
+                break;
+            }
+            case Op::Code::GetIndex: {
+                if (batch.opcodes[index + 1] > (Op::Subscript::RowRange | Op::Subscript::ColumnRange)) return false;
+                break;
+            }
+            case Op::Code::SetLocalIndex: {
+                //The slot is checked by checkLocals(), once every instruction is known to be in range.
+                if (batch.opcodes[index + 2] > (Op::Subscript::RowRange | Op::Subscript::ColumnRange)) return false;
+                break;
+            }
+            case Op::Code::SetGlobalIndex:
+            case Op::Code::SetGlobalIndex32: {
+                //A short or wide slot, then the subscript flags.
+                const bool wide = op == Op::Code::SetGlobalIndex32;
+                Op::Code* operands = &batch.opcodes[index + 1];
+                const size_t slot = wide ? Memory::toValue<size_t>(operands[0], operands[1]) : (size_t)operands[0];
+                if (slot >= slots.size() || operands[wide ? 2 : 1] > (Op::Subscript::RowRange | Op::Subscript::ColumnRange)) return false;
+                if (wide) {
+                    auto codes = Memory::toOpCodes(slots[slot]);
+                    operands[0] = codes[0];
+                    operands[1] = codes[1];
+                }
+                else {
+                    if (slots[slot] >= 1 << (sizeof(Op::Code) * 8)) return false;
+                    operands[0] = (Op::Code)slots[slot];
+                }
+                break;
+            }
+            default: break;
+        }
+    }
+    return true;
+}
+
+/**
+ * Titan has no jumps, so the depth of the stack at every instruction is known, see
+ * Batch::measureStack(). The VM and JIT index local slots straight into the stack.
+ *
+ * @brief Checks every local slot is below the operands of the instruction that reads or assigns it.
+ */
+bool checkLocals(const Batch& batch) {
+    size_t depth = 0;
+    for (size_t index = 0; index < batch.opcodes.size(); index += Op::instructionLength(batch.opcodes[index])) {
+        const Op::Code* code = &batch.opcodes[index];
+        const int effect = Op::stackEffect(code);
+        if (code[0] == Op::Code::GetLocal && (size_t)code[1] >= depth) return false;
+        //Assignments pop their operands and leave one value, so they have 1 - effect operands above the local.
+        if ((code[0] == Op::Code::SetLocal || code[0] == Op::Code::SetLocalIndex) && (size_t)code[1] + 1 - effect >= depth) return false;
+        depth += effect;
+    }
+    return true;
+}
+}
+
+bool BatchFile::save(const Batch &batch, const Globals &globals, const std::string &path) {
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream) return false;
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.opCodeSize = sizeof(Op::Code);
+    header.opCodeCount = Op::Code::SIZE;
+    header.opcodes = batch.opcodes.size();
+    header.constants = batch.constantPool.size();
+    header.globals = globals.names.size();
+    write(stream, header);
+
+    stream.write(reinterpret_cast<const char*>(batch.opcodes.data()), (std::streamsize)(batch.opcodes.size() * sizeof(Op::Code)));
+    for (int line : batch.lines) {
+        write<int32_t>(stream, line);
+    }
+    for (const auto& name : globals.names) {
+        writeString(stream, name);
+    }
+    for (const auto& constant : batch.constantPool) {
+        write<uint8_t>(stream, constant.type());
+        switch (constant.type()) {
+            case Value::Type::BOOL:    write<uint8_t>(stream, constant.toType<bool>()); break;
+            case Value::Type::NIL:                                                      break;
+            case Value::Type::NUMBER:  write<double>(stream, constant.toType<double>()); break;
+            case Value::Type::STRING:  writeString(stream, constant.asString());        break;
+            case Value::Type::MATRIXF: writeMatrix(stream, constant.asMatrixF());       break;
+            case Value::Type::MATRIXD: writeMatrix(stream, constant.asMatrixD());       break;
+        }
+    }
+    return (bool)stream;
+}
+
+bool BatchFile::isBatchFile(const MappedFile &file) {
+    return file.size() >= sizeof(Magic) && std::memcmp(file.data(), Magic, sizeof(Magic)) == 0;
+}
+
+bool BatchFile::load(const MappedFile &file, Batch &batch, Globals &globals, Strings &strings) {
+    Reader reader(file);
+    Header header{};
+    if (!isBatchFile(file) || !reader.read(header)) {
+        std::cerr << "Not a compiled Titan batch.\n";
+        return false;
+    }
+    if (header.version != Version || header.opCodeSize != sizeof(Op::Code) || header.opCodeCount != Op::Code::SIZE) {
+        std::cerr << "Compiled batch was written by an incompatible version of Titan, recompile it from source.\n";
+        return false;
+    }
+
+    //Every op code, global name and constant takes at least a byte, so larger counts can only be corrupt, and would overflow the sizes below.
+    if (header.opcodes > file.size() || header.globals > file.size() || header.constants > file.size()) {
+        std::cerr << "Compiled batch is truncated.\n";
+        return false;
+    }
+
+    //Op codes and lines are copied in bulk straight out of the mapping.
+    const char* opcodes = reader.take(header.opcodes * sizeof(Op::Code));
+    const char* lines = reader.take(header.opcodes * sizeof(int32_t));
+    if (opcodes == nullptr || lines == nullptr) {
+        std::cerr << "Compiled batch is truncated.\n";
+        return false;
+    }
+    batch.opcodes.resize(header.opcodes);
+    std::memcpy(batch.opcodes.data(), opcodes, header.opcodes * sizeof(Op::Code));
+    batch.lines.resize(header.opcodes);
+    for (size_t i = 0; i < header.opcodes; ++i) {
+        int32_t line = 0;
+        std::memcpy(&line, lines + i * sizeof(int32_t), sizeof(int32_t));
+        batch.lines[i] = line;
+    }
+
+    std::vector<size_t> slots;
+    slots.reserve(header.globals);
+    for (uint64_t i = 0; i < header.globals; ++i) {
+        std::string_view name;
+        if (!reader.readString(name)) {
+            std::cerr << "Compiled batch is truncated.\n";
+            return false;
+        }
+        slots.push_back(globals.resolve(name));
+    }
+
+    batch.constantPool.reserve(header.constants);
+    for (uint64_t i = 0; i < header.constants; ++i) {
+        Value constant;
+        if (!readConstant(reader, strings, constant)) {
+            std::cerr << "Compiled batch has a corrupt constant pool.\n";
+            return false;
+        }
+        batch.constantPool.push_back(std::move(constant));
+    }
+
+    if (batch.opcodes.empty() || batch.opcodes.back() != Op::Code::Return || !relocate(batch, slots) || !checkLocals(batch)) {
+        std::cerr << "Compiled batch has corrupt instructions.\n";
+        return false;
+    }
+    batch.measureStack();
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef TITANPLUSPLUS_BATCHFILE_H
+#define TITANPLUSPLUS_BATCHFILE_H
+
+/**
+ * @file BatchFile.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains the BatchFile class, which saves and loads compiled batches.
+ */
+
+#include <cstdint>
+#include <string>
+#include "Batch.h"
+#include "Globals.h"
+#include "Strings.h"
+#include "MappedFile.h"
+
+/**
+ * Compiled batches are written in a versioned binary format so they can be run
+ * again without scanning or compiling the source. All fields are stored in the
+ * host's native byte order:
+ *
+ * | Field         | Contents                                                          |
+ * |---------------|-------------------------------------------------------------------|
+ * | Header        | Magic "TTNB", format Version, Op::Code size and Op::Code::SIZE    |
+ * | Counts        | uint64 op code, constant and global name counts                   |
+ * | Op codes      | The raw Op::Code stream                                           |
+ * | Lines         | One int32 line number per Op::Code                                |
+ * | Global names  | uint64 length and bytes of each global name, in slot order        |
+ * | Constants     | uint8 Value::Type followed by the value's payload                 |
+ *
+ * Global variable instructions refer to slots in the compiling VM's Globals table.
+ * Loading resolves every stored name in the running VM's table and rewrites the
+ * operands of any instruction whose slot has moved. The batch's Batch::maxStackDepth
+ * isn't stored, it is measured again once the batch is loaded.
+ *
+ * @class BatchFile
+ * @brief Saves and loads compiled batches.
+ */
+struct BatchFile {
+    static const uint32_t Version = 2; ///< Bump whenever the layout of the format changes.
+
+    /**
+     * @brief Writes a compiled batch to a file.
+     * @param batch The batch to save.
+     * @param globals The Globals table the batch was compiled against.
+     * @param path The path of the file to write.
+     * @return True if the file was written, otherwise false.
+     */
+    static bool save(const Batch& batch, const Globals& globals, const std::string& path);
+
+    /**
+     * @brief Tests whether a mapped file starts with the batch file magic.
+     * @param file The mapped file to test.
+     * @return True if the file looks like a compiled batch, otherwise false.
+     */
+    static bool isBatchFile(const MappedFile& file);
+
+    /**
+     * Reads a batch straight out of a memory-mapped file. Prints an error
+     * and returns false if the file is truncated, corrupt, or was written by
+     * an incompatible version of Titan.
+     *
+     * @brief Loads a compiled batch from a mapped file.
+     * @param file The mapped batch file.
+     * @param batch The batch to load into, should be empty.
+     * @param globals The Globals table to resolve the batch's global names in.
+     * @param strings The Strings table to intern the batch's string constants in.
+     * @return True if the batch was loaded, otherwise false.
+     */
+    static bool load(const MappedFile& file, Batch& batch, Globals& globals, Strings& strings);
+};
+
+#endif //TITANPLUSPLUS_BATCHFILE_H
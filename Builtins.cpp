@@ -0,0 +1,99 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#include <stdexcept>
+#include <string>
+#include "Builtins.h"
+#include "MatrixFile.h"
+
+namespace {
+/**
+ * @brief The name and arity of a built-in.
+ */
+struct Signature {
+    std::string_view name; ///< The name the built-in is called by.
+    int arity;             ///< The number of arguments it takes.
+};
+
+///Signatures indexed by Builtins::Function, so in the order of their names.
+const Signature Signatures[] = {
+    {"dot", 2}, {"frobenius", 1}, {"load", 1}, {"max", 1}, {"mean", 1}, {"min", 1}, {"norm1", 1}, {"norm2", 1},
+    {"save", 2}, {"sum", 1},
+};
+static_assert(sizeof(Signatures) / sizeof(Signatures[0]) == Builtins::Function::SIZE, "Signatures is missing built-ins.");
+
+/**
+ * @brief Calls a built-in that reduces a single matrix.
+ */
+template <typename T>
+double reduce(Builtins::Function function, const MatrixView<T>& matrix) {
+    switch (function) {
+        case Builtins::Function::Max:   return matrix.max();
+        case Builtins::Function::Mean:  return matrix.mean();
+        case Builtins::Function::Min:   return matrix.min();
+        case Builtins::Function::Norm1: return matrix.norm1();
+        case Builtins::Function::Frobenius:
+        case Builtins::Function::Norm2: return matrix.norm2();
+        default:                        return matrix.sum();
+    }
+}
+}
+
+Builtins::Function Builtins::find(std::string_view name) {
+    for (int function = 0; function < Function::SIZE; ++function) {
+        if (Signatures[function].name == name) return (Function)function;
+    }
+    return Function::SIZE;
+}
+
+std::string_view Builtins::name(Builtins::Function function) {
+    return Signatures[function].name;
+}
+
+int Builtins::arity(Builtins::Function function) {
+    return Signatures[function].arity;
+}
+
+Value Builtins::call(Builtins::Function function, const Value* arguments) {
+    const Value& a = arguments[0];
+    if (function == Function::Dot) {
+        const Value& b = arguments[1];
+        if (a.type() == Value::Type::MATRIXF && b.type() == Value::Type::MATRIXF) {
+            return Value::fromNumber(a.asExpressionF().view().dot(b.asExpressionF().view()));
+        }
+        if (a.type() == Value::Type::MATRIXD && b.type() == Value::Type::MATRIXD) {
+            return Value::fromNumber(a.asExpressionD().view().dot(b.asExpressionD().view()));
+        }
+        throw std::invalid_argument("dot() expects two matrices of the same precision.");
+    }
+    if (function == Function::Load) {
+        if (a.type() != Value::Type::STRING) throw std::invalid_argument("load() expects a path.");
+        MappedFile file;
+        if (!file.open(a.asString(), MappedFile::Access::CopyOnWrite)) {
+            throw std::invalid_argument("Cannot open matrix file '" + a.asString() + "'.");
+        }
+        if (MatrixFile::element(file) == MatrixFile::Element::Float) {
+            return Value::fromMatrixF(MatrixFile::load<float>(std::move(file)));
+        }
+        return Value::fromMatrixD(MatrixFile::load<double>(std::move(file)));
+    }
+    if (function == Function::Save) {
+        const Value& path = arguments[1];
+        if (path.type() != Value::Type::STRING) throw std::invalid_argument("save() expects a matrix and a path.");
+        bool saved;
+        switch (a.type()) {
+            case Value::Type::MATRIXF: saved = MatrixWriter<float>::save(a.asExpressionF().view(), path.asString());  break;
+            case Value::Type::MATRIXD: saved = MatrixWriter<double>::save(a.asExpressionD().view(), path.asString()); break;
+            default: throw std::invalid_argument("save() expects a matrix and a path.");
+        }
+        if (!saved) throw std::invalid_argument("Cannot write matrix file '" + path.asString() + "'.");
+        return Value::fromNull();
+    }
+
+    switch (a.type()) {
+        case Value::Type::MATRIXF: return Value::fromNumber(reduce(function, a.asExpressionF().view()));
+        case Value::Type::MATRIXD: return Value::fromNumber(reduce(function, a.asExpressionD().view()));
+        default: throw std::invalid_argument(std::string(name(function)) + "() expects a matrix.");
+    }
+}
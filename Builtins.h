@@ -0,0 +1,67 @@
+#ifndef TITANPLUSPLUS_BUILTINS_H
+#define TITANPLUSPLUS_BUILTINS_H
+
+/**
+ * @file Builtins.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains the functions built into Titan.
+ */
+
+#include <cstdint>
+#include <string_view>
+#include "Value.h"
+
+/**
+ * Titan has no user-defined functions yet, so a call is always to a built-in. The compiler
+ * resolves the name of the callee while compiling and emits Op::CallBuiltin with the
+ * function as its operand, so calls cost no lookup at runtime.
+ *
+ * Most built-ins reduce a matrix to a number with MatrixBackend::reduce(), so they run as
+ * parallel reductions on the CPU or GPU instead of as loops in Titan code. load() and save()
+ * read and write matrix files, see MatrixFile.
+ */
+namespace Builtins {
+///Functions built into Titan, in the order of their names.
+enum Function : uint16_t {
+    Dot,       ///< dot(a, b), the sum of the products of the entries of two matrices.
+    Frobenius, ///< frobenius(m), the Frobenius norm of a matrix, the same as norm2(m).
+    Load,      ///< load(path), the matrix in a matrix file, memory-mapped rather than parsed.
+    Max,       ///< max(m), the largest entry of a matrix.
+    Mean,      ///< mean(m), the mean of the entries of a matrix.
+    Min,       ///< min(m), the smallest entry of a matrix.
+    Norm1,     ///< norm1(m), the sum of the absolute values of the entries of a matrix.
+    Norm2,     ///< norm2(m), the square root of the sum of the squares of the entries of a matrix.
+    Save,      ///< save(m, path), writes a matrix to a matrix file and returns null.
+    Sum,       ///< sum(m), the sum of the entries of a matrix.
+
+    //Number of built-ins (Must be last)
+    SIZE,
+};
+
+/**
+ * @brief Returns the built-in with the given name, or Function::SIZE if there isn't one.
+ */
+Function find(std::string_view name);
+
+/**
+ * @brief Returns the name a built-in is called by in Titan code.
+ */
+std::string_view name(Function function);
+
+/**
+ * @brief Returns the number of arguments a built-in takes.
+ */
+int arity(Function function);
+
+/**
+ * @brief Calls a built-in.
+ * @param function The built-in to call.
+ * @param arguments Pointer to the first of arity(function) arguments.
+ * @return The result of the call.
+ * @throws std::invalid_argument If the arguments have the wrong types or dimensions, or a file can't be read or written.
+ */
+Value call(Function function, const Value* arguments);
+}
+
+#endif //TITANPLUSPLUS_BUILTINS_H
@@ -1,3 +1,5 @@
+#include <charconv>
+#include <stdexcept>
 #include "Compiler.h"
 
 Compiler::Compiler() {
@@ -5,6 +7,9 @@ Compiler::Compiler() {
     parseRules[Token::Type::RIGHT_PAREN]   = {nullptr,     nullptr,   Precedence::NONE};
     parseRules[Token::Type::LEFT_BRACE]    = {nullptr,     nullptr,   Precedence::NONE};
     parseRules[Token::Type::RIGHT_BRACE]   = {nullptr,     nullptr,   Precedence::NONE};
+    parseRules[Token::Type::LEFT_BRACKET]  = {nullptr,     [this] { index(); },     Precedence::CALL};
+    parseRules[Token::Type::RIGHT_BRACKET] = {nullptr,     nullptr,   Precedence::NONE};
+    parseRules[Token::Type::COLON]         = {nullptr,     nullptr,   Precedence::NONE};
     parseRules[Token::Type::COMMA]         = {nullptr,     nullptr,   Precedence::NONE};
     parseRules[Token::Type::DOT]           = {nullptr,     nullptr,   Precedence::NONE};
     parseRules[Token::Type::MINUS]         = {[this] { unary(); },  [this] { binary(); },    Precedence::TERM};
@@ -44,9 +49,11 @@ Compiler::Compiler() {
     parseRules[Token::Type::END_OF_FILE]   = {nullptr,     nullptr,   Precedence::NONE};
 }
 
-bool Compiler::compile(const std::string &titanCode, Batch& batch) {
+bool Compiler::compile(std::string_view titanCode, Batch& batch, Globals& globalTable, Strings& stringTable) {
     titanSourceCode = titanCode;
     currentBatch = &batch;
+    globals = &globalTable;
+    strings = &stringTable;
     scanner.init(titanCode);
 
     advance();
@@ -56,11 +63,10 @@ bool Compiler::compile(const std::string &titanCode, Batch& batch) {
     }
 
     emitOp(Op::Code::Return);
-#ifdef DEBUG_PRINT_CODE
     if (!parser.hadError) {
-        Debug::disassembleBatch(batch);
+        Optimiser::optimise(batch);
+        batch.measureStack();
     }
-#endif //DEBUG_PRINT_CODE
     return !parser.hadError;
 }
 
@@ -80,7 +86,7 @@ void Compiler::advance() {
     }
 }
 
-void Compiler::error(Token &token, const std::string &message) {
+void Compiler::error(Token &token, std::string_view message) {
     if (parser.panicMode) return;
     parser.panicMode = true;
     std::cerr << "[Line " << token.line << "] Error";
@@ -88,14 +94,14 @@ void Compiler::error(Token &token, const std::string &message) {
     switch (token.type) {
         case Token::Type::END_OF_FILE: std::cerr << " at end";                                     break;
         case Token::Type::ERROR:                                                                   break;
-        default: std::cerr << " at '" << titanSourceCode.substr(token.start, token.length) << "'"; break;
+        default: std::cerr << " at '" << token.text(titanSourceCode) << "'";                     break;
     }
 
     std::cerr << ": " << message << "\n";
     parser.hadError = true;
 }
 
-void Compiler::consume(Token::Type tokenType, const std::string &message) {
+void Compiler::consume(Token::Type tokenType, std::string_view message) {
     if (parser.current.type == tokenType) {
         advance();
         return;
@@ -112,13 +118,31 @@ void Compiler::emitOps(Op::Code a, Op::Code b) {
     emitOp(b);
 }
 
+void Compiler::emitIndexedOp(Op::Code op, Op::Code op32, size_t index, std::string_view errorMessage) {
+    if (index == (size_t)-1 || index > UINT32_MAX) {
+        error(parser.previous, errorMessage);
+    }
+    else if (index >= 1 << (sizeof(Op::Code) * 8)) {
+        emitOp(op32);
+        auto indexAsOpCodes = Memory::toOpCodes(index);
+        emitOps(indexAsOpCodes[0], indexAsOpCodes[1]);
+    }
+    else {
+        emitOp(op);
+        emitOp((Op::Code)index);
+    }
+}
+
 void Compiler::expression() {
     parsePrecedence(Precedence::ASSIGNMENT);
 }
 
 void Compiler::number() {
-    double value = strtod(&titanSourceCode[parser.previous.start], nullptr);
-    emitConstant(Value::fromNumber(value));
+    const std::string_view text = parser.previous.text(titanSourceCode);
+    double value = 0;
+    //Unlike strtod, from_chars stops at the end of the token rather than needing a terminated string.
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    emitLiteral(Value::fromNumber(value));
 }
 
 void Compiler::grouping() {
@@ -131,6 +155,9 @@ void Compiler::unary() {
 
     parsePrecedence(Precedence::UNARY);
 
+    auto operand = literalEndingAt(currentBatch->opcodes.size());
+    if (operand && foldUnary(operatorType, *operand)) return;
+
     switch (operatorType) {
         case Token::Type::BANG:  emitOp(Op::Code::Not);    break;
         case Token::Type::MINUS: emitOp(Op::Code::Negate); break;
@@ -141,8 +168,12 @@ void Compiler::unary() {
 void Compiler::binary() {
     Token::Type operatorType = parser.previous.type;
     ParseRule* rule = getRule(operatorType);
+    auto lhs = literalEndingAt(currentBatch->opcodes.size());
     parsePrecedence((Precedence)(rule->precedence + 1));
 
+    auto rhs = literalEndingAt(currentBatch->opcodes.size());
+    if (lhs && rhs && rhs->start == lhs->end && foldBinary(operatorType, *lhs, *rhs)) return;
+
     switch (operatorType) {
         case Token::BANG_EQUAL:    emitOp(Op::Code::NotEqual);     break;
         case Token::EQUAL_EQUAL:   emitOp(Op::Code::Equal);        break;
@@ -160,20 +191,24 @@ void Compiler::binary() {
 
 void Compiler::literal() {
     switch (parser.previous.type) {
-        case Token::FALSE: emitOp(Op::Code::False); break;
-        case Token::NIL:   emitOp(Op::Code::Null);  break;
-        case Token::TRUE:  emitOp(Op::Code::True);  break;
+        case Token::FALSE: emitLiteral(Value::fromBool(false)); break;
+        case Token::NIL:   emitLiteral(Value::fromNull());      break;
+        case Token::TRUE:  emitLiteral(Value::fromBool(true));  break;
         default: break;
     }
 }
 
 void Compiler::string() {
-    emitConstant(Value::fromString(titanSourceCode.substr(parser.previous.start + 1, parser.previous.length - 2)));
+    emitLiteral(strings->intern(titanSourceCode.substr(parser.previous.start + 1, parser.previous.length - 2)));
 }
 
 void Compiler::matrix() {
-   // std::cout << "Matrix: '" << titanSourceCode.substr(parser.previous.start + 1, parser.previous.length - 1) << "'\n";
-    emitConstant(Value::fromMatrixD(MatrixD(titanSourceCode.substr(parser.previous.start + 1, parser.previous.length - 2))));
+    try {
+        emitConstant(Value::fromMatrixD(MatrixD(titanSourceCode.substr(parser.previous.start + 1, parser.previous.length - 2))));
+    }
+    catch (const std::invalid_argument& exception) {
+        error(parser.previous, exception.what());
+    }
 }
 
 void Compiler::declaration() {
@@ -195,11 +230,35 @@ void Compiler::statement() {
         consume(Token::Type::SEMICOLON, "Expect ';' after value.");
         emitOp(Op::Print);
     }
+    else if (matchType(Token::Type::LEFT_BRACE)) {
+        beginScope();
+        block();
+        endScope();
+    }
     else {
         expressionStatement();
     }
 }
 
+void Compiler::block() {
+    while (parser.current.type != Token::Type::RIGHT_BRACE && parser.current.type != Token::Type::END_OF_FILE) {
+        declaration();
+    }
+    consume(Token::Type::RIGHT_BRACE, "Expect '}' after block.");
+}
+
+void Compiler::beginScope() {
+    ++scopeDepth;
+}
+
+void Compiler::endScope() {
+    --scopeDepth;
+    while (!locals.empty() && (locals.back().depth == -1 || locals.back().depth > scopeDepth)) {
+        emitOp(Op::Code::Pop);
+        locals.pop_back();
+    }
+}
+
 void Compiler::expressionStatement() {
     expression();
     consume(Token::Type::SEMICOLON, "Expect ';' after expression.");
@@ -207,7 +266,7 @@ void Compiler::expressionStatement() {
 }
 
 void Compiler::variableDeclaration() {
-    size_t globalNameIndex = parseVariable("Expect variable name.");
+    size_t globalSlot = parseVariable("Expect variable name.");
 
     if (matchType(Token::Type::EQUAL)) {
         expression();
@@ -217,32 +276,143 @@ void Compiler::variableDeclaration() {
     }
     consume(Token::Type::SEMICOLON, "Expect ';' after variable declaration.");
 
-   // emitGlobalVariable(Value::fromString(titanSourceCode.substr(parser.previous.start, parser.previous.length - 1)));
-
-    defineVariable(globalNameIndex);
+    defineVariable(globalSlot);
 }
 
 void Compiler::variable() {
+    //Titan only has built-in functions, so a name followed by '(' is a call to one.
+    if (parser.current.type == Token::Type::LEFT_PAREN) {
+        call(parser.previous);
+        return;
+    }
     namedVariable(parser.previous);
 }
 
-void Compiler::namedVariable(const Token &token) {
-    size_t arg = identifierConstant(token);
+void Compiler::call(Token callee) {
+    const Builtins::Function function = Builtins::find(callee.text(titanSourceCode));
+    consume(Token::Type::LEFT_PAREN, "Expect '(' after function name.");
 
-    //Define Global
-    if (arg == (size_t)-1) {
-        error(parser.previous, "Error defining global variable: Out of 32-bit address space.");
+    int argumentCount = 0;
+    if (parser.current.type != Token::Type::RIGHT_PAREN) {
+        do {
+            expression();
+            ++argumentCount;
+        } while (matchType(Token::Type::COMMA));
     }
-    else if (arg >= 1 << (sizeof(Op::Code) * 8)) {
-        emitOp(Op::Code::GetGlobal32);
-        auto indexAsOpCodes = Memory::toOpCodes(arg);
-        emitOps(indexAsOpCodes[0], indexAsOpCodes[1]);
+    consume(Token::Type::RIGHT_PAREN, "Expect ')' after arguments.");
+
+    if (function == Builtins::Function::SIZE) {
+        error(callee, "Undefined function.");
+    }
+    else if (argumentCount != Builtins::arity(function)) {
+        error(callee, "Expect " + std::to_string(Builtins::arity(function)) + " argument" + (Builtins::arity(function) == 1 ? "" : "s") + ".");
+    }
+    else {
+        emitOps(Op::Code::CallBuiltin, (Op::Code)function);
+    }
+}
+
+void Compiler::index() {
+    const bool assignable = canAssign;
+    //Only a subscript applied directly to a variable can be assigned to.
+    std::optional<VariableLoad> target;
+    if (lastVariable && lastVariable->end == currentBatch->opcodes.size()) target = lastVariable;
+
+    uint16_t flags = 0;
+    if (subscriptDimension()) flags |= Op::Subscript::RowRange;
+    if (matchType(Token::Type::COMMA)) {
+        if (subscriptDimension()) flags |= Op::Subscript::ColumnRange;
     }
     else {
-        emitOp(Op::Code::GetGlobal);
-        emitOp((Op::Code)arg);
+        //A single dimension selects whole rows.
+        emitOps(Op::Code::Null, Op::Code::Null);
+        flags |= Op::Subscript::ColumnRange;
+    }
+    consume(Token::Type::RIGHT_BRACKET, "Expect ']' after subscript.");
+
+    if (assignable && target && matchType(Token::Type::EQUAL)) {
+        expression();
+        if (target->local) {
+            emitOps(Op::Code::SetLocalIndex, (Op::Code)target->slot);
+        }
+        else {
+            emitIndexedOp(Op::Code::SetGlobalIndex, Op::Code::SetGlobalIndex32, target->slot, "Error assigning to global variable: Out of 32-bit address space.");
+        }
+        emitOp((Op::Code)flags);
+        return;
     }
-    //emitGlobalVariable(Value::fromString(titanSourceCode.substr(token.start, token.length)), false);
+    emitOps(Op::Code::GetIndex, (Op::Code)flags);
+}
+
+bool Compiler::subscriptDimension() {
+    //Bounds left out of a range are pushed as null.
+    if (parser.current.type == Token::Type::COLON) {
+        emitOp(Op::Code::Null);
+    }
+    else {
+        expression();
+        if (parser.current.type != Token::Type::COLON) return false;
+    }
+    consume(Token::Type::COLON, "Expect ':' in range.");
+
+    if (parser.current.type == Token::Type::COMMA || parser.current.type == Token::Type::RIGHT_BRACKET) {
+        emitOp(Op::Code::Null);
+    }
+    else {
+        expression();
+    }
+    return true;
+}
+
+void Compiler::namedVariable(const Token &token) {
+    const bool assignable = canAssign;
+    const int local = resolveLocal(token);
+    if (local >= 0) {
+        if (assignable && matchType(Token::Type::EQUAL)) {
+            expression();
+            emitOps(Op::Code::SetLocal, (Op::Code)local);
+            return;
+        }
+        emitOps(Op::Code::GetLocal, (Op::Code)local);
+        lastVariable = VariableLoad{currentBatch->opcodes.size(), (size_t)local, true};
+        return;
+    }
+
+    const size_t slot = identifierSlot(token);
+    if (assignable && matchType(Token::Type::EQUAL)) {
+        expression();
+        emitIndexedOp(Op::Code::SetGlobal, Op::Code::SetGlobal32, slot, "Error assigning to global variable: Out of 32-bit address space.");
+        return;
+    }
+    emitIndexedOp(Op::Code::GetGlobal, Op::Code::GetGlobal32, slot, "Error reading global variable: Out of 32-bit address space.");
+    lastVariable = VariableLoad{currentBatch->opcodes.size(), slot, false};
+}
+
+int Compiler::resolveLocal(const Token &token) {
+    const std::string_view name = token.text(titanSourceCode);
+    for (int slot = (int)locals.size() - 1; slot >= 0; --slot) {
+        if (locals[slot].name != name) continue;
+        if (locals[slot].depth == -1) {
+            error(parser.previous, "Can't read local variable in its own initialiser.");
+        }
+        return slot;
+    }
+    return -1;
+}
+
+void Compiler::declareLocal(const Token &token) {
+    const std::string_view name = token.text(titanSourceCode);
+    for (auto local = locals.rbegin(); local != locals.rend() && (local->depth == -1 || local->depth >= scopeDepth); ++local) {
+        if (local->name == name) {
+            error(parser.previous, "Already a variable with this name in this scope.");
+            return;
+        }
+    }
+    if (locals.size() >= MaxLocals) {
+        error(parser.previous, "Too many local variables in scope.");
+        return;
+    }
+    locals.push_back(Local{name, -1});
 }
 
 void Compiler::synchronise() {
@@ -275,56 +445,123 @@ void Compiler::parsePrecedence(Compiler::Precedence precedence) {
         error(parser.previous, "Expect expression.");
         return;
     }
+    //Assignments bind loosest, so only an expression parsed at that precedence can be a target.
+    const bool assignable = precedence <= Precedence::ASSIGNMENT;
+    canAssign = assignable;
     prefixRule();
 
     while (precedence <= getRule(parser.current.type)->precedence) {
         advance();
         ParseFunction infixRule = getRule(parser.previous.type)->infix;
+        canAssign = assignable;
         infixRule();
     }
+
+    if (assignable && matchType(Token::Type::EQUAL)) {
+        error(parser.previous, "Invalid assignment target.");
+    }
 }
 
-size_t Compiler::parseVariable(const std::string &errorMessage) {
+size_t Compiler::parseVariable(std::string_view errorMessage) {
     consume(Token::Type::IDENTIFIER, errorMessage);
-    return identifierConstant(parser.previous);
+    if (scopeDepth > 0) {
+        declareLocal(parser.previous);
+        return 0;
+    }
+    return identifierSlot(parser.previous);
 }
 
-size_t Compiler::identifierConstant(const Token &token) {
-    return emitConstant(Value::fromString(titanSourceCode.substr(token.start, token.length)));
+size_t Compiler::identifierSlot(const Token &token) {
+    return globals->resolve(token.text(titanSourceCode));
 }
 
 void Compiler::defineVariable(size_t global) {
-    if (global == (size_t)-1) {
-        error(parser.previous, "Error defining global variable: Out of 32-bit address space.");
-    }
-    else if (global >= 1 << (sizeof(Op::Code) * 8)) {
-        emitOp(Op::Code::DefineGlobal32);
-        auto indexAsOpCodes = Memory::toOpCodes(global);
-        emitOps(indexAsOpCodes[0], indexAsOpCodes[1]);
-    }
-    else {
-        emitOp(Op::Code::DefineGlobal);
-        emitOp((Op::Code)global);
+    if (scopeDepth > 0) {
+        if (!locals.empty()) locals.back().depth = scopeDepth;
+        return;
     }
+    emitIndexedOp(Op::Code::DefineGlobal, Op::Code::DefineGlobal32, global, "Error defining global variable: Out of 32-bit address space.");
 }
 
 size_t Compiler::emitConstant(const Value& value) {
     //Gets the current index in the constant pool.
     size_t constantIndex = currentBatch->addConstant(value);
     //If the current index won't fit in the address space of a single Op::Code, use a 32-bit address.
-    if (constantIndex == (size_t)-1) {
-        error(parser.previous, "Error adding new constant: Out of 32-bit address space.");
+    emitIndexedOp(Op::Code::Constant, Op::Code::Constant32, constantIndex, "Error adding new constant: Out of 32-bit address space.");
+    return constantIndex;
+}
+
+void Compiler::emitLiteral(const Value& value) {
+    Literal literal{currentBatch->opcodes.size(), 0, currentBatch->constantPool.size(), value};
+    switch (value.type()) {
+        case Value::Type::BOOL: emitOp(value.toType<bool>() ? Op::Code::True : Op::Code::False); break;
+        case Value::Type::NIL:  emitOp(Op::Code::Null);                                          break;
+        default:                emitConstant(value);                                             break;
     }
-    else if (constantIndex >= 1 << (sizeof(Op::Code) * 8)) {
-        emitOp(Op::Code::Constant32);
-        auto indexAsOpCodes = Memory::toOpCodes(constantIndex);
-        emitOps(indexAsOpCodes[0], indexAsOpCodes[1]);
+    literal.end = currentBatch->opcodes.size();
+    lastLiteral = std::move(literal);
+}
+
+std::optional<Compiler::Literal> Compiler::literalEndingAt(size_t end) const {
+    if (lastLiteral && lastLiteral->end == end) return lastLiteral;
+    return std::nullopt;
+}
+
+bool Compiler::foldUnary(Token::Type operatorType, const Literal& operand) {
+    Value result;
+    switch (operatorType) {
+        case Token::Type::BANG: {
+            result = Value::fromBool(operand.value.isFalsey());
+            break;
+        }
+        case Token::Type::MINUS: {
+            if (!operand.value.isNumber()) return false;
+            result = Value::fromNumber(-operand.value.toType<double>());
+            break;
+        }
+        default: return false;
+    }
+
+    currentBatch->rewind(operand.start, operand.constantCount);
+    emitLiteral(result);
+    return true;
+}
+
+bool Compiler::foldBinary(Token::Type operatorType, const Literal& lhs, const Literal& rhs) {
+    const Value& a = lhs.value;
+    const Value& b = rhs.value;
+    Value result;
+
+    if (operatorType == Token::EQUAL_EQUAL || operatorType == Token::BANG_EQUAL) {
+        //Matrix equality is left to the VM rather than run element-wise during compilation.
+        if (a.type() == Value::Type::MATRIXF || a.type() == Value::Type::MATRIXD) return false;
+        result = Value::fromBool((a == b) == (operatorType == Token::EQUAL_EQUAL));
+    }
+    else if (a.isNumber() && b.isNumber()) {
+        const double x = a.toType<double>();
+        const double y = b.toType<double>();
+        switch (operatorType) {
+            case Token::GREATER:       result = Value::fromBool(x > y);    break;
+            case Token::GREATER_EQUAL: result = Value::fromBool(x >= y);   break;
+            case Token::LESS:          result = Value::fromBool(x < y);    break;
+            case Token::LESS_EQUAL:    result = Value::fromBool(x <= y);   break;
+            case Token::PLUS:          result = Value::fromNumber(x + y);  break;
+            case Token::MINUS:         result = Value::fromNumber(x - y);  break;
+            case Token::STAR:          result = Value::fromNumber(x * y);  break;
+            case Token::SLASH:         result = Value::fromNumber(x / y);  break;
+            default: return false;
+        }
+    }
+    else if (operatorType == Token::PLUS && a.type() == Value::Type::STRING && b.type() == Value::Type::STRING) {
+        result = strings->intern(a.asString() + b.asString());
     }
     else {
-        emitOp(Op::Code::Constant);
-        emitOp((Op::Code)constantIndex);
+        return false;
     }
-    return constantIndex;
+
+    currentBatch->rewind(lhs.start, lhs.constantCount);
+    emitLiteral(result);
+    return true;
 }
 
 bool Compiler::matchType(Token::Type type) {
@@ -9,19 +9,22 @@
  */
 
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <cstdlib>
 #include <functional>
+#include <optional>
 #include <vector>
 #include "Batch.h"
+#include "Builtins.h"
+#include "Optimiser.h"
 #include "Token.h"
 #include "Scanner.h"
 #include "Parser.h"
 #include "Memory.h"
 #include "Debug.h"
-
-//Enable logging of batch contents.
-#define DEBUG_PRINT_CODE
+#include "Globals.h"
+#include "Strings.h"
 
 /**
  * @class Compiler
@@ -39,11 +42,13 @@ public:
      *  to be interpreted by the VM.
      *
      * @brief Compiles a string of Titan source code.
-     * @param titanCode A string containing Titan source code.
+     * @param titanCode A view of Titan source code, must outlive the call.
      * @param batch The batch to compile the bytecode into.
+     * @param globalTable The table global variable names are resolved to slots in.
+     * @param stringTable The table string constants are interned in.
      * @return True if no compilation errors were found, otherwise false.
      */
-    bool compile(const std::string& titanCode, Batch& batch);
+    bool compile(std::string_view titanCode, Batch& batch, Globals& globalTable, Strings& stringTable);
 protected:
     ///Ordering of precedence values for parsing.
     enum Precedence {
@@ -68,11 +73,51 @@ protected:
         Compiler::Precedence precedence;     ///< Precedence for parsing behaviour.
     };
 
-    std::string titanSourceCode;             ///< A copy of the source code we're compiling.
+    /**
+     * A literal whose value is known at compile time, and the span of
+     * the current batch its load instruction occupies.
+     */
+    struct Literal {
+        size_t start;             ///< Index of the literal's first Op::Code.
+        size_t end;               ///< Index one past the literal's last Op::Code.
+        size_t constantCount;     ///< Size of the constant pool before the literal was emitted.
+        Value value;              ///< The literal's value.
+    };
+
+    /**
+     * A load of a variable, and where it ends in the current batch, so that a
+     * subscript applied to it can become an assignment.
+     */
+    struct VariableLoad {
+        size_t end;               ///< Index one past the load's last Op::Code.
+        size_t slot;              ///< The global or stack slot loaded.
+        bool local;               ///< True if slot is the stack slot of a local, false if it is a global slot.
+    };
+
+    /**
+     * A variable declared inside a block. Locals live in value stack slots, in the
+     * order they are declared, until the end of their block.
+     */
+    struct Local {
+        std::string_view name;    ///< The variable's name.
+        int depth;                ///< The scope depth of the block declaring it, or -1 until its initialiser has been compiled.
+    };
+
+    ///The number of locals that can be in scope at once, as many as a single Op::Code can index.
+    static constexpr size_t MaxLocals = 1 << (sizeof(Op::Code) * 8);
+
+    std::string_view titanSourceCode;        ///< A view of the source code we're compiling.
     Scanner scanner;                         ///< Scans tokens from source code during compilation.
     Parser parser;                           ///< Parses tokens produced by the scanner.
     Batch* currentBatch = nullptr;           ///< Current batch being compiled.
+    Globals* globals = nullptr;              ///< Global variable slots shared with the VM.
+    Strings* strings = nullptr;              ///< Interned strings shared with the VM.
     ParseRule parseRules[Token::Type::SIZE]; ///< List of parsing rules indexed by token type.
+    std::optional<Literal> lastLiteral;      ///< The most recently emitted literal, for constant folding.
+    std::optional<VariableLoad> lastVariable; ///< The most recently emitted variable load, for assignments to subscripts.
+    std::vector<Local> locals;               ///< The locals in scope, indexed by stack slot.
+    int scopeDepth = 0;                      ///< The number of blocks enclosing the code being compiled, 0 at the top level.
+    bool canAssign = false;                  ///< True if the expression being parsed may be the target of an assignment.
 
     /**
      * @brief Returns a pointer to the parsing rule associated with the given token type.
@@ -91,14 +136,14 @@ protected:
      * @param token The token that caused the compilation error.
      * @param message The error message to be disaplayed.
      */
-    void error(Token& token, const std::string& message);
+    void error(Token& token, std::string_view message);
 
     /**
      * @brief Tries to consume a token of the expected type from the source, reports an error if it can't.
      * @param tokenType The expected type of token to consume.
      * @param message An error message to display is the next token isn't of the expected type.
      */
-    void consume(Token::Type tokenType, const std::string& message);
+    void consume(Token::Type tokenType, std::string_view message);
 
     /**
      * @brief Writes an Op to the current batch.
@@ -113,6 +158,18 @@ protected:
      */
     void emitOps(Op::Code a, Op::Code b);
 
+    /**
+     * Emits the short form of an instruction if its index operand fits in a single
+     * Op::Code, otherwise the 32-bit form followed by two Op::Code operands.
+     *
+     * @brief Writes an instruction with an index operand to the current batch.
+     * @param op The instruction to emit when index fits in one Op::Code.
+     * @param op32 The instruction to emit when index needs two Op::Codes.
+     * @param index The operand.
+     * @param errorMessage The error reported if index doesn't fit in 32 bits.
+     */
+    void emitIndexedOp(Op::Code op, Op::Code op32, size_t index, std::string_view errorMessage);
+
     /**
      * @brief Parses the next expression in the source code.
      */
@@ -163,6 +220,21 @@ protected:
       */
      void statement();
 
+     /**
+      * @brief Parses the declarations of a block up to its closing brace.
+      */
+     void block();
+
+     /**
+      * @brief Enters a block, so the variables it declares are locals.
+      */
+     void beginScope();
+
+     /**
+      * @brief Leaves a block, popping the locals it declared off the stack.
+      */
+     void endScope();
+
      /**
       * @brief Parses an expression and pops the resulting value from the stack.
       */
@@ -179,11 +251,48 @@ protected:
      void variable();
 
      /**
-      * @brief Creates a sequence of instructions for loading a named variable.
+      * @brief Parses the arguments of a call to a built-in function, and emits the call.
+      * @param callee The token naming the function.
+      */
+     void call(Token callee);
+
+     /**
+      * Parses m[rows, columns] after a matrix m, where each dimension is an index or a
+      * half-open range start:end whose bounds may be left out, e.g. m[0, :] or m[1:3, 2:].
+      * A single dimension, m[rows], selects whole rows. If the subscript is applied to a
+      * variable and followed by '=', it is parsed as an assignment to the selected entries.
+      *
+      * @brief Parses a subscript of a matrix, or an assignment to one.
+      */
+     void index();
+
+     /**
+      * @brief Parses the index or range of one dimension of a subscript.
+      * @return True if the dimension is a range.
+      */
+     bool subscriptDimension();
+
+     /**
+      * Locals are read and written by stack slot, globals by global slot. If the variable
+      * may be assigned to and is followed by '=', the assignment is parsed instead.
+      *
+      * @brief Creates a sequence of instructions for loading, or assigning to, a named variable.
       * @param token The token to parse the variable from.
       */
      void namedVariable(const Token& token);
 
+     /**
+      * @brief Returns the stack slot of the innermost local with the token's name, or -1 if it names a global.
+      * @param token Token to lex the variable's name from.
+      */
+     int resolveLocal(const Token& token);
+
+     /**
+      * @brief Adds a local to the current block, reporting an error if the block already declares one with the same name.
+      * @param token Token to lex the variable's name from.
+      */
+     void declareLocal(const Token& token);
+
      /**
       * @brief Recovers the parser from panic mode to prevent cascade errors.
       */
@@ -196,22 +305,25 @@ protected:
     void parsePrecedence(Precedence precedence);
 
     /**
-     * @brief Parses a variable name from the source stream.
+     * @brief Parses a variable name from the source stream, declaring it as a local if inside a block.
      * @param errorMessage Message to be displayed if parsing fails.
-     * @return The index of the new variable's name in the constants array of the current batch.
+     * @return The global slot of the new variable, or 0 if it is a local.
      */
-    size_t parseVariable(const std::string& errorMessage);
+    size_t parseVariable(std::string_view errorMessage);
 
     /**
-     * @brief Creates a string constant and returns its index for use in defining variables.
-     * @param token Token to lex the constant's name from.
-     * @return The index of the string.
+     * @brief Resolves an identifier to its global variable slot.
+     * @param token Token to lex the variable's name from.
+     * @return The slot index of the global variable.
      */
-    size_t identifierConstant(const Token& token);
+    size_t identifierSlot(const Token& token);
 
     /**
-     * @brief Writes Op::Codes to the current batch to define a global variable, given the index to its name.
-     * @param global The index of the global variable's name in the batch's constant pool.
+     * A local needs no instructions, its initial value is already in its stack slot, so it
+     * is only marked as initialised.
+     *
+     * @brief Writes Op::Codes to the current batch to define a global variable, given its slot.
+     * @param global The slot index of the global variable, unused for locals.
      */
     void defineVariable(size_t global);
 
@@ -222,6 +334,47 @@ protected:
      */
     size_t emitConstant(const Value& value);
 
+    /**
+     * Booleans and null are emitted as their dedicated Op::Codes, everything
+     * else is added to the constant pool. The literal is recorded so that an
+     * enclosing operator can fold it.
+     *
+     * @brief Writes Op::Codes to the current batch that load a compile-time value.
+     * @param value The value to be loaded.
+     */
+    void emitLiteral(const Value& value);
+
+    /**
+     * @brief Returns the last emitted literal if it is the whole expression ending at the given Op::Code index.
+     * @param end Index one past the last Op::Code of the expression.
+     * @return The literal, or nothing if the expression isn't a literal.
+     */
+    std::optional<Literal> literalEndingAt(size_t end) const;
+
+    /**
+     * Evaluates a unary operator on a literal operand at compile time and
+     * replaces the operand's code with a single load of the result.
+     *
+     * @brief Folds a unary operator applied to a literal.
+     * @param operatorType The operator's token type.
+     * @param operand The operand.
+     * @return True if the operator was folded, false if it must be evaluated at runtime.
+     */
+    bool foldUnary(Token::Type operatorType, const Literal& operand);
+
+    /**
+     * Evaluates a binary operator on two literal operands at compile time and
+     * replaces both operands' code with a single load of the result. Operators
+     * whose operand types would raise a runtime error are left to the VM.
+     *
+     * @brief Folds a binary operator applied to two literals.
+     * @param operatorType The operator's token type.
+     * @param lhs The left operand.
+     * @param rhs The right operand.
+     * @return True if the operator was folded, false if it must be evaluated at runtime.
+     */
+    bool foldBinary(Token::Type operatorType, const Literal& lhs, const Literal& rhs);
+
     /**
      * @brief Consumes a token if it has the given type, otherwise returns false.
      * @param type The type to check the next token for.
@@ -0,0 +1,849 @@
+/**
+ * @file CpuMath.cpp
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains multi-threaded CPU array math for matrix operations.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "CpuMath.h"
+
+//The matrix product is also compiled for AVX2 and FMA with a target attribute, and only called after a runtime CPU check.
+#if (defined(__x86_64__) || defined(_M_X64)) && defined(__GNUC__)
+#define TITAN_GEMM_AVX2
+#define TITAN_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+#ifdef __GNUC__
+#define TITAN_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define TITAN_ALWAYS_INLINE inline
+#endif //__GNUC__
+
+namespace {
+//Blocking for cpuMatrixMultiply. A packed block of a (BlockRows x BlockDepth) stays in L2, and a
+//micro-panel of b (BlockDepth x tile columns) stays in L1 while it is swept down the block of a.
+const size_t BlockRows = 96;      ///< Rows of a packed at a time.
+const size_t BlockDepth = 256;    ///< Columns of a and rows of b packed at a time.
+const size_t BlockColumns = 2048; ///< Columns of b packed at a time.
+const size_t TileRows = 6;        ///< Rows of the result each micro-kernel call accumulates in registers.
+
+const size_t SmallProduct = 32 * 32 * 32; ///< Products with fewer multiply-adds skip packing.
+const size_t MultiplyAddsPerUnit = 64;     ///< Multiply-adds counted as one parallelFor element.
+
+const size_t EvaluateBlock = 256; ///< Elements cpuEvaluate runs each step over at a time, small enough to stay in L1.
+
+const size_t ReduceLanes = 16;       ///< Independent accumulators per block, spread over several vector registers.
+const size_t ReduceVectorBytes = 16; ///< Width of the vectors the accumulators are held in, SSE2 or NEON on any 64-bit CPU.
+const size_t PairwiseBlock = 512;    ///< Elements reduced directly before pairwise summation splits a range in half.
+
+const size_t TransposeLeaf = 32; ///< Rows and columns of the largest block transposed directly, so it and its transpose stay in L1.
+
+/**
+ * @brief Copies rows [0, rows) and columns [0, depth) of a into panels of TileRows rows, stored column by column.
+ *
+ * Each panel holds depth x TileRows entries, so the micro-kernel reads it sequentially.
+ * Rows past the end of a are padded with zeroes.
+ */
+template <typename T>
+void packRows(size_t rows, size_t depth, const T* a, size_t stride, T* packed) {
+    for (size_t i = 0; i < rows; i += TileRows) {
+        for (size_t p = 0; p < depth; ++p) {
+            for (size_t r = 0; r < TileRows; ++r) {
+                *packed++ = i + r < rows ? a[(i + r) * stride + p] : T(0);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Copies rows [0, depth) and columns [0, columns) of b into panels of tileColumns columns, stored row by row.
+ *
+ * Columns past the end of b are padded with zeroes.
+ */
+template <size_t tileColumns, typename T>
+void packColumns(size_t depth, size_t columns, const T* b, size_t stride, T* packed) {
+    for (size_t j = 0; j < columns; j += tileColumns) {
+        const size_t width = std::min(tileColumns, columns - j);
+        for (size_t p = 0; p < depth; ++p) {
+            const T* row = b + p * stride + j;
+            for (size_t c = 0; c < tileColumns; ++c) {
+                packed[c] = c < width ? row[c] : T(0);
+            }
+            packed += tileColumns;
+        }
+    }
+}
+
+/**
+ * Accumulates a TileRows x (2 vectors) tile of the product in vector registers, broadcasting
+ * one entry of a at a time against two vectors of b, then adds the valid rows and columns of
+ * the tile into c.
+ *
+ * @brief Multiplies a packed panel of a by a packed panel of b into a tile of c.
+ * @tparam vectorBytes The width of the vector registers to accumulate in.
+ * @param first True for the first block of depth, where c is overwritten instead of added to.
+ */
+template <size_t vectorBytes, typename T>
+TITAN_ALWAYS_INLINE void multiplyTile(size_t depth, const T* __restrict a, const T* __restrict b, T* __restrict c, size_t stride,
+                                      size_t rows, size_t columns, bool first) {
+    constexpr size_t Lanes = vectorBytes / sizeof(T);
+    T tile[TileRows][2 * Lanes];
+#ifdef __GNUC__
+    typedef T Vector __attribute__((vector_size(vectorBytes)));
+    Vector sums[TileRows][2] = {};
+    for (size_t p = 0; p < depth; ++p) {
+        Vector lo, hi;
+        std::memcpy(&lo, b + p * 2 * Lanes, vectorBytes);
+        std::memcpy(&hi, b + p * 2 * Lanes + Lanes, vectorBytes);
+        for (size_t r = 0; r < TileRows; ++r) {
+            const T scale = a[p * TileRows + r];
+            sums[r][0] += scale * lo;
+            sums[r][1] += scale * hi;
+        }
+    }
+    std::memcpy(tile, sums, sizeof(tile));
+#else
+    for (size_t r = 0; r < TileRows; ++r) {
+        std::fill(tile[r], tile[r] + 2 * Lanes, T(0));
+    }
+    for (size_t p = 0; p < depth; ++p) {
+        for (size_t r = 0; r < TileRows; ++r) {
+            for (size_t j = 0; j < 2 * Lanes; ++j) {
+                tile[r][j] += a[p * TileRows + r] * b[p * 2 * Lanes + j];
+            }
+        }
+    }
+#endif //__GNUC__
+    for (size_t r = 0; r < rows; ++r) {
+        T* row = c + r * stride;
+        for (size_t j = 0; j < columns; ++j) {
+            row[j] = first ? tile[r][j] : row[j] + tile[r][j];
+        }
+    }
+}
+
+/**
+ * @brief Computes rows [rowBegin, rowEnd) of the product of a and b with the blocked algorithm.
+ * @tparam vectorBytes The width of the vector registers the micro-kernel is sized for.
+ */
+template <size_t vectorBytes, typename T>
+TITAN_ALWAYS_INLINE void multiplyRows(size_t rowBegin, size_t rowEnd, size_t k, size_t n, const T* a, const T* b, T* result) {
+    //Two vectors per row of a tile leaves registers free for the loads of a and b.
+    constexpr size_t TileColumns = 2 * vectorBytes / sizeof(T);
+    auto roundUp = [](size_t value, size_t multiple) { return (value + multiple - 1) / multiple * multiple; };
+    std::vector<T> packedA(roundUp(std::min(BlockRows, rowEnd - rowBegin), TileRows) * std::min(BlockDepth, k));
+    std::vector<T> packedB(roundUp(std::min(BlockColumns, n), TileColumns) * std::min(BlockDepth, k));
+
+    for (size_t jc = 0; jc < n; jc += BlockColumns) {
+        const size_t columns = std::min(BlockColumns, n - jc);
+        for (size_t pc = 0; pc < k; pc += BlockDepth) {
+            const size_t depth = std::min(BlockDepth, k - pc);
+            packColumns<TileColumns>(depth, columns, b + pc * n + jc, n, packedB.data());
+
+            for (size_t ic = rowBegin; ic < rowEnd; ic += BlockRows) {
+                const size_t rows = std::min(BlockRows, rowEnd - ic);
+                packRows(rows, depth, a + ic * k + pc, k, packedA.data());
+
+                for (size_t jr = 0; jr < columns; jr += TileColumns) {
+                    for (size_t ir = 0; ir < rows; ir += TileRows) {
+                        multiplyTile<vectorBytes>(depth, packedA.data() + ir * depth, packedB.data() + jr * depth,
+                                                  result + (ic + ir) * n + jc + jr, n,
+                                                  std::min(TileRows, rows - ir), std::min(TileColumns, columns - jr), pc == 0);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Computes rows [rowBegin, rowEnd) of the product of a and the k x 1 column vector b.
+ * @tparam vectorBytes The width of the vector registers to accumulate in.
+ */
+template <size_t vectorBytes, typename T>
+TITAN_ALWAYS_INLINE void multiplyVector(size_t rowBegin, size_t rowEnd, size_t k, const T* __restrict a, const T* __restrict b, T* __restrict result) {
+    constexpr size_t Lanes = vectorBytes / sizeof(T);
+    for (size_t i = rowBegin; i < rowEnd; ++i) {
+        const T* row = a + i * k;
+        T sum = 0;
+        size_t p = 0;
+#ifdef __GNUC__
+        //Independent accumulators hide the latency of the vector adds.
+        typedef T Vector __attribute__((vector_size(vectorBytes)));
+        Vector sums[4] = {};
+        for (; p + 4 * Lanes <= k; p += 4 * Lanes) {
+            for (size_t v = 0; v < 4; ++v) {
+                Vector lhs, rhs;
+                std::memcpy(&lhs, row + p + v * Lanes, vectorBytes);
+                std::memcpy(&rhs, b + p + v * Lanes, vectorBytes);
+                sums[v] += lhs * rhs;
+            }
+        }
+        //Sum the lanes pairwise rather than one after another, which would be a long chain of dependent adds.
+        T lanes[Lanes];
+        const Vector total = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        std::memcpy(lanes, &total, vectorBytes);
+        for (size_t width = Lanes / 2; width > 0; width /= 2) {
+            for (size_t l = 0; l < width; ++l) {
+                lanes[l] += lanes[l + width];
+            }
+        }
+        sum = lanes[0];
+#endif //__GNUC__
+        for (; p < k; ++p) {
+            sum += row[p] * b[p];
+        }
+        result[i] = sum;
+    }
+}
+
+/**
+ * @brief Computes rows [rowBegin, rowEnd) of the product of a and b, using vectors of the given width.
+ */
+template <size_t vectorBytes, typename T>
+TITAN_ALWAYS_INLINE void multiplyRange(size_t rowBegin, size_t rowEnd, size_t k, size_t n, const T* a, const T* b, T* result) {
+    if (n == 1) {
+        multiplyVector<vectorBytes>(rowBegin, rowEnd, k, a, b, result);
+    }
+    else {
+        multiplyRows<vectorBytes>(rowBegin, rowEnd, k, n, a, b, result);
+    }
+}
+
+template <typename T>
+void multiplyRangeDefault(size_t rowBegin, size_t rowEnd, size_t k, size_t n, const T* a, const T* b, T* result) {
+    multiplyRange<16>(rowBegin, rowEnd, k, n, a, b, result);
+}
+
+#ifdef TITAN_GEMM_AVX2
+template <typename T>
+TITAN_TARGET_AVX2 void multiplyRangeAvx2(size_t rowBegin, size_t rowEnd, size_t k, size_t n, const T* a, const T* b, T* result) {
+    multiplyRange<32>(rowBegin, rowEnd, k, n, a, b, result);
+}
+#endif //TITAN_GEMM_AVX2
+
+/**
+ * @brief Computes rows [rowBegin, rowEnd) of the product of a and b directly, for products too small to be worth packing.
+ */
+template <typename T>
+void multiplySmall(size_t rowBegin, size_t rowEnd, size_t k, size_t n, const T* __restrict a, const T* __restrict b, T* __restrict result) {
+    for (size_t i = rowBegin; i < rowEnd; ++i) {
+        T* row = result + i * n;
+        std::fill(row, row + n, T(0));
+        for (size_t p = 0; p < k; ++p) {
+            const T scale = a[i * k + p];
+            const T* bRow = b + p * n;
+            for (size_t j = 0; j < n; ++j) {
+                row[j] += scale * bRow[j];
+            }
+        }
+    }
+}
+
+/**
+ * Written for both T and GCC vectors of T, so the same code maps one entry or a vector of them.
+ *
+ * @brief Returns the value an entry x of a, and the matching entry y of b, contribute to a reduction.
+ */
+template <Reduction R, typename T, typename V>
+TITAN_ALWAYS_INLINE V reduceEntry(V x, V y) {
+    const V zero = {};
+    if constexpr (R == Reduction::AbsoluteSum) return x < zero ? -x : x;
+    else if constexpr (R == Reduction::SquareSum) return x * x;
+    else if constexpr (R == Reduction::Dot) return x * y;
+    else if constexpr (R == Reduction::Unequal) {
+        const V absX = x < zero ? -x : x;
+        const V absY = y < zero ? -y : y;
+        const V difference = x > y ? x - y : y - x;
+        const V largest = absX > absY ? absX : absY;
+        //Written as !(difference <= limit) so NaN entries count as unequal, as in cpuEqual().
+        return difference <= largest * std::numeric_limits<T>::epsilon() ? zero : zero + 1;
+    }
+    else return x;
+}
+
+/**
+ * @brief Combines two partial results of a reduction, for T or GCC vectors of T.
+ */
+template <Reduction R, typename V>
+TITAN_ALWAYS_INLINE V reduceCombine(V x, V y) {
+    if constexpr (R == Reduction::Min) return y < x ? y : x;
+    else if constexpr (R == Reduction::Max) return y > x ? y : x;
+    else return x + y;
+}
+
+/**
+ * @brief Returns the result of a reduction over no entries.
+ */
+template <Reduction R, typename T>
+T reduceIdentity() {
+    if constexpr (R == Reduction::Min) return std::numeric_limits<T>::infinity();
+    else if constexpr (R == Reduction::Max) return -std::numeric_limits<T>::infinity();
+    else return T(0);
+}
+
+/**
+ * @brief Reduces count entries directly, striding them across ReduceLanes accumulators so the loop vectorises.
+ */
+template <Reduction R, typename T>
+T reduceBlock(const T* __restrict a, const T* __restrict b, size_t count) {
+    T lanes[ReduceLanes];
+    size_t i = 0;
+#ifdef __GNUC__
+    //Min and max only vectorise when written with vector types.
+    constexpr size_t VectorLanes = ReduceVectorBytes / sizeof(T);
+    constexpr size_t VectorCount = ReduceLanes / VectorLanes;
+    typedef T Vector __attribute__((vector_size(ReduceVectorBytes)));
+    Vector sums[VectorCount];
+    for (Vector& sum : sums) {
+        sum = Vector{} + reduceIdentity<R, T>();
+    }
+    for (; i + ReduceLanes <= count; i += ReduceLanes) {
+        for (size_t v = 0; v < VectorCount; ++v) {
+            Vector x, y = {};
+            std::memcpy(&x, a + i + v * VectorLanes, ReduceVectorBytes);
+            if constexpr (R == Reduction::Dot || R == Reduction::Unequal) std::memcpy(&y, b + i + v * VectorLanes, ReduceVectorBytes);
+            sums[v] = reduceCombine<R>(sums[v], reduceEntry<R, T>(x, y));
+        }
+    }
+    std::memcpy(lanes, sums, sizeof(lanes));
+#else
+    std::fill(lanes, lanes + ReduceLanes, reduceIdentity<R, T>());
+    for (; i + ReduceLanes <= count; i += ReduceLanes) {
+        for (size_t lane = 0; lane < ReduceLanes; ++lane) {
+            lanes[lane] = reduceCombine<R>(lanes[lane], reduceEntry<R, T>(a[i + lane], b == nullptr ? T(0) : b[i + lane]));
+        }
+    }
+#endif //__GNUC__
+    for (size_t lane = 0; i < count; ++i, ++lane) {
+        lanes[lane] = reduceCombine<R>(lanes[lane], reduceEntry<R, T>(a[i], b == nullptr ? T(0) : b[i]));
+    }
+    //Combine the lanes as a tree too.
+    for (size_t width = ReduceLanes / 2; width > 0; width /= 2) {
+        for (size_t lane = 0; lane < width; ++lane) {
+            lanes[lane] = reduceCombine<R>(lanes[lane], lanes[lane + width]);
+        }
+    }
+    return lanes[0];
+}
+
+/**
+ * Splits the longer side of the block in half until it fits in TransposeLeaf x TransposeLeaf.
+ * At some depth of the recursion the blocks fit in each level of cache, whatever its size, so
+ * both the reads and the strided writes reuse every cache line they touch.
+ *
+ * @brief Writes the transpose of a rows x columns block of a into result.
+ * @param aStride The distance between rows of a.
+ * @param resultStride The distance between rows of result.
+ */
+template <typename T>
+void transposeBlock(size_t rows, size_t columns, const T* __restrict a, size_t aStride, T* __restrict result, size_t resultStride) {
+    if (rows <= TransposeLeaf && columns <= TransposeLeaf) {
+        for (size_t j = 0; j < columns; ++j) {
+            for (size_t i = 0; i < rows; ++i) {
+                result[j * resultStride + i] = a[i * aStride + j];
+            }
+        }
+        return;
+    }
+    if (rows >= columns) {
+        const size_t half = rows / 2;
+        transposeBlock(half, columns, a, aStride, result, resultStride);
+        transposeBlock(rows - half, columns, a + half * aStride, aStride, result + half, resultStride);
+    }
+    else {
+        const size_t half = columns / 2;
+        transposeBlock(rows, half, a, aStride, result, resultStride);
+        transposeBlock(rows, columns - half, a + half, aStride, result + half * resultStride, resultStride);
+    }
+}
+
+/**
+ * Both tiles are copied into local buffers row by row and written back row by row, so memory
+ * is only accessed along rows, and the transposing happens between buffers in L1.
+ *
+ * @brief Swaps a rows x columns tile at (rowBegin, columnBegin) of a square matrix with its mirror, transposing both.
+ * @param diagonal True if the tile is on the diagonal, and so is its own mirror.
+ */
+template <typename T>
+TITAN_ALWAYS_INLINE void swapTile(size_t width, size_t rowBegin, size_t columnBegin, size_t rows, size_t columns, bool diagonal,
+                                  T* __restrict a) {
+    T upper[TransposeLeaf][TransposeLeaf];
+    T lower[TransposeLeaf][TransposeLeaf];
+    for (size_t i = 0; i < rows; ++i) {
+        std::memcpy(upper[i], a + (rowBegin + i) * width + columnBegin, columns * sizeof(T));
+    }
+    for (size_t i = 0; i < columns; ++i) {
+        std::memcpy(lower[i], a + (columnBegin + i) * width + rowBegin, rows * sizeof(T));
+    }
+    for (size_t i = 0; i < columns; ++i) {
+        T* out = a + (columnBegin + i) * width + rowBegin;
+        for (size_t j = 0; j < rows; ++j) out[j] = upper[j][i];
+    }
+    if (diagonal) return;
+    for (size_t i = 0; i < rows; ++i) {
+        T* out = a + (rowBegin + i) * width + columnBegin;
+        for (size_t j = 0; j < columns; ++j) out[j] = lower[j][i];
+    }
+}
+
+/**
+ * @brief Swaps the tiles at (row, column) and (column, row) of a square matrix, transposing both.
+ * @param row The tile's row, in tiles of TransposeLeaf x TransposeLeaf.
+ * @param column The tile's column, in tiles, no less than row.
+ */
+template <typename T>
+void swapTiles(size_t width, size_t row, size_t column, T* a) {
+    const size_t rowBegin = row * TransposeLeaf;
+    const size_t columnBegin = column * TransposeLeaf;
+    const size_t rows = std::min(TransposeLeaf, width - rowBegin);
+    const size_t columns = std::min(TransposeLeaf, width - columnBegin);
+    //Whole tiles get loops of a constant length, which the compiler unrolls and vectorises.
+    if (rows == TransposeLeaf && columns == TransposeLeaf) {
+        swapTile(width, rowBegin, columnBegin, TransposeLeaf, TransposeLeaf, row == column, a);
+    }
+    else {
+        swapTile(width, rowBegin, columnBegin, rows, columns, row == column, a);
+    }
+}
+
+/**
+ * Halves the range until it fits in a block, so the rounding error of a sum grows with the
+ * log of count rather than with count.
+ *
+ * @brief Reduces count entries by pairwise summation.
+ */
+template <Reduction R, typename T>
+T reducePairwise(const T* a, const T* b, size_t count) {
+    if (count <= PairwiseBlock) return reduceBlock<R>(a, b, count);
+    //Split on a block boundary so only the last block is partial.
+    const size_t half = (count / 2 + PairwiseBlock - 1) / PairwiseBlock * PairwiseBlock;
+    return reduceCombine<R>(reducePairwise<R>(a, b, half), reducePairwise<R>(a + half, b == nullptr ? nullptr : b + half, count - half));
+}
+
+/**
+ * @brief Reduces a block of rows by pairwise summation over the rows, then over each row.
+ */
+template <Reduction R, typename T>
+T reduceRows(size_t rows, size_t columns, const T* a, size_t aStride, const T* b, size_t bStride) {
+    if (rows == 1) return reducePairwise<R>(a, b, columns);
+    const size_t half = rows / 2;
+    return reduceCombine<R>(reduceRows<R>(half, columns, a, aStride, b, bStride),
+                            reduceRows<R>(rows - half, columns, a + half * aStride, aStride, b == nullptr ? nullptr : b + half * bStride, bStride));
+}
+
+/**
+ * Contiguous blocks are reduced as one long row, so only blocks of a wider matrix pay for
+ * their strides. Large blocks are split across threads, as ranges of entries of a single row
+ * or as ranges of whole rows.
+ *
+ * @brief Reduces rows x columns entries, one chunk per thread, then combines the chunks in order so the result doesn't depend on timing.
+ */
+template <Reduction R, typename T>
+T reduce(size_t rows, size_t columns, const T* a, size_t aStride, const T* b, size_t bStride) {
+    if (aStride == columns && (b == nullptr || bStride == columns)) {
+        columns *= rows;
+        rows = 1;
+    }
+    const size_t n = rows * columns;
+    if (n == 0) return reduceIdentity<R, T>();
+    if (n < CpuMath::ParallelThreshold) return reduceRows<R>(rows, columns, a, aStride, b, bStride);
+
+    std::mutex mutex;
+    std::vector<std::pair<size_t, T>> partials;
+    CpuMath::parallelFor(n, [&](size_t begin, size_t end) {
+        T partial;
+        if (rows == 1) {
+            partial = reducePairwise<R>(a + begin, b == nullptr ? nullptr : b + begin, end - begin);
+        }
+        else {
+            //The chunk takes the rows that start within it.
+            const size_t first = (begin + columns - 1) / columns;
+            const size_t last = std::min(rows, (end + columns - 1) / columns);
+            if (first >= last) return;
+            partial = reduceRows<R>(last - first, columns, a + first * aStride, aStride, b == nullptr ? nullptr : b + first * bStride, bStride);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        partials.emplace_back(begin, partial);
+    });
+    std::sort(partials.begin(), partials.end());
+
+    T result = reduceIdentity<R, T>();
+    for (const auto& [begin, partial] : partials) {
+        result = reduceCombine<R>(result, partial);
+    }
+    return result;
+}
+
+thread_local bool inParallelFor = false; ///< True on a thread running a chunk of a parallelFor.
+
+/**
+ * Threads are created on the first parallel loop and sleep between loops, so a loop pays for
+ * waking them rather than for creating and joining threads. One loop runs at a time, and the
+ * calling thread takes a chunk of it too. Workers wait on atomics, which sleep in the kernel
+ * without needing a mutex.
+ *
+ * @brief A fixed set of worker threads that run the chunks of parallelFor.
+ */
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t count) {
+        workers.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            workers.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    ~WorkerPool() {
+        stopping = true;
+        generation.fetch_add(1, std::memory_order_release);
+        generation.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * @brief Runs body on chunks of chunkSize entries of [0, n), the first chunks on workers and the last on the calling thread.
+     * @param chunks The number of chunks run on workers, at most the size of the pool.
+     */
+    void run(size_t chunks, size_t chunkSize, size_t n, const std::function<void(size_t, size_t)>& body) {
+        std::lock_guard<std::mutex> running(dispatch);
+        job = &body;
+        jobChunks = chunks;
+        jobChunkSize = chunkSize;
+        //Every worker wakes and checks in, even without a chunk, so none can still be reading this loop's job when the next one is set.
+        pending.store(workers.size(), std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+        generation.notify_all();
+
+        inParallelFor = true;
+        body(chunks * chunkSize, n);
+        inParallelFor = false;
+
+        for (size_t left = pending.load(std::memory_order_acquire); left != 0; left = pending.load(std::memory_order_acquire)) {
+            pending.wait(left, std::memory_order_acquire);
+        }
+    }
+
+private:
+    void work(size_t index) {
+        inParallelFor = true;
+        size_t seen = 0;
+        for (;;) {
+            generation.wait(seen, std::memory_order_acquire);
+            seen = generation.load(std::memory_order_acquire);
+            if (stopping) return;
+
+            if (index < jobChunks) {
+                const size_t begin = index * jobChunkSize;
+                (*job)(begin, begin + jobChunkSize);
+            }
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) pending.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex dispatch;                ///< Held for the whole of a loop, so loops from different threads take turns.
+    std::atomic<size_t> generation = 0; ///< Counts loops, workers sleep until it changes.
+    std::atomic<size_t> pending = 0;    ///< Workers yet to finish with the current loop.
+    //Written before generation is incremented and read by workers after they see the increment.
+    const std::function<void(size_t, size_t)>* job = nullptr; ///< The body of the current loop.
+    size_t jobChunks = 0;               ///< Workers [0, jobChunks) each run one chunk of the current loop.
+    size_t jobChunkSize = 0;            ///< Entries in each chunk of the current loop.
+    bool stopping = false;              ///< Set when the pool is destroyed.
+};
+}
+
+void CpuMath::parallelFor(size_t n, const std::function<void(size_t, size_t)>& body) {
+    //hardware_concurrency() reads the online CPU list from the OS, which costs more than a small matrix operation.
+    static const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t threadCount = std::min(hardwareThreads, n / ParallelThreshold);
+    if (threadCount <= 1) {
+        body(0, n);
+        return;
+    }
+
+    //A chunk that starts another loop runs it itself rather than waiting on the pool it is part of.
+    if (inParallelFor) {
+        body(0, n);
+        return;
+    }
+
+    //Split the range into equal chunks, the calling thread takes the last one.
+    static WorkerPool pool(hardwareThreads - 1);
+    const size_t chunkSize = (n + threadCount - 1) / threadCount;
+    pool.run((n - 1) / chunkSize, chunkSize, n, body);
+}
+
+template <typename T>
+void CpuMath::cpuAdd(size_t n, T* a, T* b, T* sum) {
+    parallelFor(n, [=](size_t begin, size_t end) {
+        const T* __restrict lhs = a;
+        const T* __restrict rhs = b;
+        T* __restrict out = sum;
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = lhs[i] + rhs[i];
+        }
+    });
+}
+
+template <typename T>
+void CpuMath::cpuSubtract(size_t n, T* a, T* b, T* result) {
+    parallelFor(n, [=](size_t begin, size_t end) {
+        const T* __restrict lhs = a;
+        const T* __restrict rhs = b;
+        T* __restrict out = result;
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = lhs[i] - rhs[i];
+        }
+    });
+}
+
+template <typename T>
+void CpuMath::cpuScalarMultiply(size_t n, T* a, T b, T* result) {
+    parallelFor(n, [=](size_t begin, size_t end) {
+        const T* __restrict lhs = a;
+        T* __restrict out = result;
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = lhs[i] * b;
+        }
+    });
+}
+
+template <typename T>
+bool CpuMath::cpuEqual(size_t n, T* a, T* b) {
+    std::atomic<bool> equal = true;
+    parallelFor(n, [=, &equal](size_t begin, size_t end) {
+        const T* __restrict lhs = a;
+        const T* __restrict rhs = b;
+        //Accumulate without branching so the loop vectorises, then publish once per chunk.
+        bool chunkEqual = true;
+        for (size_t i = begin; i < end; ++i) {
+            chunkEqual &= std::abs(lhs[i] - rhs[i]) <= std::max(std::abs(lhs[i]), std::abs(rhs[i])) * std::numeric_limits<T>::epsilon();
+        }
+        if (!chunkEqual) {
+            equal.store(false, std::memory_order_relaxed);
+        }
+    });
+    return equal;
+}
+
+template <typename T>
+void CpuMath::cpuTranspose(size_t n, size_t oldWidth, T* a, T* result) {
+    if (n == 0) return;
+    const size_t oldHeight = n / oldWidth;
+    //Each thread writes the rows of the result from a range of columns of a, weighted by their length.
+    parallelFor(n, [=](size_t begin, size_t end) {
+        const size_t columnBegin = (begin + oldHeight - 1) / oldHeight;
+        const size_t columnEnd = std::min(oldWidth, (end + oldHeight - 1) / oldHeight);
+        if (columnBegin >= columnEnd) return;
+        transposeBlock(oldHeight, columnEnd - columnBegin, a + columnBegin, oldWidth, result + columnBegin * oldHeight, oldHeight);
+    });
+}
+
+template <typename T>
+void CpuMath::cpuTransposeSquare(size_t width, T* a) {
+    //Tiles on and above the diagonal in row-major order, each swapped with its mirror below the diagonal.
+    const size_t tiles = (width + TransposeLeaf - 1) / TransposeLeaf;
+    const size_t area = TransposeLeaf * TransposeLeaf;
+    parallelFor(tiles * (tiles + 1) / 2 * area, [=](size_t begin, size_t end) {
+        const size_t first = (begin + area - 1) / area;
+        const size_t last = (end + area - 1) / area;
+        size_t row = 0;
+        size_t column = first;
+        while (column >= tiles) {
+            column -= tiles - row - 1;
+            ++row;
+        }
+        for (size_t pair = first; pair < last; ++pair) {
+            swapTiles(width, row, column, a);
+            if (++column == tiles) {
+                ++row;
+                column = row;
+            }
+        }
+    });
+}
+
+template <typename T>
+void CpuMath::cpuMatrixMultiply(size_t m, size_t k, size_t n, T* a, T* b, T* result) {
+    if (m == 0 || n == 0) return;
+    if (k == 0) return cpuZeroArray(m * n, result);
+
+#ifdef TITAN_GEMM_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    const bool avx2 = false;
+#endif //TITAN_GEMM_AVX2
+
+    //Split rows of the result across threads, weighted by the multiply-adds in each row.
+    const size_t rowUnits = std::max<size_t>(1, n * k / MultiplyAddsPerUnit);
+    parallelFor(m * rowUnits, [=](size_t begin, size_t end) {
+        const size_t rowBegin = (begin + rowUnits - 1) / rowUnits;
+        const size_t rowEnd = std::min(m, (end + rowUnits - 1) / rowUnits);
+        if (rowBegin >= rowEnd) return;
+
+        if (m * n * k < SmallProduct && n > 1) {
+            multiplySmall(rowBegin, rowEnd, k, n, a, b, result);
+        }
+#ifdef TITAN_GEMM_AVX2
+        else if (avx2) {
+            multiplyRangeAvx2(rowBegin, rowEnd, k, n, a, b, result);
+        }
+#endif //TITAN_GEMM_AVX2
+        else {
+            multiplyRangeDefault(rowBegin, rowEnd, k, n, a, b, result);
+        }
+    });
+}
+
+template <typename T>
+void CpuMath::cpuEvaluate(size_t rows, size_t columns, const ElementwiseProgram<T>& program, T* result, size_t resultStride) {
+    using Op = typename ElementwiseProgram<T>::Op;
+    //Contiguous operands and results run as one long row, so blocks aren't cut short at the end of each row.
+    bool contiguous = resultStride == columns;
+    for (unsigned o = 0; o < program.operandCount; ++o) {
+        contiguous = contiguous && program.strides[o] == columns;
+    }
+    if (contiguous) {
+        columns *= rows;
+        rows = 1;
+    }
+    if (columns == 0) return;
+
+    parallelFor(rows * columns, [&program, result, resultStride, columns](size_t begin, size_t end) {
+        //Intermediate values for one block, one buffer per stack slot.
+        T scratch[ElementwiseProgram<T>::MaxDepth][EvaluateBlock];
+        const T* stack[ElementwiseProgram<T>::MaxDepth];
+
+        //Blocks never cross the end of a row.
+        for (size_t blockBegin = begin; blockBegin < end;) {
+            const size_t row = blockBegin / columns;
+            const size_t column = blockBegin % columns;
+            const size_t count = std::min({EvaluateBlock, columns - column, end - blockBegin});
+            T* const out = result + row * resultStride + column;
+            unsigned depth = 0;
+            for (unsigned s = 0; s < program.stepCount; ++s) {
+                const auto& step = program.steps[s];
+                if (step.op == Op::Load) {
+                    stack[depth++] = program.operands[step.operand] + row * program.strides[step.operand] + column;
+                    continue;
+                }
+                //The last step writes straight into the result, the others into the slot they leave their value in.
+                const unsigned slot = step.op == Op::Add || step.op == Op::Subtract ? depth - 2 : depth - 1;
+                T* stepOut = s + 1 == program.stepCount ? out : scratch[slot];
+                const T* lhs = stack[slot];
+                const T* rhs = stack[depth - 1];
+                switch (step.op) {
+                    case Op::Scale:
+                        for (size_t i = 0; i < count; ++i) stepOut[i] = lhs[i] * step.scalar;
+                        break;
+                    case Op::Add:
+                        for (size_t i = 0; i < count; ++i) stepOut[i] = lhs[i] + rhs[i];
+                        break;
+                    case Op::Subtract:
+                        for (size_t i = 0; i < count; ++i) stepOut[i] = lhs[i] - rhs[i];
+                        break;
+                    case Op::Negate:
+                        for (size_t i = 0; i < count; ++i) stepOut[i] = -lhs[i];
+                        break;
+                    default:
+                        break;
+                }
+                stack[slot] = stepOut;
+                depth = slot + 1;
+            }
+            //A program that only loads an operand is a copy.
+            if (program.stepCount == 1) {
+                std::memcpy(out, stack[0], count * sizeof(T));
+            }
+            blockBegin += count;
+        }
+    });
+}
+
+template <typename T>
+T CpuMath::cpuReduce(size_t rows, size_t columns, Reduction reduction, const T* a, size_t aStride, const T* b, size_t bStride) {
+    switch (reduction) {
+        case Reduction::Sum:         return reduce<Reduction::Sum>(rows, columns, a, aStride, b, bStride);
+        case Reduction::AbsoluteSum: return reduce<Reduction::AbsoluteSum>(rows, columns, a, aStride, b, bStride);
+        case Reduction::SquareSum:   return reduce<Reduction::SquareSum>(rows, columns, a, aStride, b, bStride);
+        case Reduction::Dot:         return reduce<Reduction::Dot>(rows, columns, a, aStride, b, bStride);
+        case Reduction::Min:         return reduce<Reduction::Min>(rows, columns, a, aStride, b, bStride);
+        case Reduction::Max:         return reduce<Reduction::Max>(rows, columns, a, aStride, b, bStride);
+        case Reduction::Unequal:     return reduce<Reduction::Unequal>(rows, columns, a, aStride, b, bStride);
+    }
+    return T(0);
+}
+
+template <typename T>
+void CpuMath::cpuZeroArray(size_t n, T* a) {
+    parallelFor(n, [=](size_t begin, size_t end) {
+        std::fill(a + begin, a + end, T(0));
+    });
+}
+
+template <typename T>
+void CpuMath::cpuIdentityArray(size_t n, size_t width, T* a) {
+    parallelFor(n, [=](size_t begin, size_t end) {
+        std::fill(a + begin, a + end, T(0));
+        //Only the diagonal needs writing after zeroing, one entry every width + 1.
+        for (size_t i = (begin + width) / (width + 1) * (width + 1); i < end; i += width + 1) {
+            a[i] = 1;
+        }
+    });
+}
+
+///Forward declarations
+//Add
+template void CpuMath::cpuAdd<float>(size_t n, float* a, float* b, float* sum);
+template void CpuMath::cpuAdd<double>(size_t n, double* a, double* b, double* sum);
+
+//Subtract
+template void CpuMath::cpuSubtract<float>(size_t n, float* a, float* b, float* result);
+template void CpuMath::cpuSubtract<double>(size_t n, double* a, double* b, double* result);
+
+//Scalar multiply
+template void CpuMath::cpuScalarMultiply<float>(size_t n, float* a, float b, float* result);
+template void CpuMath::cpuScalarMultiply<double>(size_t n, double* a, double b, double* result);
+
+//Equal
+template bool CpuMath::cpuEqual<float>(size_t n, float* a, float* b);
+template bool CpuMath::cpuEqual<double>(size_t n, double* a, double* b);
+
+//Transpose
+template void CpuMath::cpuTranspose<float>(size_t n, size_t oldWidth, float* a, float* result);
+template void CpuMath::cpuTranspose<double>(size_t n, size_t oldWidth, double* a, double* result);
+
+//Transpose square
+template void CpuMath::cpuTransposeSquare<float>(size_t width, float* a);
+template void CpuMath::cpuTransposeSquare<double>(size_t width, double* a);
+
+//Matrix multiply
+template void CpuMath::cpuMatrixMultiply<float>(size_t m, size_t k, size_t n, float* a, float* b, float* result);
+template void CpuMath::cpuMatrixMultiply<double>(size_t m, size_t k, size_t n, double* a, double* b, double* result);
+
+//Evaluate
+template void CpuMath::cpuEvaluate<float>(size_t rows, size_t columns, const ElementwiseProgram<float>& program, float* result, size_t resultStride);
+template void CpuMath::cpuEvaluate<double>(size_t rows, size_t columns, const ElementwiseProgram<double>& program, double* result, size_t resultStride);
+
+//Reduce
+template float CpuMath::cpuReduce<float>(size_t rows, size_t columns, Reduction reduction, const float* a, size_t aStride, const float* b, size_t bStride);
+template double CpuMath::cpuReduce<double>(size_t rows, size_t columns, Reduction reduction, const double* a, size_t aStride, const double* b, size_t bStride);
+
+//Zero array
+template void CpuMath::cpuZeroArray<float>(size_t n, float* a);
+template void CpuMath::cpuZeroArray<double>(size_t n, double* a);
+
+//Identity array
+template void CpuMath::cpuIdentityArray<float>(size_t n, size_t width, float* a);
+template void CpuMath::cpuIdentityArray<double>(size_t n, size_t width, double* a);
@@ -0,0 +1,189 @@
+#ifndef TITANPLUSPLUS_CPUMATH_H
+#define TITANPLUSPLUS_CPUMATH_H
+
+/**
+ * @file CpuMath.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains multi-threaded CPU array math for matrix operations.
+ */
+
+#include <cstddef>
+#include <functional>
+#include "ElementwiseProgram.h"
+#include "Reduction.h"
+
+/**
+ * The CPU counterpart to CudaMath. Every function mirrors a CudaMath function
+ * with the same argument layout so MatrixBackend can dispatch to either.
+ *
+ * Inner loops are written over restrict-qualified pointers with no loop-carried
+ * dependencies so the compiler vectorises them with SIMD instructions. Arrays larger
+ * than ParallelThreshold are also split into contiguous chunks across hardware threads.
+ */
+namespace CpuMath {
+/**
+ * @brief Minimum number of elements before an operation is split across threads.
+ */
+const size_t ParallelThreshold = 1 << 16;
+
+/**
+ * Splits [0, n) into contiguous chunks and runs body(begin, end) on each chunk,
+ * on a pool of one thread per hardware core that is created on first use and
+ * kept for later calls. Runs body(0, n) on the calling thread
+ * if n is below ParallelThreshold.
+ *
+ * @brief Runs a loop body over [0, n) in parallel.
+ * @param n The number of iterations.
+ * @param body The function to run on each chunk, called with a [begin, end) range.
+ */
+void parallelFor(size_t n, const std::function<void(size_t, size_t)>& body);
+
+/**
+ * @brief Performs point-wise addition on a and b, and stores the results in sum.
+ * @tparam T The type of the elements in the arrays, either float or double.
+ * @param n The size of the arrays.
+ * @param a Pointer to first summand array.
+ * @param b Pointer to second summand array.
+ * @param sum Pointer to sum array.
+ */
+template <typename T>
+void cpuAdd(size_t n, T* a, T* b, T* sum);
+
+/**
+ * @brief Performs point-wise subtraction on a and b, and stores the results in result.
+ * @tparam T The type of the elements in the arrays, either float or double.
+ * @param n The size of the arrays.
+ * @param a Pointer to minuend array.
+ * @param b Pointer to second subtrahend array.
+ * @param result Pointer to result array.
+ */
+template <typename T>
+void cpuSubtract(size_t n, T* a, T* b, T* result);
+
+/**
+ * @brief Performs point-wise scalar multiplication of a by b, and stores the results in result.
+ * @tparam T The type of the elements in a, either float or double.
+ * @param n The size of the array in a.
+ * @param a Pointer to the array being multiplied.
+ * @param b Scalar to multiply by.
+ * @param result Pointer to result array.
+ */
+template <typename T>
+void cpuScalarMultiply(size_t n, T* a, T b, T* result);
+
+/**
+ * @brief Tests the equality of two arrays within a relative epsilon.
+ * @tparam T The element types of the provided arrays.
+ * @param n The number of elements in each array.
+ * @param a Pointer to array a.
+ * @param b Pointer to array b.
+ * @return True if all elements are equal, otherwise false.
+ */
+template <typename T>
+bool cpuEqual(size_t n, T* a, T* b);
+
+/**
+ * Transposes with cache-oblivious recursion, halving the longer side of the block until it
+ * is small enough to transpose directly, so reads and writes both reuse whole cache lines.
+ * Columns of the matrix are split across threads.
+ *
+ * @brief Calculates the transpose of a matrix.
+ * @tparam T The types of elements in the matrix.
+ * @param n The number of elements in the matrix.
+ * @param oldWidth The original width of the matrix.
+ * @param a Pointer to the entries of the matrix.
+ * @param result Pointer to the results array of the matrix.
+ */
+template <typename T>
+void cpuTranspose(size_t n, size_t oldWidth, T* a, T* result);
+
+/**
+ * Swaps each tile above the diagonal with its mirror below it, transposing both, so the matrix
+ * is transposed without a second array. Tiles are split across threads.
+ *
+ * @brief Transposes a square matrix in place.
+ * @tparam T The types of elements in the matrix.
+ * @param width The width and height of the matrix.
+ * @param a Pointer to the entries of the matrix.
+ */
+template <typename T>
+void cpuTransposeSquare(size_t width, T* a);
+
+/**
+ * Computes result = a * b for a row-major m x k matrix a and k x n matrix b. The product
+ * is cache-blocked: panels of b and blocks of a are packed into contiguous buffers sized
+ * for the L1 and L2 caches, then a register-blocked micro-kernel accumulates small tiles
+ * of the result in vector registers. AVX2 and FMA are used when the CPU supports them.
+ * Rows of the result are split across threads once the product is large enough.
+ *
+ * @brief Multiplies matrix a by matrix b, and stores the product in result.
+ * @tparam T The type of the elements in the arrays, either float or double.
+ * @param m The number of rows in a and result.
+ * @param k The number of columns in a and rows in b.
+ * @param n The number of columns in b and result.
+ * @param a Pointer to the m x k left-hand matrix.
+ * @param b Pointer to the k x n right-hand matrix.
+ * @param result Pointer to the m x n product, which must not alias a or b.
+ */
+template <typename T>
+void cpuMatrixMultiply(size_t m, size_t k, size_t n, T* a, T* b, T* result);
+
+/**
+ * Works through each thread's range in blocks small enough that the program's intermediate
+ * values stay in L1, running each step over a whole block so the inner loops vectorise.
+ * Blocks stop at the end of each row, unless the operands and result are all contiguous.
+ *
+ * @brief Runs a fused elementwise program over a rows x columns matrix, and stores the results in result.
+ * @tparam T The type of the elements in the arrays, either float or double.
+ * @param rows The number of rows in result and in each of the program's operands.
+ * @param columns The number of columns in result and in each of the program's operands.
+ * @param program The program to run.
+ * @param result Pointer to the first entry of the result, which must not alias any operand.
+ * @param resultStride The distance between the starts of consecutive rows of result.
+ */
+template <typename T>
+void cpuEvaluate(size_t rows, size_t columns, const ElementwiseProgram<T>& program, T* result, size_t resultStride);
+
+/**
+ * Sums use pairwise summation over blocks that are each spread across several accumulators,
+ * so they vectorise and their rounding error grows with log n rather than n. Large arrays
+ * are split across threads and the partial results combined in order. Strided matrices are
+ * summed pairwise over their rows, then along each row.
+ *
+ * @brief Reduces a matrix, or a pair of matrices, to a single value.
+ * @tparam T The type of the elements in the arrays, either float or double.
+ * @param rows The number of rows in each matrix.
+ * @param columns The number of columns in each matrix.
+ * @param reduction The reduction to run.
+ * @param a Pointer to the first entry of the matrix being reduced.
+ * @param aStride The distance between the starts of consecutive rows of a.
+ * @param b Pointer to the first entry of the second matrix for Reduction::Dot and Reduction::Unequal, otherwise nullptr.
+ * @param bStride The distance between the starts of consecutive rows of b.
+ * @return The result, or the reduction's identity (0, infinity for Min or -infinity for Max) if there are no entries.
+ */
+template <typename T>
+T cpuReduce(size_t rows, size_t columns, Reduction reduction, const T* a, size_t aStride, const T* b, size_t bStride);
+
+/**
+ * @brief Zeroes an array.
+ * @tparam T Type of element in the array.
+ * @param n The size of the array.
+ * @param a Pointer to the array.
+ */
+template <typename T>
+void cpuZeroArray(size_t n, T* a);
+
+/**
+ * @brief Creates an array that represents an identity matrix of dimension 'width'.
+ * @tparam T The type of element in the array.
+ * @param n The number of elements in array 'a'.
+ * @param width The width of the matrix this array represents.
+ * @param a Pointer to the array.
+ */
+template <typename T>
+void cpuIdentityArray(size_t n, size_t width, T* a);
+
+}
+
+#endif //TITANPLUSPLUS_CPUMATH_H
@@ -5,6 +5,8 @@
  * @brief Contains Cuda array math for matrix operations.
  */
 
+#include <algorithm>
+#include <cmath>
 #include "CudaMath.h"
 
 /**
@@ -88,41 +90,259 @@ __global__ void deviceScalarMultiply(size_t n, T* a, T b, T* result) {
     }
 }
 
+const unsigned TransposeTile = 32;  ///< Width and height of the tile each thread block of a transpose moves through shared memory.
+const unsigned TransposeRows = 8;   ///< Rows of threads per transpose block, each thread moves TransposeTile / TransposeRows entries.
+const unsigned MaxGridX = 2147483647; ///< Most thread blocks a grid can have in x.
+const unsigned MaxGridY = 65535;    ///< Most thread blocks a grid can have in y.
+
 /**
- * @brief Performs an element-wise comparison between the provided arrays, and sets equal accordingly.
- * @tparam T The types of elements of each array.
- * @param n The number of elements in each array.
- * @param a The first array.
- * @param b The second array.
- * @param equal Pointer to the result flag.
+ * Launched with TransposeTile x TransposeRows thread blocks. Each block reads a tile of a row by row
+ * into shared memory and writes it out row by row of the result, so both global reads and writes
+ * are coalesced. The tile has one column of padding so the column-wise reads from shared memory
+ * fall in different banks. Blocks stride over the tiles so any shape fits in the grid.
+ *
+ * @brief Calculates the transpose of a height x width matrix.
+ * @tparam T The types of elements in the matrix.
+ * @param height The height of a.
+ * @param width The width of a.
+ * @param a Pointer to the entries of the matrix.
+ * @param result Pointer to the results array of the matrix.
  */
 template <typename T>
-__global__ void deviceEqual(size_t n, T* a, T* b, bool* equal) {
-    for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += blockDim.x * gridDim.x) {
-        if ((a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]) > (a[i] < b[i] ? a[i] : b[i]) * epsilon<T>()) {
-            *equal = false;
-            return;
+__global__ void deviceTranspose(size_t height, size_t width, const T* a, T* result) {
+    __shared__ T tile[TransposeTile][TransposeTile + 1];
+
+    for (size_t tileY = blockIdx.y; tileY * TransposeTile < height; tileY += gridDim.y) {
+        for (size_t tileX = blockIdx.x; tileX * TransposeTile < width; tileX += gridDim.x) {
+            size_t x = tileX * TransposeTile + threadIdx.x;
+            size_t y = tileY * TransposeTile + threadIdx.y;
+            for (unsigned j = 0; j < TransposeTile; j += TransposeRows) {
+                if (x < width && y + j < height) tile[threadIdx.y + j][threadIdx.x] = a[(y + j) * width + x];
+            }
+            __syncthreads();
+
+            x = tileY * TransposeTile + threadIdx.x;
+            y = tileX * TransposeTile + threadIdx.y;
+            for (unsigned j = 0; j < TransposeTile; j += TransposeRows) {
+                if (x < height && y + j < width) result[(y + j) * height + x] = tile[threadIdx.x][threadIdx.y + j];
+            }
+            __syncthreads();
         }
     }
 }
 
 /**
- * @brief Calculates the transpose of a matrix.
+ * Launched like deviceTranspose. Each block above the diagonal loads its tile and the mirrored tile
+ * below the diagonal, then writes each one transposed into the other's place. Blocks on the diagonal
+ * transpose their own tile, and blocks below it have no work.
+ *
+ * @brief Transposes a square matrix in place.
  * @tparam T The types of elements in the matrix.
- * @param n The number of elements in the matrix.
- * @param oldWidth The original width of the matrix.
+ * @param width The width and height of the matrix.
  * @param a Pointer to the entries of the matrix.
- * @param result Pointer to the results array of the matrix.
  */
 template <typename T>
-__global__ void deviceTranspose(size_t n, size_t oldWidth, T* a, T* result) {
+__global__ void deviceTransposeSquare(size_t width, T* a) {
+    __shared__ T upper[TransposeTile][TransposeTile + 1];
+    __shared__ T lower[TransposeTile][TransposeTile + 1];
+
+    for (size_t tileY = blockIdx.y; tileY * TransposeTile < width; tileY += gridDim.y) {
+        for (size_t tileX = blockIdx.x; tileX * TransposeTile < width; tileX += gridDim.x) {
+            if (tileX < tileY) continue;
+            const size_t x = tileX * TransposeTile + threadIdx.x;
+            const size_t y = tileY * TransposeTile + threadIdx.y;
+            const size_t mirrorX = tileY * TransposeTile + threadIdx.x;
+            const size_t mirrorY = tileX * TransposeTile + threadIdx.y;
+            for (unsigned j = 0; j < TransposeTile; j += TransposeRows) {
+                if (x < width && y + j < width) upper[threadIdx.y + j][threadIdx.x] = a[(y + j) * width + x];
+                if (mirrorX < width && mirrorY + j < width) lower[threadIdx.y + j][threadIdx.x] = a[(mirrorY + j) * width + mirrorX];
+            }
+            __syncthreads();
+
+            for (unsigned j = 0; j < TransposeTile; j += TransposeRows) {
+                if (mirrorX < width && mirrorY + j < width) a[(mirrorY + j) * width + mirrorX] = upper[threadIdx.x][threadIdx.y + j];
+                if (x < width && y + j < width) a[(y + j) * width + x] = lower[threadIdx.x][threadIdx.y + j];
+            }
+            __syncthreads();
+        }
+    }
+}
+
+const unsigned TileSize = 16; ///< Width and height of the result tile each thread block of deviceMatrixMultiply computes.
+
+/**
+ * Launched with TileSize x TileSize thread blocks, each thread computes one entry of every result tile its block visits.
+ *
+ * @brief Calculates the product of an m x k matrix and a k x n matrix with tiles staged in shared memory.
+ * @tparam T The types of elements in the matrices.
+ * @param m The number of rows in a and result.
+ * @param k The number of columns in a and rows in b.
+ * @param n The number of columns in b and result.
+ * @param a Pointer to the entries of the left-hand matrix.
+ * @param b Pointer to the entries of the right-hand matrix.
+ * @param result Pointer to the results array of the product.
+ */
+template <typename T>
+__global__ void deviceMatrixMultiply(size_t m, size_t k, size_t n, T* a, T* b, T* result) {
+    __shared__ T aTile[TileSize][TileSize];
+    __shared__ T bTile[TileSize][TileSize];
+
+    //The grid is capped, so blocks stride over the result tiles like the transposes do.
+    for (size_t tileY = blockIdx.y; tileY * TileSize < m; tileY += gridDim.y) {
+        for (size_t tileX = blockIdx.x; tileX * TileSize < n; tileX += gridDim.x) {
+            const size_t row = tileY * TileSize + threadIdx.y;
+            const size_t column = tileX * TileSize + threadIdx.x;
+            T sum = 0;
+            for (size_t tile = 0; tile < k; tile += TileSize) {
+                //Threads outside the matrices load zeroes so every thread can take part in the tile loop.
+                aTile[threadIdx.y][threadIdx.x] = (row < m && tile + threadIdx.x < k) ? a[row * k + tile + threadIdx.x] : 0;
+                bTile[threadIdx.y][threadIdx.x] = (column < n && tile + threadIdx.y < k) ? b[(tile + threadIdx.y) * n + column] : 0;
+                __syncthreads();
+
+                for (unsigned i = 0; i < TileSize; ++i) {
+                    sum += aTile[threadIdx.y][i] * bTile[i][threadIdx.x];
+                }
+                __syncthreads();
+            }
+            if (row < m && column < n) {
+                result[row * n + column] = sum;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Runs a fused elementwise program for each entry of result.
+ * @tparam T The types of elements in the arrays.
+ * @param n The number of elements in result and in each operand.
+ * @param program The program to run.
+ * @param result Pointer to the results array.
+ */
+template <typename T>
+__global__ void deviceEvaluate(size_t n, size_t columns, ElementwiseProgram<T> program, T* result, size_t resultStride) {
+    using Op = typename ElementwiseProgram<T>::Op;
+    for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += blockDim.x * gridDim.x) {
+        const size_t row = i / columns;
+        const size_t column = i % columns;
+        T stack[ElementwiseProgram<T>::MaxDepth];
+        unsigned depth = 0;
+        for (unsigned s = 0; s < program.stepCount; ++s) {
+            const auto& step = program.steps[s];
+            switch (step.op) {
+                case Op::Load:     stack[depth++] = program.operands[step.operand][row * program.strides[step.operand] + column]; break;
+                case Op::Scale:    stack[depth - 1] *= step.scalar;                     break;
+                case Op::Add:      --depth; stack[depth - 1] += stack[depth];          break;
+                case Op::Subtract: --depth; stack[depth - 1] -= stack[depth];          break;
+                case Op::Negate:   stack[depth - 1] = -stack[depth - 1];               break;
+            }
+        }
+        result[row * resultStride + column] = stack[0];
+    }
+}
+
+const unsigned ReduceBlocks = 1024; ///< Most thread blocks a reduction launches, so a single block can combine their results.
+
+/**
+ * @brief Returns the value an entry x of a, and the matching entry y of b, contribute to a reduction.
+ */
+template <Reduction R, typename T>
+__device__ T reduceEntry(T x, T y) {
+    if constexpr (R == Reduction::AbsoluteSum) return x < 0 ? -x : x;
+    else if constexpr (R == Reduction::SquareSum) return x * x;
+    else if constexpr (R == Reduction::Dot) return x * y;
+    else if constexpr (R == Reduction::Unequal) {
+        const T difference = x > y ? x - y : y - x;
+        const T largest = fmax(x < 0 ? -x : x, y < 0 ? -y : y);
+        //Written as !(difference <= limit) so NaN entries count as unequal, as in CpuMath::cpuEqual().
+        return !(difference <= largest * epsilon<T>()) ? T(1) : T(0);
+    }
+    else return x;
+}
+
+/**
+ * @brief Combines two partial results of a reduction.
+ */
+template <Reduction R, typename T>
+__device__ T reduceCombine(T x, T y) {
+    if constexpr (R == Reduction::Min) return y < x ? y : x;
+    else if constexpr (R == Reduction::Max) return y > x ? y : x;
+    else return x + y;
+}
+
+/**
+ * @brief Returns the result of a reduction over no entries.
+ */
+template <Reduction R, typename T>
+__device__ T reduceIdentity() {
+    if constexpr (R == Reduction::Min) return (T)INFINITY;
+    else if constexpr (R == Reduction::Max) return -(T)INFINITY;
+    else return T(0);
+}
+
+/**
+ * Launched with BlockSize threads per block. Each thread reduces its grid-stride entries in a
+ * register, then the block combines its threads' values as a tree in shared memory, halving
+ * the number of active threads each step, and thread 0 writes the block's result.
+ *
+ * @brief Reduces n entries of a matrix to one partial result per thread block.
+ * @tparam R The reduction to run.
+ * @tparam T The types of elements in the arrays.
+ * @param n The number of entries in each matrix.
+ * @param columns The number of columns in each matrix.
+ * @param a Pointer to the first entry of the matrix being reduced.
+ * @param aStride The distance between the starts of consecutive rows of a.
+ * @param b Pointer to the first entry of the second matrix for Reduction::Dot and Reduction::Unequal.
+ * @param bStride The distance between the starts of consecutive rows of b.
+ * @param partials Pointer to one result per thread block, may alias a if there is a single block.
+ */
+template <Reduction R, typename T>
+__global__ void deviceReduce(size_t n, size_t columns, const T* a, size_t aStride, const T* b, size_t bStride, T* partials) {
+    __shared__ T values[BlockSize];
+
+    T value = reduceIdentity<R, T>();
     for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += blockDim.x * gridDim.x) {
-        const size_t x = i % oldWidth;
-        const size_t y = i / oldWidth;
-        result[y + x * (n / oldWidth)] = a[i];
+        const size_t row = i / columns;
+        const size_t column = i % columns;
+        T y = 0;
+        if constexpr (R == Reduction::Dot || R == Reduction::Unequal) y = b[row * bStride + column];
+        value = reduceCombine<R>(value, reduceEntry<R>(a[row * aStride + column], y));
+    }
+    values[threadIdx.x] = value;
+    __syncthreads();
+
+    for (unsigned stride = blockDim.x / 2; stride > 0; stride /= 2) {
+        if (threadIdx.x < stride) {
+            values[threadIdx.x] = reduceCombine<R>(values[threadIdx.x], values[threadIdx.x + stride]);
+        }
+        __syncthreads();
+    }
+    if (threadIdx.x == 0) {
+        partials[blockIdx.x] = values[0];
     }
 }
 
+/**
+ * @brief Reduces a matrix with two launches of deviceReduce, the second combining the first's per-block results.
+ */
+template <Reduction R, typename T>
+T reduce(size_t rows, size_t columns, const T* a, size_t aStride, const T* b, size_t bStride) {
+    //The per-block results are already mapped, so they are only combined.
+    constexpr Reduction combine = R == Reduction::Min || R == Reduction::Max ? R : Reduction::Sum;
+    const size_t n = rows * columns;
+    //At least one block runs, so an empty matrix reduces to the identity.
+    const unsigned blocks = (unsigned)std::clamp<size_t>(GetNumBlocks(n), 1, ReduceBlocks);
+
+    T* partials = nullptr;
+    cudaMalloc(&partials, blocks * sizeof(T));
+    deviceReduce<R, T><<<blocks, BlockSize>>>(n, std::max<size_t>(columns, 1), a, aStride, b, bStride, partials);
+    deviceReduce<combine, T><<<1, BlockSize>>>(blocks, blocks, partials, blocks, nullptr, 0, partials);
+
+    T result = 0;
+    cudaMemcpy(&result, partials, sizeof(T), cudaMemcpyDeviceToHost);
+    cudaFree(partials);
+    return result;
+}
+
 template <typename T>
 __global__ void deviceZeroArray(size_t n, T* a) {
     for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += blockDim.x * gridDim.x) {
@@ -157,28 +377,59 @@ void CudaMath::cudaScalarMultiply(size_t n, T *a, T b, T *result) {
 
 template <typename T>
 bool CudaMath::cudaEqual(size_t n, T *a, T *b) {
-    //Allocate bool
-    bool* deviceEqualFlag = nullptr;
-    cudaMallocManaged(&deviceEqualFlag, sizeof (bool));
-    *deviceEqualFlag = true;
-    //Create host flag
-    bool hostEqualFlag = false;
-    //Run CUDA check and sync threads
-    deviceEqual<T><<<GetNumBlocks(n), BlockSize>>>(n, a, b, deviceEqualFlag);
-    cudaDeviceSynchronize();
-    //Copy flag from device to host
-    cudaMemcpy(&hostEqualFlag, deviceEqualFlag, sizeof (bool), cudaMemcpyDeviceToHost);
-    //Free memory
-    cudaFree(deviceEqualFlag);
-    return hostEqualFlag;
+    return reduce<Reduction::Unequal>(1, n, a, n, b, n) == 0;
+}
+
+/**
+ * @brief Returns the grid that covers a height x width matrix in square tiles, capped at MaxGridX and MaxGridY.
+ */
+inline dim3 tileGrid(size_t height, size_t width, unsigned tile) {
+    return dim3((unsigned)std::clamp<size_t>((width + tile - 1) / tile, 1, MaxGridX),
+                (unsigned)std::clamp<size_t>((height + tile - 1) / tile, 1, MaxGridY));
 }
 
 template <typename T>
 void CudaMath::cudaTranspose(size_t n, size_t oldWidth, T* a, T* result) {
-    deviceTranspose<T><<<GetNumBlocks(n), BlockSize>>>(n, oldWidth, a, result);
+    const size_t oldHeight = n / oldWidth;
+    deviceTranspose<T><<<tileGrid(oldHeight, oldWidth, TransposeTile), dim3(TransposeTile, TransposeRows)>>>(oldHeight, oldWidth, a, result);
+    cudaDeviceSynchronize();
+}
+
+template <typename T>
+void CudaMath::cudaTransposeSquare(size_t width, T* a) {
+    deviceTransposeSquare<T><<<tileGrid(width, width, TransposeTile), dim3(TransposeTile, TransposeRows)>>>(width, a);
+    cudaDeviceSynchronize();
+}
+
+template <typename T>
+void CudaMath::cudaMatrixMultiply(size_t m, size_t k, size_t n, T* a, T* b, T* result) {
+    const dim3 threads(TileSize, TileSize);
+    deviceMatrixMultiply<T><<<tileGrid(m, n, TileSize), threads>>>(m, k, n, a, b, result);
+    cudaDeviceSynchronize();
+}
+
+template <typename T>
+void CudaMath::cudaEvaluate(size_t rows, size_t columns, const ElementwiseProgram<T>& program, T* result, size_t resultStride) {
+    const size_t n = rows * columns;
+    if (n == 0) return;
+    deviceEvaluate<T><<<GetNumBlocks(n), BlockSize>>>(n, columns, program, result, resultStride);
     cudaDeviceSynchronize();
 }
 
+template <typename T>
+T CudaMath::cudaReduce(size_t rows, size_t columns, Reduction reduction, const T* a, size_t aStride, const T* b, size_t bStride) {
+    switch (reduction) {
+        case Reduction::Sum:         return reduce<Reduction::Sum>(rows, columns, a, aStride, b, bStride);
+        case Reduction::AbsoluteSum: return reduce<Reduction::AbsoluteSum>(rows, columns, a, aStride, b, bStride);
+        case Reduction::SquareSum:   return reduce<Reduction::SquareSum>(rows, columns, a, aStride, b, bStride);
+        case Reduction::Dot:         return reduce<Reduction::Dot>(rows, columns, a, aStride, b, bStride);
+        case Reduction::Min:         return reduce<Reduction::Min>(rows, columns, a, aStride, b, bStride);
+        case Reduction::Max:         return reduce<Reduction::Max>(rows, columns, a, aStride, b, bStride);
+        case Reduction::Unequal:     return reduce<Reduction::Unequal>(rows, columns, a, aStride, b, bStride);
+    }
+    return T(0);
+}
+
 template <typename T>
 void CudaMath::cudaZeroArray(size_t n, T *a) {
     deviceZeroArray<<<GetNumBlocks(n), BlockSize>>>(n, a);
@@ -212,6 +463,22 @@ template bool CudaMath::cudaEqual<double>(size_t n, double* a, double* b);
 template void CudaMath::cudaTranspose<float>(size_t n, size_t oldWidth, float* a, float* result);
 template void CudaMath::cudaTranspose<double>(size_t n, size_t oldWidth, double* a, double* result);
 
+//Transpose square
+template void CudaMath::cudaTransposeSquare<float>(size_t width, float* a);
+template void CudaMath::cudaTransposeSquare<double>(size_t width, double* a);
+
+//Matrix multiply
+template void CudaMath::cudaMatrixMultiply<float>(size_t m, size_t k, size_t n, float* a, float* b, float* result);
+template void CudaMath::cudaMatrixMultiply<double>(size_t m, size_t k, size_t n, double* a, double* b, double* result);
+
+//Evaluate
+template void CudaMath::cudaEvaluate<float>(size_t rows, size_t columns, const ElementwiseProgram<float>& program, float* result, size_t resultStride);
+template void CudaMath::cudaEvaluate<double>(size_t rows, size_t columns, const ElementwiseProgram<double>& program, double* result, size_t resultStride);
+
+//Reduce
+template float CudaMath::cudaReduce<float>(size_t rows, size_t columns, Reduction reduction, const float* a, size_t aStride, const float* b, size_t bStride);
+template double CudaMath::cudaReduce<double>(size_t rows, size_t columns, Reduction reduction, const double* a, size_t aStride, const double* b, size_t bStride);
+
 //Zero array
 template void CudaMath::cudaZeroArray<float>(size_t n, float* a);
 template void CudaMath::cudaZeroArray<double>(size_t n, double* a);
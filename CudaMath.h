@@ -10,6 +10,8 @@
 
 #include <utility>
 #include <cfloat>
+#include "ElementwiseProgram.h"
+#include "Reduction.h"
 
 namespace CudaMath {
 /**
@@ -46,10 +48,11 @@ template <typename T>
 void cudaScalarMultiply(size_t n, T* a, T b, T* result);
 
 /**
- * @brief Tests the equality of two matrices.
+ * Counts the unequal entries with a Reduction::Unequal reduction, so every entry is compared.
+ *
+ * @brief Tests the equality of two matrices within a relative epsilon.
  * @tparam T The element types of the provided arrays.
- * @param a_n The number of elements in array a.
- * @param b_n The number of elements in array b.
+ * @param n The number of elements in each array.
  * @param a Pointer to array a.
  * @param b Pointer to array b.
  * @return True if all elements are equal, otherwise false.
@@ -58,6 +61,8 @@ template <typename T>
 bool cudaEqual(size_t n, T* a, T* b);
 
 /**
+ * Moves the matrix a tile at a time through shared memory, so reads and writes are both coalesced.
+ *
  * @brief Calculates the transpose of a matrix.
  * @tparam T The types of elements in the matrix.
  * @param n The number of elements in the matrix.
@@ -68,6 +73,17 @@ bool cudaEqual(size_t n, T* a, T* b);
 template <typename T>
 void cudaTranspose(size_t n, size_t oldWidth, T* a, T* result);
 
+/**
+ * Each thread block swaps a tile above the diagonal with its mirror below it through shared memory.
+ *
+ * @brief Transposes a square matrix in place.
+ * @tparam T The types of elements in the matrix.
+ * @param width The width and height of the matrix.
+ * @param a Pointer to the entries of the matrix.
+ */
+template <typename T>
+void cudaTransposeSquare(size_t width, T* a);
+
 /**
  * @brief Zeroes a CUDA-allocated array.
  * @tparam T Type of element in the array.
@@ -77,6 +93,56 @@ void cudaTranspose(size_t n, size_t oldWidth, T* a, T* result);
 template <typename T>
 void cudaZeroArray(size_t n, T* a);
 
+/**
+ * Each thread block computes a TileSize x TileSize tile of the result, stepping along k one
+ * tile at a time. Every step loads a tile of a and a tile of b into shared memory, so each
+ * entry of a and b is read from global memory once per tile rather than once per product.
+ *
+ * @brief Multiplies the m x k matrix a by the k x n matrix b, and stores the m x n product in result.
+ * @tparam T The type of the elements in the arrays, either float or double.
+ * @param m The number of rows in a and result.
+ * @param k The number of columns in a and rows in b.
+ * @param n The number of columns in b and result.
+ * @param a Pointer to the left-hand matrix.
+ * @param b Pointer to the right-hand matrix.
+ * @param result Pointer to the product.
+ */
+template <typename T>
+void cudaMatrixMultiply(size_t m, size_t k, size_t n, T* a, T* b, T* result);
+
+/**
+ * Each thread runs the whole program for its entries on a stack in registers, so the
+ * expression is evaluated with one kernel launch and one read of each operand.
+ *
+ * @brief Runs a fused elementwise program over a rows x columns matrix, and stores the results in result.
+ * @tparam T The type of the elements in the arrays, either float or double.
+ * @param rows The number of rows in result and in each of the program's operands.
+ * @param columns The number of columns in result and in each of the program's operands.
+ * @param program The program to run, passed to the kernel by value.
+ * @param result Pointer to the first entry of the result.
+ * @param resultStride The distance between the starts of consecutive rows of result.
+ */
+template <typename T>
+void cudaEvaluate(size_t rows, size_t columns, const ElementwiseProgram<T>& program, T* result, size_t resultStride);
+
+/**
+ * Each thread block reduces a grid-stride slice of the matrix as a tree in shared memory,
+ * then a single block combines the blocks' results the same way.
+ *
+ * @brief Reduces a matrix, or a pair of matrices, to a single value.
+ * @tparam T The type of the elements in the arrays, either float or double.
+ * @param rows The number of rows in each matrix.
+ * @param columns The number of columns in each matrix.
+ * @param reduction The reduction to run.
+ * @param a Pointer to the first entry of the matrix being reduced.
+ * @param aStride The distance between the starts of consecutive rows of a.
+ * @param b Pointer to the first entry of the second matrix for Reduction::Dot and Reduction::Unequal, otherwise nullptr.
+ * @param bStride The distance between the starts of consecutive rows of b.
+ * @return The result, or the reduction's identity (0, infinity for Min or -infinity for Max) if there are no entries.
+ */
+template <typename T>
+T cudaReduce(size_t rows, size_t columns, Reduction reduction, const T* a, size_t aStride, const T* b, size_t bStride);
+
 /**
  * @brief Creates an array that represents an identity matrix of dimension 'width'.
  * @tparam T The type of element in the array.
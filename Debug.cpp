@@ -1,3 +1,4 @@
+#include "Builtins.h"
 #include "Debug.h"
 
 void Debug::disassembleBatch(const Batch &batch) {
@@ -36,11 +37,52 @@ int Debug::disassembleInstruction(const Batch &batch, size_t instructionIndex) {
             std::cout << constantIndex << " " << batch.constantPool[constantIndex].toString();
             break;
         }
-        case Op::Constant: {
+        case Op::AddConstant:
+        case Op::Constant:
+        case Op::DivideConstant:
+        case Op::MultiplyConstant:
+        case Op::SubtractConstant: {
             size_t constantIndex = batch.opcodes[instructionIndex + 1];
             std::cout << constantIndex << " " << batch.constantPool[constantIndex].toString();
             break;
         }
+        case Op::CallBuiltin: {
+            std::cout << Builtins::name((Builtins::Function)batch.opcodes[instructionIndex + 1]);
+            break;
+        }
+        case Op::DefineGlobal32:
+        case Op::GetGlobal32:
+        case Op::SetGlobal32: {
+            std::cout << "slot " << Memory::toValue<size_t>(batch.opcodes[instructionIndex + 1], batch.opcodes[instructionIndex + 2]);
+            break;
+        }
+        case Op::DefineGlobal:
+        case Op::GetGlobal:
+        case Op::SetGlobal:
+        case Op::GetLocal:
+        case Op::SetLocal: {
+            std::cout << "slot " << batch.opcodes[instructionIndex + 1];
+            break;
+        }
+        case Op::GetGlobalAddConstant: {
+            size_t constantIndex = batch.opcodes[instructionIndex + 2];
+            std::cout << "slot " << batch.opcodes[instructionIndex + 1] << " " << constantIndex << " " << batch.constantPool[constantIndex].toString();
+            break;
+        }
+        case Op::GetIndex: {
+            std::cout << "flags " << batch.opcodes[instructionIndex + 1];
+            break;
+        }
+        case Op::SetGlobalIndex32: {
+            std::cout << "slot " << Memory::toValue<size_t>(batch.opcodes[instructionIndex + 1], batch.opcodes[instructionIndex + 2])
+                      << " flags " << batch.opcodes[instructionIndex + 3];
+            break;
+        }
+        case Op::SetGlobalIndex:
+        case Op::SetLocalIndex: {
+            std::cout << "slot " << batch.opcodes[instructionIndex + 1] << " flags " << batch.opcodes[instructionIndex + 2];
+            break;
+        }
         default: break;
     }
     std::cout << "\n";
@@ -48,3 +90,96 @@ int Debug::disassembleInstruction(const Batch &batch, size_t instructionIndex) {
     return Op::instructionLength(instructionOpCode);
 }
 
+
+
+void Debug::disassembleRegisterBatch(const RegisterBatch &registers, const Batch &batch) {
+    std::cout << "== Register Batch Disassembly ==\n";
+    std::cout << "[Registers]: " << registers.registers << "\n";
+    std::cout << "[Instructions]:\n";
+    for (size_t instructionIndex = 0; instructionIndex < registers.instructions.size();) {
+        instructionIndex += disassembleRegisterInstruction(registers, batch, instructionIndex);
+    }
+    std::cout << "\n";
+}
+
+int Debug::disassembleRegisterInstruction(const RegisterBatch &registers, const Batch &batch, size_t instructionIndex) {
+    const RegisterOp::Instruction& instruction = registers.instructions[instructionIndex];
+    auto line = [&](size_t index) { return batch.lines[registers.origins[index]]; };
+    auto rk = [&](uint16_t operand) {
+        if (RegisterOp::isConstant(operand)) return "'" + registers.constantPool[operand & ~RegisterOp::ConstantBit].toString() + "'";
+        return "r" + std::to_string(operand);
+    };
+    auto wide = [](uint16_t low, uint16_t high) { return Memory::toValue<size_t>((Op::Code)low, (Op::Code)high); };
+
+    std::cout << instructionIndex << "\t";
+    if (instructionIndex > 0 && line(instructionIndex) == line(instructionIndex - 1)) {
+        std::cout << "| ";
+    }
+    else {
+        std::cout << line(instructionIndex) << " ";
+    }
+    std::cout << RegisterOp::instructionName(instruction.op) << "\t";
+
+    switch (instruction.op) {
+        case RegisterOp::Add:
+        case RegisterOp::Divide:
+        case RegisterOp::Equal:
+        case RegisterOp::Greater:
+        case RegisterOp::GreaterEqual:
+        case RegisterOp::Less:
+        case RegisterOp::LessEqual:
+        case RegisterOp::Multiply:
+        case RegisterOp::NotEqual:
+        case RegisterOp::Subtract:
+            std::cout << "r" << instruction.a << " " << rk(instruction.b) << " " << rk(instruction.c);
+            break;
+        case RegisterOp::Move:
+        case RegisterOp::Negate:
+        case RegisterOp::Not:
+            std::cout << "r" << instruction.a << " " << rk(instruction.b);
+            break;
+        case RegisterOp::Print:
+            std::cout << rk(instruction.a);
+            break;
+        case RegisterOp::CallBuiltin:
+            std::cout << "r" << instruction.a << " " << Builtins::name((Builtins::Function)instruction.b);
+            break;
+        case RegisterOp::DefineGlobal:
+        case RegisterOp::SetGlobal:
+            std::cout << "slot " << instruction.b << " " << rk(instruction.a);
+            break;
+        case RegisterOp::DefineGlobal32:
+        case RegisterOp::SetGlobal32:
+            std::cout << "slot " << wide(instruction.b, instruction.c) << " " << rk(instruction.a);
+            break;
+        case RegisterOp::GetGlobal:
+            std::cout << "r" << instruction.a << " slot " << instruction.b;
+            break;
+        case RegisterOp::GetGlobal32:
+            std::cout << "r" << instruction.a << " slot " << wide(instruction.b, instruction.c);
+            break;
+        case RegisterOp::GetIndex:
+            std::cout << "r" << instruction.a << " flags " << instruction.b;
+            break;
+        case RegisterOp::LoadConstant32: {
+            const size_t constantIndex = wide(instruction.b, instruction.c);
+            std::cout << "r" << instruction.a << " " << constantIndex << " " << registers.constantPool[constantIndex].toString();
+            break;
+        }
+        case RegisterOp::SetGlobalIndex:
+            std::cout << "r" << instruction.a << " flags " << instruction.b << " slot " << instruction.c;
+            break;
+        case RegisterOp::SetGlobalIndex32: {
+            const RegisterOp::Instruction& operands = registers.instructions[instructionIndex + 1];
+            std::cout << "r" << instruction.a << " flags " << instruction.b << " slot " << wide(operands.b, operands.c);
+            break;
+        }
+        case RegisterOp::SetLocalIndex:
+            std::cout << "r" << instruction.a << " flags " << instruction.b << " local r" << instruction.c;
+            break;
+        default: break;
+    }
+    std::cout << "\n";
+
+    return RegisterOp::instructionLength(instruction.op);
+}
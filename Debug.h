@@ -11,6 +11,7 @@
 #include <iostream> //For std::cout
 #include "Ops.h"
 #include "Batch.h"
+#include "RegisterBatch.h"
 #include "Memory.h"
 
 /**
@@ -42,6 +43,24 @@ struct Debug {
      * @return The index of the next instruction in the bytecode stream.
      */
     static int disassembleInstruction(const Batch& batch, size_t instructionIndex);
+
+    /**
+     * Register operands are printed as r<index>, and constant operands as their value.
+     *
+     * @brief Disassembles the instructions of a register batch.
+     * @param registers The register batch to be disassembled.
+     * @param batch The batch it was generated from, for line numbers.
+     */
+    static void disassembleRegisterBatch(const RegisterBatch& registers, const Batch& batch);
+
+    /**
+     * @brief Prints information about the specified register instruction and returns the number of Instructions it takes up.
+     * @param registers The register batch containing the instruction to be disassembled.
+     * @param batch The batch it was generated from, for line numbers.
+     * @param instructionIndex The index of the instruction to be disassembled.
+     * @return The number of Instructions taken up by the instruction and its operands.
+     */
+    static int disassembleRegisterInstruction(const RegisterBatch& registers, const Batch& batch, size_t instructionIndex);
 };
 
 
@@ -0,0 +1,60 @@
+#ifndef TITANPLUSPLUS_ELEMENTWISEPROGRAM_H
+#define TITANPLUSPLUS_ELEMENTWISEPROGRAM_H
+
+/**
+ * @file ElementwiseProgram.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief A fused elementwise matrix expression, in a form both the CPU and CUDA backends can run.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A postfix program over a small stack that computes one entry of a result from the matching
+ * entries of up to MaxOperands matrices. Running the whole program per entry (or per block of
+ * entries on the CPU) evaluates an expression such as a + b - c * 2 in a single pass over
+ * memory, with no temporary arrays. Built by MatrixExpression, run by MatrixBackend::evaluate().
+ *
+ * Operands are read row by row, each with its own row stride, so an operand can be a block of
+ * a larger matrix (see MatrixView) rather than a contiguous array.
+ *
+ * The program is a fixed-size trivially copyable struct so it can be passed to a CUDA kernel
+ * by value.
+ *
+ * @brief A fused elementwise expression over arrays of T.
+ * @tparam T The type of the elements, either float or double.
+ */
+template <typename T>
+struct ElementwiseProgram {
+    static const unsigned MaxSteps = 32;   ///< The most steps a program can have.
+    static const unsigned MaxOperands = 8; ///< The most arrays a program can read.
+    static const unsigned MaxDepth = 8;    ///< The most values a program can have on its stack at once.
+
+    ///The operations a step can perform.
+    enum class Op : uint8_t {
+        Load,     ///< Pushes the entry of operands[operand].
+        Scale,    ///< Multiplies the top of the stack by scalar.
+        Add,      ///< Pops two values and pushes their sum.
+        Subtract, ///< Pops two values and pushes the first minus the second.
+        Negate    ///< Negates the top of the stack.
+    };
+
+    /**
+     * @brief One step of a program.
+     */
+    struct Step {
+        Op op;           ///< The operation to perform.
+        uint8_t operand; ///< The index into operands for Load.
+        T scalar;        ///< The multiplier for Scale.
+    };
+
+    Step steps[MaxSteps];            ///< The steps, in the order they run.
+    const T* operands[MaxOperands];  ///< The first entries of the matrices the program reads, all with the same dimensions.
+    size_t strides[MaxOperands];     ///< The distance between the starts of consecutive rows of each operand.
+    unsigned stepCount = 0;          ///< The number of steps in use.
+    unsigned operandCount = 0;       ///< The number of operands in use.
+};
+
+#endif //TITANPLUSPLUS_ELEMENTWISEPROGRAM_H
@@ -0,0 +1,15 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#include "Globals.h"
+
+size_t Globals::resolve(std::string_view name) {
+    auto slot = slots.find(name);
+    if (slot != slots.end()) return slot->second;
+
+    slots.emplace(name, names.size());
+    names.emplace_back(name);
+    values.push_back(Value::undefined());
+    return names.size() - 1;
+}
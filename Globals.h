@@ -0,0 +1,52 @@
+#ifndef TITANPLUSPLUS_GLOBALS_H
+#define TITANPLUSPLUS_GLOBALS_H
+
+/**
+ * @file Globals.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains the Globals class, the VM's table of global variables.
+ */
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Value.h"
+
+/**
+ * The compiler resolves each global variable name to a dense slot index once, at compile
+ * time, and emits that index as the operand of DefineGlobal and GetGlobal. At runtime a global
+ * access is then a single index into values.
+ *
+ * The VM owns one Globals table and shares it with every compile, so names keep their
+ * slots across VM::interpret calls (e.g. between REPL lines).
+ *
+ * @class Globals
+ * @brief Maps global variable names to slots and stores the value of each slot.
+ */
+struct Globals {
+    /**
+     * @brief Hashes names so slots can be looked up by std::string_view without building a std::string.
+     */
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+    };
+
+    std::unordered_map<std::string, size_t, NameHash, std::equal_to<>> slots; ///< Slot index of each global name.
+    std::vector<std::string> names;                ///< Name of each slot, for error messages.
+    std::vector<Value> values;                     ///< Value of each slot, Value::undefined() until defined.
+
+    /**
+     * Returns the slot for the given name, allocating a new undefined slot
+     * if the name hasn't been seen before.
+     *
+     * @brief Resolves a global variable name to its slot index.
+     * @param name The name of the global variable.
+     * @return The slot index of the global variable.
+     */
+    size_t resolve(std::string_view name);
+};
+
+#endif //TITANPLUSPLUS_GLOBALS_H
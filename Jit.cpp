@@ -0,0 +1,922 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <unordered_map>
+#include <vector>
+#include "Jit.h"
+#include "Memory.h"
+#include "VM.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define TITAN_JIT
+#include <sys/mman.h>
+#endif
+
+NativeBatch::~NativeBatch() {
+#ifdef TITAN_JIT
+    if (code != nullptr) munmap(code, length);
+#endif //TITAN_JIT
+}
+
+NativeBatch::Entry NativeBatch::entry() const {
+    return reinterpret_cast<Entry>(code);
+}
+
+size_t NativeBatch::size() const {
+    return length;
+}
+
+#ifdef TITAN_JIT
+namespace {
+///x86-64 general purpose registers, numbered as in their encodings.
+enum Register : uint8_t {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15,
+};
+
+///Register roles in compiled code. All are callee-saved, so they survive calls into the runtime.
+const Register Top = RBX;       ///< The stack top, the slot the next push writes to.
+const Register Constants = RBP; ///< The batch's constant pool.
+const Register Context = R12;   ///< The NativeContext.
+const Register Frame = R13;     ///< The bottom of the stack, where local slots are counted from.
+const Register NaNMask = R14;   ///< Value::QuietNaN, for testing whether a Value is a number and building immediates.
+const Register Globals = R15;   ///< The values of the global slots.
+
+///Condition codes, added to the Jcc and SETcc opcodes.
+enum Condition : uint8_t {
+    AboveEqual = 0x3,
+    Equal      = 0x4,
+    NotEqual   = 0x5,
+    Above      = 0x7,
+    Parity     = 0xA,
+    NoParity   = 0xB,
+};
+
+///Opcodes of the two-register ALU instructions, in their "r/m64, r64" forms.
+enum Alu : uint8_t {
+    Or   = 0x09,
+    And  = 0x21,
+    Xor  = 0x31,
+    Cmp  = 0x39,
+    Test = 0x85,
+};
+
+///Opcodes of the scalar double instructions, after their F2 0F prefix.
+enum ScalarDouble : uint8_t {
+    AddSD = 0x58,
+    MulSD = 0x59,
+    SubSD = 0x5C,
+    DivSD = 0x5E,
+};
+
+/**
+ * @brief Encodes the handful of x86-64 instructions the templates are built from.
+ */
+class Assembler {
+public:
+    std::vector<uint8_t> code; ///< The machine code emitted so far.
+
+    void bytes(std::initializer_list<uint8_t> values) {
+        code.insert(code.end(), values);
+    }
+
+    void immediate32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) code.push_back((uint8_t)(value >> (8 * i)));
+    }
+
+    ///mov reg, imm64
+    void moveImmediate(Register reg, uint64_t value) {
+        rex(true, 0, reg);
+        bytes({(uint8_t)(0xB8 + (reg & 7))});
+        for (int i = 0; i < 8; ++i) code.push_back((uint8_t)(value >> (8 * i)));
+    }
+
+    ///mov reg32, imm32, which clears the upper half of the register
+    void moveImmediate32(Register reg, uint32_t value) {
+        rex(false, 0, reg);
+        bytes({(uint8_t)(0xB8 + (reg & 7))});
+        immediate32(value);
+    }
+
+    ///mov reg, [base + displacement]
+    void load(Register reg, Register base, int32_t displacement) {
+        rex(true, reg, base);
+        bytes({0x8B});
+        memory(reg, base, displacement);
+    }
+
+    ///mov [base + displacement], reg
+    void store(Register base, int32_t displacement, Register reg) {
+        rex(true, reg, base);
+        bytes({0x89});
+        memory(reg, base, displacement);
+    }
+
+    ///lea reg, [base + displacement]
+    void address(Register reg, Register base, int32_t displacement) {
+        rex(true, reg, base);
+        bytes({0x8D});
+        memory(reg, base, displacement);
+    }
+
+    ///and reg, [base + displacement]
+    void andMemory(Register reg, Register base, int32_t displacement) {
+        rex(true, reg, base);
+        bytes({0x23});
+        memory(reg, base, displacement);
+    }
+
+    ///mov destination, source
+    void move(Register destination, Register source) {
+        alu(0x89, destination, source);
+    }
+
+    ///op destination, source
+    void alu(uint8_t opcode, Register destination, Register source) {
+        rex(true, source, destination);
+        bytes({opcode, direct(source, destination)});
+    }
+
+    ///add reg, imm (extension 0), sub reg, imm (extension 5) or cmp reg, imm (extension 7)
+    void aluImmediate(uint8_t extension, Register reg, int32_t value) {
+        rex(true, 0, reg);
+        if (value >= INT8_MIN && value <= INT8_MAX) {
+            bytes({0x83, direct(extension, reg), (uint8_t)value});
+        }
+        else {
+            bytes({0x81, direct(extension, reg)});
+            immediate32((uint32_t)value);
+        }
+    }
+
+    ///sar reg, imm8
+    void shiftRightArithmetic(Register reg, uint8_t count) {
+        rex(true, 0, reg);
+        bytes({0xC1, direct(7, reg), count});
+    }
+
+    ///btc reg, 63
+    void flipSign(Register reg) {
+        rex(true, 0, reg);
+        bytes({0x0F, 0xBA, direct(7, reg), 63});
+    }
+
+    ///movq xmm, reg
+    void toXmm(int xmm, Register reg) {
+        bytes({0x66});
+        rex(true, xmm, reg);
+        bytes({0x0F, 0x6E, direct(xmm, reg)});
+    }
+
+    ///movq reg, xmm
+    void fromXmm(Register reg, int xmm) {
+        bytes({0x66});
+        rex(true, xmm, reg);
+        bytes({0x0F, 0x7E, direct(xmm, reg)});
+    }
+
+    ///movsd xmm, [base + displacement]
+    void loadDouble(int xmm, Register base, int32_t displacement) {
+        sse(0xF2, 0x10, xmm, base, displacement);
+    }
+
+    ///addsd, subsd, mulsd or divsd xmm, [base + displacement]
+    void scalarDouble(ScalarDouble op, int xmm, Register base, int32_t displacement) {
+        sse(0xF2, op, xmm, base, displacement);
+    }
+
+    ///ucomisd xmm, [base + displacement]
+    void compareDoubles(int xmm, Register base, int32_t displacement) {
+        sse(0x66, 0x2E, xmm, base, displacement);
+    }
+
+    ///ucomisd first, second, which sets the parity flag if either is NaN
+    void compareDoubles(int first, int second) {
+        bytes({0x66});
+        rex(false, first, second);
+        bytes({0x0F, 0x2E, direct(first, second)});
+    }
+
+    ///cmovcc destination, source
+    void moveIf(Condition condition, Register destination, Register source) {
+        rex(true, destination, source);
+        bytes({0x0F, (uint8_t)(0x40 + condition), direct(destination, source)});
+    }
+
+    ///setcc on al (0), cl (1), dl (2) or bl (3)
+    void set(Condition condition, Register reg) {
+        bytes({0x0F, (uint8_t)(0x90 + condition), direct(0, reg)});
+    }
+
+    ///op destination, source on al, cl, dl or bl
+    void aluByte(uint8_t opcode, Register destination, Register source) {
+        bytes({(uint8_t)(opcode - 1), direct(source, destination)});
+    }
+
+    ///movzx reg32, reg8, which clears the upper half of the register too
+    void zeroExtendByte(Register destination, Register source) {
+        bytes({0x0F, 0xB6, direct(destination, source)});
+    }
+
+    ///jcc rel32, returning the position to patch with bind() or patch()
+    size_t jump(Condition condition) {
+        bytes({0x0F, (uint8_t)(0x80 + condition)});
+        immediate32(0);
+        return code.size();
+    }
+
+    ///jmp rel32, returning the position to patch with bind() or patch()
+    size_t jump() {
+        bytes({0xE9});
+        immediate32(0);
+        return code.size();
+    }
+
+    ///call rel32, returning the position to patch with bind() or patch()
+    size_t call() {
+        bytes({0xE8});
+        immediate32(0);
+        return code.size();
+    }
+
+    ///Points a jump or call at the given position in the code.
+    void patch(size_t jump, size_t target) {
+        const int32_t offset = (int32_t)((int64_t)target - (int64_t)jump);
+        std::memcpy(&code[jump - 4], &offset, sizeof(offset));
+    }
+
+    ///Points a jump or call at the next instruction emitted.
+    void bind(size_t jump) {
+        patch(jump, code.size());
+    }
+
+    ///Calls a function outside the code through rax.
+    void callAbsolute(const void* function) {
+        moveImmediate(RAX, reinterpret_cast<uint64_t>(function));
+        bytes({0xFF, 0xD0});
+    }
+
+    void push(Register reg) {
+        rex(false, 0, reg);
+        bytes({(uint8_t)(0x50 + (reg & 7))});
+    }
+
+    void pop(Register reg) {
+        rex(false, 0, reg);
+        bytes({(uint8_t)(0x58 + (reg & 7))});
+    }
+
+    void ret() {
+        bytes({0xC3});
+    }
+
+private:
+    ///Emits a REX prefix with W set for 64-bit operands, extending the ModRM reg and rm fields. Left out if it would be empty.
+    void rex(bool wide, int reg, int rm) {
+        const uint8_t prefix = (uint8_t)(0x40 | (wide << 3) | ((reg >> 3) << 2) | (rm >> 3));
+        if (prefix != 0x40) bytes({prefix});
+    }
+
+    ///ModRM byte for a register operand.
+    static uint8_t direct(int reg, int rm) {
+        return (uint8_t)(0xC0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    ///ModRM (and SIB) bytes and displacement for a [base + displacement] operand, in a single byte where it fits.
+    void memory(int reg, Register base, int32_t displacement) {
+        const bool small = displacement >= INT8_MIN && displacement <= INT8_MAX;
+        bytes({(uint8_t)((small ? 0x40 : 0x80) | ((reg & 7) << 3) | (base & 7))});
+        //rsp and r12 can only be a base through a SIB byte.
+        if ((base & 7) == RSP) bytes({0x24});
+        if (small) bytes({(uint8_t)displacement});
+        else immediate32((uint32_t)displacement);
+    }
+
+    ///A scalar SSE instruction on an xmm register and a memory operand.
+    void sse(uint8_t prefix, uint8_t opcode, int xmm, Register base, int32_t displacement) {
+        bytes({prefix});
+        rex(false, xmm, base);
+        bytes({0x0F, opcode});
+        memory(xmm, base, displacement);
+    }
+};
+
+///What the translator knows about the value in a stack slot when an instruction runs.
+enum class Kind : uint8_t {
+    Any,       ///< Any value.
+    Object,    ///< A string or matrix, which is reference counted and always handled by the runtime.
+    Primitive, ///< A number, boolean or null, none of which are reference counted.
+    Number,    ///< A number.
+};
+
+/**
+ * @brief Stitches together the template of each instruction of a batch.
+ */
+class Translator {
+public:
+    explicit Translator(const Batch& batch) : batch(batch) {}
+
+    std::vector<uint8_t> translate() {
+        for (Register reg : {RBP, RBX, R12, R13, R14, R15}) {
+            a.push(reg);
+        }
+        //Keeps the stack 16-byte aligned for calls into the runtime.
+        a.aluImmediate(5, RSP, 8);
+        a.move(Context, RDI);
+        a.move(Frame, RSI);
+        a.move(Top, RSI);
+        a.move(Globals, RDX);
+        a.moveImmediate(NaNMask, Value::QuietNaN);
+        a.load(Constants, Context, offsetof(NativeContext, constants));
+
+        for (size_t index = 0; index < batch.opcodes.size(); index += Op::instructionLength(batch.opcodes[index])) {
+            if (hasTemplate(index)) {
+                callPending(index);
+                instruction(index);
+                pending = index + Op::instructionLength(batch.opcodes[index]);
+            }
+            else {
+                runtimeInstruction(index, kinds.size());
+            }
+
+            //Checks that failed jump to out-of-line code, emitted after the templates.
+            if (!slowPaths.empty()) runtimeCalls.push_back({std::move(slowPaths), index, a.code.size()});
+            if (!speculations.empty()) resumes.push_back({std::move(speculations), index, 0});
+            slowPaths.clear();
+            speculations.clear();
+        }
+
+        //Runtime errors return nullptr, the Return and the stack machine a non-null pointer.
+        const size_t error = a.code.size();
+        a.alu(Alu::Xor, RAX, RAX);
+        for (size_t jump : returnExits) a.bind(jump);
+        const size_t exit = a.code.size();
+        a.aluImmediate(0, RSP, 8);
+        for (Register reg : {R15, R14, R13, R12, RBX, RBP}) {
+            a.pop(reg);
+        }
+        a.ret();
+
+        //Jumped to with the instruction index in rdx, and finishes the batch.
+        const size_t resume = a.code.size();
+        a.move(RDI, Context);
+        a.move(RSI, Top);
+        a.callAbsolute(reinterpret_cast<const void*>(&VM::nativeResume));
+        a.patch(a.jump(), exit);
+
+        for (const ColdPath& path : runtimeCalls) {
+            for (size_t jump : path.jumps) a.bind(jump);
+            callRuntime(path.index);
+            a.patch(a.jump(), path.resume);
+        }
+        for (const ColdPath& path : resumes) {
+            for (size_t jump : path.jumps) a.bind(jump);
+            a.moveImmediate32(RDX, (uint32_t)path.index);
+            a.patch(a.jump(), resume);
+        }
+
+        //Each op's step is called with the instruction index in rdx, and returns with the new stack top.
+        for (size_t op = 0; op < Op::Code::SIZE; ++op) {
+            if (!stepCalls[op].empty()) runtimeStub(stepCalls[op], reinterpret_cast<const void*>(VM::nativeStep((Op::Code)op)), error);
+        }
+        //Runs are called with their first index in rdx and the index after them in rcx.
+        if (!runCalls.empty()) runtimeStub(runCalls, reinterpret_cast<const void*>(&VM::nativeRun), error);
+        return std::move(a.code);
+    }
+
+    /**
+     * @brief Emits a stub that calls a runtime function with the context and stack top, and leaves through the error exit if it fails.
+     */
+    void runtimeStub(const std::vector<size_t>& calls, const void* function, size_t error) {
+        for (size_t call : calls) a.bind(call);
+        a.aluImmediate(5, RSP, 8);
+        a.move(RDI, Context);
+        a.move(RSI, Top);
+        a.callAbsolute(function);
+        a.aluImmediate(0, RSP, 8);
+        a.alu(Alu::Test, RAX, RAX);
+        const size_t failed = a.jump(Equal);
+        a.move(Top, RAX);
+        a.ret();
+        a.bind(failed);
+        //Drops the return address before leaving.
+        a.aluImmediate(0, RSP, 8);
+        a.patch(a.jump(), error);
+    }
+
+private:
+    /**
+     * @brief Jumps from a template's checks to out-of-line code for its instruction.
+     */
+    struct ColdPath {
+        std::vector<size_t> jumps; ///< The jumps to patch.
+        size_t index;              ///< The index of the instruction.
+        size_t resume;             ///< Where native code continues after a call into the runtime.
+    };
+
+    const Batch& batch;                ///< The batch being compiled.
+    Assembler a;                       ///< The code being emitted.
+    std::vector<Kind> kinds;           ///< What is known about each slot of the stack.
+    std::unordered_map<size_t, Kind> globalKinds; ///< What is known about the globals the batch has assigned.
+    std::vector<size_t> slowPaths;     ///< Jumps from the current template's checks to a call that runs its instruction.
+    std::vector<size_t> speculations;  ///< Jumps from the current template's checks to the stack machine.
+    std::vector<ColdPath> runtimeCalls; ///< Out-of-line calls that run one instruction.
+    std::vector<ColdPath> resumes;     ///< Out-of-line exits to the stack machine.
+    std::array<std::vector<size_t>, Op::Code::SIZE> stepCalls; ///< Calls to each op's step in the runtime.
+    std::vector<size_t> runCalls;      ///< Calls to VM::nativeRun().
+    size_t pending = 0;                ///< The first instruction without a template that hasn't been called yet, or the current one if there are none.
+    std::vector<size_t> returnExits;   ///< Jumps to the normal exit.
+
+    static const size_t MaxSlot = INT32_MAX / sizeof(Value); ///< The last slot a 32-bit displacement can reach.
+
+    const Value& constant(size_t index) const {
+        return batch.constantPool[index];
+    }
+
+    /**
+     * @brief Returns the byte offset of a value slot, which must be at most MaxSlot.
+     */
+    static int32_t slotOffset(size_t slot) {
+        return (int32_t)(slot * sizeof(Value));
+    }
+
+    /**
+     * @brief Returns the byte offset from the stack top of the value n slots below it.
+     */
+    static int32_t below(int n) {
+        return -n * (int32_t)sizeof(Value);
+    }
+
+    /**
+     * @brief Returns what is known about a global, which is nothing unless the batch has assigned it.
+     */
+    Kind globalKind(size_t slot) const {
+        const auto kind = globalKinds.find(slot);
+        return kind != globalKinds.end() ? kind->second : Kind::Any;
+    }
+
+    /**
+     * Instructions on values known to be Objects always go to the runtime, since their
+     * templates would only ever take their slow paths.
+     *
+     * @brief Returns true if the instruction at the given index has a template for what is known about its operands.
+     */
+    bool hasTemplate(size_t index) const {
+        const Op::Code* code = &batch.opcodes[index];
+        auto wideOperand = [&] { return Memory::toValue<size_t>(code[1], code[2]); };
+        auto isObject = [&](size_t below) { return kinds[kinds.size() - below] == Kind::Object; };
+
+        switch (code[0]) {
+            case Op::Code::Add:
+            case Op::Code::Subtract:
+            case Op::Code::Multiply:
+            case Op::Code::Divide:
+            case Op::Code::Greater:
+            case Op::Code::GreaterEqual:
+            case Op::Code::Less:
+            case Op::Code::LessEqual:
+                return !isObject(2) && !isObject(1);
+            case Op::Code::AddConstant:
+            case Op::Code::SubtractConstant:
+            case Op::Code::MultiplyConstant:
+            case Op::Code::DivideConstant:
+                return constant(code[1]).isNumber() && !isObject(1);
+            //Only numbers are compared inline, since strings and matrices are equal by value.
+            case Op::Code::Equal:
+            case Op::Code::NotEqual:
+                return kinds[kinds.size() - 2] == Kind::Number && kinds.back() == Kind::Number;
+            case Op::Code::Constant:   return !constant(code[1]).isObject();
+            case Op::Code::Constant32: return wideOperand() <= MaxSlot && !constant(wideOperand()).isObject();
+            case Op::Code::False:
+            case Op::Code::True:
+            case Op::Code::Null:
+            case Op::Code::Return:
+                return true;
+            case Op::Code::Negate:
+            case Op::Code::Not:
+            case Op::Code::Pop:
+                return !isObject(1);
+            case Op::Code::GetLocal:
+                return kinds[code[1]] != Kind::Object;
+            case Op::Code::SetLocal:
+                return kinds[code[1]] != Kind::Object && !isObject(1);
+            case Op::Code::GetGlobal:   return globalKind(code[1]) != Kind::Object;
+            case Op::Code::GetGlobal32: return wideOperand() <= MaxSlot && globalKind(wideOperand()) != Kind::Object;
+            case Op::Code::GetGlobalAddConstant:
+                return constant(code[2]).isNumber() && globalKind(code[1]) != Kind::Object;
+            case Op::Code::DefineGlobal:   return globalKind(code[1]) != Kind::Object;
+            case Op::Code::DefineGlobal32: return wideOperand() <= MaxSlot && globalKind(wideOperand()) != Kind::Object;
+            case Op::Code::SetGlobal:      return globalKind(code[1]) != Kind::Object && !isObject(1);
+            case Op::Code::SetGlobal32:    return wideOperand() <= MaxSlot && globalKind(wideOperand()) != Kind::Object && !isObject(1);
+            default:
+                //Print, built-ins and subscripts always call into the runtime.
+                return false;
+        }
+    }
+
+    /**
+     * @brief Emits the template of the instruction at the given index, which must have one.
+     */
+    void instruction(size_t index) {
+        const Op::Code* code = &batch.opcodes[index];
+        auto wideOperand = [&] { return Memory::toValue<size_t>(code[1], code[2]); };
+
+        switch (code[0]) {
+            case Op::Code::Add:      binary(AddSD); break;
+            case Op::Code::Subtract: binary(SubSD); break;
+            case Op::Code::Multiply: binary(MulSD); break;
+            case Op::Code::Divide:   binary(DivSD); break;
+            case Op::Code::AddConstant:      binaryConstant(AddSD, code[1]); break;
+            case Op::Code::SubtractConstant: binaryConstant(SubSD, code[1]); break;
+            case Op::Code::MultiplyConstant: binaryConstant(MulSD, code[1]); break;
+            case Op::Code::DivideConstant:   binaryConstant(DivSD, code[1]); break;
+            case Op::Code::Greater:      compare(Above, false);      break;
+            case Op::Code::GreaterEqual: compare(AboveEqual, false); break;
+            case Op::Code::Less:         compare(Above, true);       break;
+            case Op::Code::LessEqual:    compare(AboveEqual, true);  break;
+            case Op::Code::Equal:        equal(false);               break;
+            case Op::Code::NotEqual:     equal(true);                break;
+            case Op::Code::Constant:   pushConstant(code[1]);         break;
+            case Op::Code::Constant32: pushConstant(wideOperand());   break;
+            case Op::Code::False:      pushTag(Value::FalseTag);      break;
+            case Op::Code::True:       pushTag(Value::TrueTag);       break;
+            case Op::Code::Null:       pushTag(Value::NilTag);        break;
+            case Op::Code::Negate:
+                speculateNumber(kinds.size() - 1);
+                a.load(RAX, Top, below(1));
+                a.flipSign(RAX);
+                a.toXmm(0, RAX);
+                storeNumber(below(1));
+                break;
+            case Op::Code::Not:
+                logicalNot();
+                break;
+            case Op::Code::Pop:
+                //Popped objects must be released, other values can be left behind.
+                if (kinds.back() == Kind::Any) {
+                    a.load(RAX, Top, below(1));
+                    ifObject(RAX);
+                }
+                a.aluImmediate(5, Top, sizeof(Value));
+                kinds.pop_back();
+                break;
+            case Op::Code::GetLocal: {
+                const Kind kind = kinds[code[1]];
+                a.load(RAX, Frame, slotOffset(code[1]));
+                if (kind == Kind::Any) ifObject(RAX);
+                push(RAX, kind);
+                break;
+            }
+            case Op::Code::SetLocal:    setLocal(code[1]);         break;
+            case Op::Code::GetGlobal:   getGlobal(code[1]);        break;
+            case Op::Code::GetGlobal32: getGlobal(wideOperand());  break;
+            case Op::Code::GetGlobalAddConstant:
+                a.load(RAX, Globals, slotOffset(code[1]));
+                //Undefined globals and non-numbers both fail the number check.
+                if (globalKind(code[1]) != Kind::Number) unlessNumber(RAX, speculations);
+                a.toXmm(0, RAX);
+                a.scalarDouble(AddSD, 0, Constants, slotOffset(code[2]));
+                storeNumber(0);
+                a.aluImmediate(0, Top, sizeof(Value));
+                kinds.push_back(Kind::Number);
+                break;
+            case Op::Code::DefineGlobal:   defineGlobal(code[1]);       break;
+            case Op::Code::DefineGlobal32: defineGlobal(wideOperand()); break;
+            case Op::Code::SetGlobal:      setGlobal(code[1]);          break;
+            case Op::Code::SetGlobal32:    setGlobal(wideOperand());    break;
+            case Op::Code::Return:
+                a.move(RAX, Top);
+                returnExits.push_back(a.jump());
+                break;
+            default:
+                break;
+        }
+    }
+
+    /**
+     * @brief Updates what is known about the values an instruction without a template may have written.
+     */
+    void runtimeInstruction(size_t index, size_t depth) {
+        const Op::Code* code = &batch.opcodes[index];
+        auto wideOperand = [&] { return Memory::toValue<size_t>(code[1], code[2]); };
+
+        //Every instruction leaves any result it has at the stack top, and only writes locals and globals it assigns.
+        Kind result = Kind::Any;
+        switch (code[0]) {
+            case Op::Code::Constant:
+            case Op::Code::Constant32: {
+                const Value& value = constant(code[0] == Op::Code::Constant ? (size_t)code[1] : wideOperand());
+                result = value.isObject() ? Kind::Object : Kind::Any;
+                break;
+            }
+            case Op::Code::GetGlobal:   result = globalKind(code[1]);       break;
+            case Op::Code::GetGlobal32: result = globalKind(wideOperand()); break;
+            case Op::Code::GetLocal:    result = kinds[code[1]];            break;
+            case Op::Code::DefineGlobal:
+            case Op::Code::SetGlobal:
+                globalKinds[code[1]] = kinds.back();
+                break;
+            case Op::Code::DefineGlobal32:
+            case Op::Code::SetGlobal32:
+                globalKinds[wideOperand()] = kinds.back();
+                break;
+            case Op::Code::SetLocal:
+                kinds[code[1]] = kinds.back();
+                break;
+            case Op::Code::SetLocalIndex:
+                kinds[code[1]] = Kind::Any;
+                break;
+            default:
+                break;
+        }
+
+        const bool pushes = code[0] != Op::Code::DefineGlobal && code[0] != Op::Code::DefineGlobal32
+                            && code[0] != Op::Code::Pop && code[0] != Op::Code::Print;
+        const bool keeps = code[0] == Op::Code::SetGlobal || code[0] == Op::Code::SetGlobal32 || code[0] == Op::Code::SetLocal;
+        kinds.resize(depth + Op::stackEffect(code));
+        if (pushes && !keeps && !kinds.empty()) kinds.back() = result;
+    }
+
+    /**
+     * A single instruction calls its op's step, while longer runs are dispatched by VM::nativeRun().
+     *
+     * @brief Emits the call into the runtime for the instructions without templates before the given index.
+     */
+    void callPending(size_t index) {
+        if (pending == index) return;
+        if (index == pending + Op::instructionLength(batch.opcodes[pending])) {
+            callRuntime(pending);
+        }
+        else {
+            a.moveImmediate32(RDX, (uint32_t)pending);
+            a.moveImmediate32(RCX, (uint32_t)index);
+            runCalls.push_back(a.call());
+        }
+        pending = index;
+    }
+
+    /**
+     * @brief Calls the step of the instruction at the given index, which runs it in the runtime.
+     */
+    void callRuntime(size_t index) {
+        a.moveImmediate32(RDX, (uint32_t)index);
+        stepCalls[batch.opcodes[index]].push_back(a.call());
+    }
+
+    /**
+     * The same test as Value::isNumber(). Value::fromNumber() and storeNumber() both
+     * canonicalise NaNs, so no number native code handles has the quiet NaN bits of a
+     * boxed Value.
+     *
+     * @brief Jumps to the given exits if the Value in reg isn't a number. Clobbers rdx.
+     */
+    void unlessNumber(Register reg, std::vector<size_t>& exits) {
+        a.move(RDX, NaNMask);
+        a.alu(Alu::And, RDX, reg);
+        a.alu(Alu::Cmp, RDX, NaNMask);
+        exits.push_back(a.jump(Equal));
+    }
+
+    /**
+     * Objects are the only Values whose top 14 bits are all set, the same test as
+     * Value::isObject(), see unlessNumber() for why no number matches it.
+     *
+     * @brief Jumps to the runtime call if the Value in reg is an Object, which needs reference counting. Clobbers rdx.
+     */
+    void ifObject(Register reg) {
+        a.move(RDX, reg);
+        a.shiftRightArithmetic(RDX, 50);
+        a.aluImmediate(7, RDX, -1);
+        slowPaths.push_back(a.jump(Equal));
+    }
+
+    /**
+     * @brief Leaves native code for the stack machine unless the given stack slot holds a number. Clobbers rdx.
+     */
+    void speculateNumber(size_t slot) {
+        if (kinds[slot] == Kind::Number) return;
+        a.move(RDX, NaNMask);
+        a.andMemory(RDX, Top, below((int)(kinds.size() - slot)));
+        a.alu(Alu::Cmp, RDX, NaNMask);
+        speculations.push_back(a.jump(Equal));
+        kinds[slot] = Kind::Number;
+    }
+
+    /**
+     * @brief Turns the 0 or 1 in al into false or true and stores it at the given offset from the stack top.
+     */
+    void storeBool(int32_t offset) {
+        a.zeroExtendByte(RAX, RAX);
+        a.alu(Alu::Or, RAX, NaNMask);
+        a.aluImmediate(0, RAX, Value::FalseTag);
+        a.store(Top, offset, RAX);
+    }
+
+    void push(Register reg, Kind kind) {
+        a.store(Top, 0, reg);
+        a.aluImmediate(0, Top, sizeof(Value));
+        kinds.push_back(kind);
+    }
+
+    /**
+     * @brief Pops the right operand of a binary op, whose result replaced the left.
+     */
+    void popOperand(Kind result) {
+        a.aluImmediate(5, Top, sizeof(Value));
+        kinds.pop_back();
+        kinds.back() = result;
+    }
+
+    /**
+     * SSE arithmetic produces x86's default NaN, which has its sign bit set, and negation flips
+     * the sign of a NaN, so a NaN result is replaced with Value::CanonicalNaN as
+     * Value::fromNumber() does.
+     *
+     * @brief Stores the number in xmm0 at the given offset from the stack top. Clobbers rax and rcx.
+     */
+    void storeNumber(int32_t offset) {
+        a.fromXmm(RAX, 0);
+        a.moveImmediate(RCX, Value::CanonicalNaN);
+        a.compareDoubles(0, 0);
+        a.moveIf(Parity, RAX, RCX);
+        a.store(Top, offset, RAX);
+    }
+
+    void binary(ScalarDouble op) {
+        speculateNumber(kinds.size() - 2);
+        speculateNumber(kinds.size() - 1);
+        a.loadDouble(0, Top, below(2));
+        a.scalarDouble(op, 0, Top, below(1));
+        storeNumber(below(2));
+        popOperand(Kind::Number);
+    }
+
+    void binaryConstant(ScalarDouble op, size_t rhs) {
+        speculateNumber(kinds.size() - 1);
+        a.loadDouble(0, Top, below(1));
+        a.scalarDouble(op, 0, Constants, slotOffset(rhs));
+        storeNumber(below(1));
+    }
+
+    /**
+     * ucomisd sets the carry and zero flags for unordered operands, so comparisons with
+     * NaN are false, as in C++.
+     *
+     * @brief Compares the two numbers at the top of the stack, swapping them to test less than.
+     */
+    void compare(Condition condition, bool swap) {
+        speculateNumber(kinds.size() - 2);
+        speculateNumber(kinds.size() - 1);
+        a.loadDouble(0, Top, below(swap ? 1 : 2));
+        a.compareDoubles(0, Top, below(swap ? 2 : 1));
+        a.set(condition, RAX);
+        storeBool(below(2));
+        popOperand(Kind::Primitive);
+    }
+
+    /**
+     * @brief Tests the two numbers at the top of the stack for equality, which is false if either is NaN.
+     */
+    void equal(bool negate) {
+        a.loadDouble(0, Top, below(2));
+        a.compareDoubles(0, Top, below(1));
+        if (negate) {
+            a.set(NotEqual, RAX);
+            a.set(Parity, RDX);
+            a.aluByte(Alu::Or, RAX, RDX);
+        }
+        else {
+            a.set(Equal, RAX);
+            a.set(NoParity, RDX);
+            a.aluByte(Alu::And, RAX, RDX);
+        }
+        storeBool(below(2));
+        popOperand(Kind::Primitive);
+    }
+
+    void pushConstant(size_t index) {
+        a.load(RAX, Constants, slotOffset(index));
+        push(RAX, constant(index).isNumber() ? Kind::Number : Kind::Primitive);
+    }
+
+    void pushTag(uint64_t tag) {
+        a.address(RAX, NaNMask, (int32_t)tag);
+        push(RAX, Kind::Primitive);
+    }
+
+    /**
+     * Numbers are never falsey, anything else is compared with null and false.
+     */
+    void logicalNot() {
+        const Kind kind = kinds.back();
+        kinds.back() = Kind::Primitive;
+        if (kind == Kind::Number) {
+            a.address(RAX, NaNMask, Value::FalseTag);
+            a.store(Top, below(1), RAX);
+            return;
+        }
+        a.load(RAX, Top, below(1));
+        if (kind == Kind::Any) ifObject(RAX);
+        a.address(RCX, NaNMask, Value::NilTag);
+        a.alu(Alu::Cmp, RAX, RCX);
+        a.set(Equal, RDX);
+        a.address(RCX, NaNMask, Value::FalseTag);
+        a.alu(Alu::Cmp, RAX, RCX);
+        a.set(Equal, RAX);
+        a.aluByte(Alu::Or, RAX, RDX);
+        storeBool(below(1));
+    }
+
+    void setLocal(size_t slot) {
+        a.load(RAX, Top, below(1));
+        if (kinds.back() == Kind::Any) ifObject(RAX);
+        if (kinds[slot] == Kind::Any) {
+            a.load(RCX, Frame, slotOffset(slot));
+            ifObject(RCX);
+        }
+        a.store(Frame, slotOffset(slot), RAX);
+        kinds[slot] = kinds.back();
+    }
+
+    /**
+     * Globals the batch hasn't assigned are speculated to be numbers, anything else is left to the stack machine.
+     */
+    void getGlobal(size_t slot) {
+        const Kind kind = globalKind(slot);
+        a.load(RAX, Globals, slotOffset(slot));
+        //Globals the batch has assigned are defined.
+        if (kind == Kind::Any) unlessNumber(RAX, speculations);
+        push(RAX, kind == Kind::Any ? Kind::Number : kind);
+    }
+
+    void defineGlobal(size_t slot) {
+        //The value is moved, so only an Object it replaces needs releasing.
+        if (globalKind(slot) == Kind::Any) {
+            a.load(RCX, Globals, slotOffset(slot));
+            ifObject(RCX);
+        }
+        a.load(RAX, Top, below(1));
+        a.store(Globals, slotOffset(slot), RAX);
+        if (kinds.back() == Kind::Any || kinds.back() == Kind::Object) {
+            //Slots above the top mustn't hold a copy of an Object.
+            a.address(RCX, NaNMask, Value::NilTag);
+            a.store(Top, below(1), RCX);
+        }
+        a.aluImmediate(5, Top, sizeof(Value));
+        globalKinds[slot] = kinds.back();
+        kinds.pop_back();
+    }
+
+    void setGlobal(size_t slot) {
+        if (globalKind(slot) == Kind::Any) {
+            a.load(RCX, Globals, slotOffset(slot));
+            ifObject(RCX);
+            a.address(RAX, NaNMask, Value::UndefinedTag);
+            a.alu(Alu::Cmp, RCX, RAX);
+            slowPaths.push_back(a.jump(Equal));
+        }
+        a.load(RAX, Top, below(1));
+        if (kinds.back() == Kind::Any) ifObject(RAX);
+        a.store(Globals, slotOffset(slot), RAX);
+        globalKinds[slot] = kinds.back();
+    }
+};
+}
+#endif //TITAN_JIT
+
+bool Jit::isAvailable() {
+#ifdef TITAN_JIT
+    return true;
+#else
+    return false;
+#endif //TITAN_JIT
+}
+
+bool Jit::compile(const Batch &batch, NativeBatch &native) {
+#ifdef TITAN_JIT
+    //Instruction indices are passed to the runtime as 32-bit immediates.
+    if (batch.opcodes.size() > UINT32_MAX) return false;
+    Translator translator(batch);
+    const std::vector<uint8_t> code = translator.translate();
+
+    //Written through a writable mapping, which is then made executable and read-only.
+    void* mapping = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) return false;
+    std::memcpy(mapping, code.data(), code.size());
+    if (mprotect(mapping, code.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(mapping, code.size());
+        return false;
+    }
+    native.code = mapping;
+    native.length = code.size();
+    return true;
+#else
+    return false;
+#endif //TITAN_JIT
+}
@@ -0,0 +1,107 @@
+#ifndef TITANPLUSPLUS_JIT_H
+#define TITANPLUSPLUS_JIT_H
+
+/**
+ * @file Jit.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains the Jit class, a baseline compiler from batches to x86-64 machine code, and the NativeBatch it produces.
+ */
+
+#include <cstddef>
+#include "Batch.h"
+
+class VM;
+
+/**
+ * @brief The state native code passes back to the VM when it calls into the runtime.
+ */
+struct NativeContext {
+    VM* vm;       ///< The VM running the code.
+    Batch* batch; ///< The batch the code was compiled from.
+    Value* frame; ///< The bottom of the value stack, where local variable slots are counted from.
+    const Value* constants; ///< The batch's constant pool, which number constants are read from.
+};
+
+///The signature of the functions native code calls to run one instruction, see VM::nativeStep(Op::Code).
+using NativeStep = Value* (*)(NativeContext* context, Value* top, size_t instructionIndex);
+
+/**
+ * Owns an executable mapping of the code, which is released when the NativeBatch is destroyed.
+ *
+ * @class NativeBatch
+ * @brief Machine code compiled from a batch by Jit, run by VM::interpret(Batch&, NativeBatch&).
+ */
+class NativeBatch {
+public:
+    /**
+     * @brief The signature of the compiled code.
+     * @param context The runtime state, passed on to calls into the runtime.
+     * @param frame The bottom of a stack of at least Batch::maxStackDepth values.
+     * @param globals The values of the VM's global slots.
+     * @return A non-null pointer once the batch returns, or nullptr after a runtime error.
+     */
+    using Entry = Value* (*)(NativeContext* context, Value* frame, Value* globals);
+
+    NativeBatch() = default;
+
+    /**
+     * @brief Unmaps the code.
+     */
+    ~NativeBatch();
+
+    NativeBatch(const NativeBatch&) = delete;
+    NativeBatch& operator=(const NativeBatch&) = delete;
+
+    /**
+     * @brief Returns the compiled code's entry point.
+     */
+    Entry entry() const;
+
+    /**
+     * @brief Returns the size of the machine code in bytes.
+     */
+    size_t size() const;
+
+private:
+    friend struct Jit;
+
+    void* code = nullptr;  ///< The executable mapping.
+    size_t length = 0;     ///< The size of the mapping in bytes.
+};
+
+/**
+ * A baseline template JIT: each stack instruction is translated on its own into a fixed
+ * sequence of x86-64 instructions, with no register allocation across instructions. The
+ * value stack stays in memory, with its top held in a callee-saved register.
+ *
+ * Since Titan has no jumps, the compiler knows the depth of the stack and what kind of
+ * value each slot holds at every instruction, so a number that is already known to be one
+ * isn't checked again. Globals and the operands of arithmetic are speculated to be numbers:
+ * a value that fails the check leaves native code, and the rest of the batch is run by the
+ * stack machine through VM::nativeResume(). Print, built-ins, subscripts, strings, matrices
+ * and any other instruction without a template call into the runtime, VM::nativeStep(Op::Code)
+ * for a single instruction or VM::nativeRun() for several in a row, which run them through
+ * the interpreter's own helpers, so both produce the same results and runtime errors.
+ *
+ * Only available on Linux x86-64, elsewhere compile() always fails.
+ *
+ * @class Jit
+ * @brief Compiles batches into native code.
+ */
+struct Jit {
+    /**
+     * @brief Returns true if Titan can compile batches to native code on this platform.
+     */
+    static bool isAvailable();
+
+    /**
+     * @brief Compiles a batch into native code.
+     * @param batch The compiled batch, which must end in a Return.
+     * @param native The native batch to compile into, which must be empty.
+     * @return True if the batch was compiled, otherwise false if the JIT isn't available or the code can't be mapped.
+     */
+    static bool compile(const Batch& batch, NativeBatch& native);
+};
+
+#endif //TITANPLUSPLUS_JIT_H
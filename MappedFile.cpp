@@ -0,0 +1,111 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#include <utility>
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif //_WIN32
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    std::swap(fileData, other.fileData);
+    std::swap(fileSize, other.fileSize);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    std::swap(fileData, other.fileData);
+    std::swap(fileSize, other.fileSize);
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path, Access access) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    fileSize = (size_t)size.QuadPart;
+
+    //Empty files can't be mapped, but are valid (empty) sources.
+    if (fileSize > 0) {
+        const bool copyOnWrite = access == Access::CopyOnWrite;
+        HANDLE mapping = CreateFileMappingA(file, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            fileData = static_cast<const char*>(MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat status{};
+    if (fstat(file, &status) != 0) {
+        ::close(file);
+        return false;
+    }
+    fileSize = (size_t)status.st_size;
+
+    //Empty files can't be mapped, but are valid (empty) sources.
+    if (fileSize > 0) {
+        const int protection = access == Access::CopyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* mapping = mmap(nullptr, fileSize, protection, MAP_PRIVATE, file, 0);
+        if (mapping != MAP_FAILED) {
+            fileData = static_cast<const char*>(mapping);
+        }
+    }
+    ::close(file);
+#endif //_WIN32
+
+    if (fileSize > 0 && fileData == nullptr) {
+        fileSize = 0;
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (fileData != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(fileData);
+#else
+        munmap(const_cast<char*>(fileData), fileSize);
+#endif //_WIN32
+    }
+    fileData = nullptr;
+    fileSize = 0;
+}
+
+const char* MappedFile::data() const {
+    return fileData;
+}
+
+char* MappedFile::writableData() {
+    return const_cast<char*>(fileData);
+}
+
+size_t MappedFile::size() const {
+    return fileSize;
+}
+
+std::string_view MappedFile::view() const {
+    return {fileData, fileSize};
+}
@@ -0,0 +1,90 @@
+#ifndef TITANPLUSPLUS_MAPPEDFILE_H
+#define TITANPLUSPLUS_MAPPEDFILE_H
+
+/**
+ * @file MappedFile.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains the MappedFile class, a memory-mapped file.
+ */
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * Maps a whole file into memory, so its contents can be read without copying
+ * them into a buffer first. The mapping is released when the object is destroyed.
+ *
+ * @class MappedFile
+ * @brief A memory-mapped file.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief How a file is mapped.
+     */
+    enum class Access {
+        ReadOnly,    ///< The mapping can only be read.
+        CopyOnWrite, ///< The mapping can be written, copying each page written to, and the file never changes.
+    };
+
+    MappedFile() = default;
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Takes over another file's mapping, leaving it closed.
+     */
+    MappedFile(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Takes over another file's mapping, leaving it closed.
+     */
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Maps the file at the given path, unmapping any previously mapped file.
+     * @param path The path of the file to map.
+     * @param access Whether the mapping can be written to.
+     * @return True if the file was mapped, otherwise false.
+     */
+    bool open(const std::string& path, Access access = Access::ReadOnly);
+
+    /**
+     * @brief Unmaps the file, if one is mapped.
+     */
+    void close();
+
+    /**
+     * @brief Returns a pointer to the first byte of the file.
+     */
+    const char* data() const;
+
+    /**
+     * @brief Returns a writable pointer to the first byte of the file, which must have been opened with Access::CopyOnWrite.
+     */
+    char* writableData();
+
+    /**
+     * @brief Returns the size of the file in bytes.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the contents of the file as a string view.
+     */
+    std::string_view view() const;
+
+protected:
+    const char* fileData = nullptr; ///< Start of the mapping.
+    size_t fileSize = 0;            ///< Size of the mapping in bytes.
+};
+
+#endif //TITANPLUSPLUS_MAPPEDFILE_H
@@ -5,22 +5,33 @@
  * @file Matrix.h
  * @author Bryn McKerracher
  * @date 19/10/2021
- * @brief The Matrix class. Uses CUDA methods to perform matrix operations.
+ * @brief The Matrix class. Uses MatrixBackend to perform matrix operations on the CPU or a CUDA GPU.
  */
 
-#include <cuda_runtime.h>
+#include <atomic>
 #include <iostream>
 #include <sstream>
-#include <vector>
-#include "CudaMath.h"
+#include <string_view>
+#include "MatrixBackend.h"
+
+template <typename T>
+class MatrixView;
 
 /**
- * Uses CUDA computation to provide fast matrix operations.
+ * Uses CUDA or multi-threaded CPU computation to provide fast matrix operations.
+ *
+ * Copies share their entries through a reference count, so copying a matrix is O(1). A matrix
+ * only copies its entries when it is about to be written through operator() or data() while
+ * another matrix still shares them (copy-on-write).
  *
  * @note All CUDA operations are grid-stride loops and are thus optimised for large array/matrix operations.
+ * Small matrices are always processed on the CPU, see MatrixBackend.
  *
- * @warning Currently, the matrix class strictly requires a CUDA GPU and will not function
- * without one. It is intended that further updates will also allow CPU matrices if no CUDA GPU is found.
+ * @note A reference returned by operator() or data() writes through to every copy made after
+ * it was taken, so take references after copying, not before.
+ *
+ * Rows, columns and blocks can be read in place through a MatrixView, see row() and block(),
+ * and written with assign().
  *
  * @brief Represents a double precision Matrix.
  * @class Matrix
@@ -37,13 +48,45 @@ public:
      Matrix(int x, int y);
 
      /**
+      * Parses the body of a matrix literal, i.e. the literal without its outer brackets,
+      * such as "[1, 2] 3, 4]" or "[1, 2] [3, 4]". Rows end with ']' and the first must
+      * start with '['. Entries are separated by commas and may have a sign, fraction and
+      * exponent. Entries are parsed straight into the matrix's storage in a single pass.
+      *
       * @brief Creates a matrix from numeric values in a string.
       * @param str The string to read matrix entries from.
+      * @throws std::invalid_argument If the string is malformed or its rows differ in width.
       */
-     Matrix(const std::string& str);
+     Matrix(std::string_view str);
+
+    /**
+     * @brief Creates a copy of another matrix that shares its entries until either is written to.
+     * @param other The matrix to copy.
+     */
+    Matrix(const Matrix& other);
+
+    /**
+     * @brief Takes ownership of another matrix's entries, leaving it empty.
+     * @param other The matrix to move from.
+     */
+    Matrix(Matrix&& other) noexcept;
 
     /**
-     * @brief Frees the allocated CUDA memory on the GPU.
+     * @brief Replaces this matrix's entries with a shared reference to another matrix's entries.
+     * @param other The matrix to copy.
+     * @return A reference to this matrix.
+     */
+    Matrix& operator=(const Matrix& other);
+
+    /**
+     * @brief Releases this matrix's entries and takes ownership of another matrix's, leaving it empty.
+     * @param other The matrix to move from.
+     * @return A reference to this matrix.
+     */
+    Matrix& operator=(Matrix&& other) noexcept;
+
+    /**
+     * @brief Releases the matrix's entries, freeing them on the active MatrixBackend device if no other copy shares them.
      */
     ~Matrix();
 
@@ -63,7 +106,21 @@ public:
     static Matrix identity(int n);
 
     /**
-     * @brief Creates a reference to a specific entry for setting a value.
+     * Lets a matrix use entries it didn't allocate, such as a memory-mapped file, without
+     * copying them. Copies share the entries as usual, and writing to a shared matrix copies
+     * them into storage allocated by MatrixBackend.
+     *
+     * @brief Creates a matrix over existing entries, calling unmap(owner) once no copy shares them.
+     * @param x The width of the new matrix.
+     * @param y The height of the new matrix.
+     * @param entries The x * y entries, stored row by row, which must stay valid and writable until unmap is called.
+     * @param unmap Frees the entries, called once with owner.
+     * @param owner Whatever owns the entries, passed to unmap.
+     */
+    static Matrix adopt(int x, int y, T* entries, void (*unmap)(void* owner), void* owner);
+
+    /**
+     * @brief Creates a reference to a specific entry for setting a value, first copying the entries if they are shared.
      * @param x The x coordinate of the entry.
      * @param y The y coordinate of the entry.
      */
@@ -76,6 +133,72 @@ public:
      */
     const T& operator()(int x, int y) const;
 
+    /**
+     * @brief Returns the number of columns in the matrix.
+     */
+    int getWidth() const;
+
+    /**
+     * @brief Returns the number of rows in the matrix.
+     */
+    int getHeight() const;
+
+    /**
+     * @brief Returns the number of entries in the matrix.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns a pointer to the matrix's entries, stored row by row, first copying them if they are shared.
+     */
+    T* data();
+
+    /**
+     * @brief Returns a const pointer to the matrix's entries, stored row by row.
+     */
+    const T* data() const;
+
+    /**
+     * @brief Returns true if another matrix shares this matrix's entries.
+     */
+    bool isShared() const;
+
+    /**
+     * @brief Creates a view of a row of the matrix, without copying it.
+     * @param y The index of the row.
+     * @throws std::invalid_argument If the row is out of range.
+     */
+    MatrixView<T> row(int y) const;
+
+    /**
+     * @brief Creates a view of a column of the matrix, without copying it.
+     * @param x The index of the column.
+     * @throws std::invalid_argument If the column is out of range.
+     */
+    MatrixView<T> column(int x) const;
+
+    /**
+     * @brief Creates a view of a block of the matrix, without copying it.
+     * @param x The column of the block's first entry.
+     * @param y The row of the block's first entry.
+     * @param width The number of columns in the block.
+     * @param height The number of rows in the block.
+     * @throws std::invalid_argument If the block doesn't fit inside the matrix.
+     */
+    MatrixView<T> block(int x, int y, int width, int height) const;
+
+    /**
+     * The values may be a view of this matrix, even one that overlaps the block, in which
+     * case the view keeps the entries it was taken from and the matrix copies them first.
+     *
+     * @brief Overwrites the block of the matrix starting at (x, y) with the entries of a view.
+     * @param x The column of the block's first entry.
+     * @param y The row of the block's first entry.
+     * @param values The entries to write, whose dimensions are those of the block.
+     * @throws std::invalid_argument If the block doesn't fit inside the matrix.
+     */
+    void assign(int x, int y, const MatrixView<T>& values);
+
     /**
      * @brief Performs an element-wise equality comparison with another matrix.
      * @param rhs The matrix to compare against.
@@ -89,6 +212,15 @@ public:
      */
     Matrix transpose() const;
 
+    /**
+     * Square matrices are transposed without allocating a second array, unless their entries
+     * are shared, in which case a new array is needed anyway. Other matrices are replaced by
+     * transpose().
+     *
+     * @brief Replaces this matrix with its transpose.
+     */
+    void transposeInPlace();
+
     /**
      * @brief Creates a matrix which is the sum of this and rhs.
      * @param rhs The right-hand operand of the matrix add operation.
@@ -110,22 +242,98 @@ public:
       */
      Matrix operator*(const T& scalar) const;
 
+     /**
+      * A column vector is a matrix of width 1, so this also computes matrix-vector products.
+      *
+      * @brief Creates the matrix product of this matrix and rhs.
+      * @param rhs The right-hand operand, whose height must equal this matrix's width.
+      * @return The product, with this matrix's height and rhs's width.
+      * @throws std::invalid_argument If the dimensions of the operands don't match.
+      */
+     Matrix operator*(const Matrix& rhs) const;
+
+     /**
+      * @brief Returns the sum of the entries, or 0 if the matrix is empty.
+      */
+     T sum() const;
+
+     /**
+      * @brief Returns the mean of the entries.
+      * @throws std::invalid_argument If the matrix is empty.
+      */
+     T mean() const;
+
+     /**
+      * @brief Returns the smallest entry.
+      * @throws std::invalid_argument If the matrix is empty.
+      */
+     T min() const;
+
+     /**
+      * @brief Returns the largest entry.
+      * @throws std::invalid_argument If the matrix is empty.
+      */
+     T max() const;
+
+     /**
+      * @brief Returns the L1 norm of the entries, the sum of their absolute values.
+      */
+     T norm1() const;
+
+     /**
+      * The L2 norm of the entries taken as one vector, which for a matrix is its Frobenius norm.
+      *
+      * @brief Returns the square root of the sum of the squares of the entries.
+      */
+     T norm2() const;
+
+     /**
+      * @brief Returns the sum of the products of the entries of this matrix and rhs.
+      * @param rhs The other operand, which must have the same dimensions as this matrix.
+      * @throws std::invalid_argument If the dimensions of the operands don't match.
+      */
+     T dot(const Matrix& rhs) const;
+
      /**
       * @brief Creates a human-readable string representation of the matrix.
       * @return A human-readable string representing the matrix.
       */
      std::string toString() const;
 protected:
-    T* entries = nullptr;   ///< The matrix's entries.
-    size_t entriesSize = 0; ///< The number of entries.
-    int width = 0;          ///< The width of the matrix.
+    /**
+     * @brief Entries shared by copies of a matrix, and the number of matrices sharing them.
+     */
+    struct Storage {
+        std::atomic<size_t> references; ///< The number of matrices sharing the entries.
+        T* entries;                     ///< The entries, allocated by MatrixBackend unless unmap is set.
+        void (*unmap)(void*) = nullptr; ///< Frees entries the matrix didn't allocate, see adopt().
+        void* owner = nullptr;          ///< Passed to unmap.
+    };
+
+    /**
+     * @brief Frees storage and its entries once no matrix refers to it.
+     */
+    static void free(Storage* shared);
 
     /**
-     * @brief
-     * @param string A string of values to be parsed from.
-     * @return A vector of Ts parsed from the garbage string.
+     * @brief Allocates unshared storage for n entries, leaving the matrix empty if n is zero.
      */
-    std::vector<T> numericParse(const std::string& string) const;
+    void allocate(size_t n);
+
+    /**
+     * @brief Drops this matrix's reference to its storage, freeing it if this was the last reference.
+     */
+    void release();
+
+    /**
+     * @brief Gives this matrix its own copy of its entries if they are shared.
+     */
+    void detach();
+
+    Storage* storage = nullptr; ///< The shared entries, or nullptr if the matrix is empty.
+    T* entries = nullptr;       ///< The matrix's entries, cached from storage.
+    size_t entriesSize = 0;     ///< The number of entries.
+    int width = 0;              ///< The width of the matrix.
 };
 
 //Forward declarations of matrix types.
@@ -133,5 +341,6 @@ typedef Matrix<double> MatrixD; ///< Common matrix type using double precision e
 typedef Matrix<float>  MatrixF; ///< Common matrix type using single precision entries for TENSOR cores.
 
 #include "Matrix.tpp"
+#include "MatrixView.h"
 
 #endif //TITANPLUSPLUS_MATRIX_CU
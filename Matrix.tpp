@@ -5,6 +5,12 @@
 #ifndef TITANPLUSPLUS_MATRIX_TPP
 #define TITANPLUSPLUS_MATRIX_TPP
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include "Matrix.h"
 
 template <typename T>
@@ -13,55 +19,155 @@ Matrix<T>::Matrix(int x, int y) {
     entriesSize = x * y;
     width = x;
 
-    //Allocate CUDA memory.
-    cudaMallocManaged(&entries, entriesSize * sizeof(T));
+    //Allocate device memory.
+    allocate(entriesSize);
 }
 
 template <typename T>
-Matrix<T>::Matrix(const std::string& str) {
-    size_t rowStart = str.find_first_of('[');
+Matrix<T>::Matrix(std::string_view str) {
+    auto isSeparator = [](char c) {
+        return c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '[' || c == ']';
+    };
 
-    //If no row start found, it's a vector.
-    if (rowStart == std::string::npos) {
-        width = 1;
+    //A counting pre-scan sizes the storage exactly, so entries are parsed straight into it without regrowing.
+    size_t capacity = 0;
+    bool inEntry = false;
+    for (char c : str) {
+        const bool separator = isSeparator(c);
+        capacity += !separator && !inEntry;
+        inEntry = !separator;
     }
-    else {
-        width = numericParse(str.substr(1, str.find_first_of(']') - 1)).size();
+    allocate(capacity);
+
+    const char* position = str.data();
+    const char* const end = str.data() + str.size();
+    auto fail = [&](const std::string& message) {
+        release();
+        throw std::invalid_argument("Malformed matrix: " + message + " at character " + std::to_string(position - str.data()) + ".");
+    };
+    auto next = [&]() {
+        while (position != end && (*position == ' ' || *position == '\t' || *position == '\r' || *position == '\n')) ++position;
+        return position == end ? '\0' : *position;
+    };
+
+    if (next() != '[') fail("expected '['");
+    ++position;
+
+    //The first ']' sets the width. Later rows may be bracketed, or just continue the list of entries.
+    bool afterComma = false;
+    size_t closedAt = 0;
+    for (char c = next(); c != '\0'; c = next()) {
+        if (c == ',') {
+            if (afterComma || entriesSize == 0) fail("expected a number");
+            afterComma = true;
+            ++position;
+        }
+        else if (c == ']') {
+            if (afterComma) fail("expected a number");
+            if (entriesSize == closedAt && entriesSize > 0) fail("empty row");
+            if (width == 0) {
+                if (entriesSize == 0) fail("expected a number");
+                width = (int)entriesSize;
+            }
+            else if (entriesSize % width != 0) {
+                fail("rows must have the same number of entries");
+            }
+            closedAt = entriesSize;
+            ++position;
+        }
+        else if (c == '[') {
+            if (afterComma || width == 0 || entriesSize % width != 0) fail("unexpected '['");
+            ++position;
+        }
+        else {
+            //from_chars doesn't take a '+', and would read the sign of "+-5" as the entry's own.
+            if (c == '+') {
+                ++position;
+                if (position != end && (*position == '+' || *position == '-')) fail("expected a number");
+            }
+            T value;
+            auto [numberEnd, error] = std::from_chars(position, end, value);
+            if (error == std::errc::result_out_of_range) fail("entry out of range");
+            if (error != std::errc() || entriesSize == capacity) fail("expected a number");
+            position = numberEnd;
+            if (position != end && !isSeparator(*position)) fail("expected ',' or ']'");
+            entries[entriesSize++] = value;
+            afterComma = false;
+        }
     }
 
-    auto numericEntries = numericParse(str);
-    entriesSize = numericEntries.size();
+    if (afterComma) fail("expected a number");
+    if (width == 0) fail("expected ']'");
+    if (entriesSize % width != 0) fail("rows must have the same number of entries");
+}
 
-    //Allocate CUDA memory.
-    cudaMallocManaged(&entries, entriesSize * sizeof(T));
+template <typename T>
+Matrix<T>::Matrix(const Matrix<T>& other) : storage(other.storage), entries(other.entries), entriesSize(other.entriesSize), width(other.width) {
+    if (storage != nullptr) storage->references.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename T>
+Matrix<T>::Matrix(Matrix<T>&& other) noexcept
+        : storage(std::exchange(other.storage, nullptr)), entries(std::exchange(other.entries, nullptr)),
+          entriesSize(std::exchange(other.entriesSize, 0)), width(std::exchange(other.width, 0)) {}
 
-    //Init entries
-    for (size_t i = 0; i < entriesSize; ++i) {
-        entries[i] = numericEntries[i];
+template <typename T>
+Matrix<T>& Matrix<T>::operator=(const Matrix<T>& other) {
+    if (this != &other) {
+        if (other.storage != nullptr) other.storage->references.fetch_add(1, std::memory_order_relaxed);
+        release();
+        storage = other.storage;
+        entries = other.entries;
+        entriesSize = other.entriesSize;
+        width = other.width;
     }
+    return *this;
+}
+
+template <typename T>
+Matrix<T>& Matrix<T>::operator=(Matrix<T>&& other) noexcept {
+    if (this != &other) {
+        release();
+        storage = std::exchange(other.storage, nullptr);
+        entries = std::exchange(other.entries, nullptr);
+        entriesSize = std::exchange(other.entriesSize, 0);
+        width = std::exchange(other.width, 0);
+    }
+    return *this;
 }
 
 template <typename T>
 Matrix<T>::~Matrix() {
-    cudaFree(&entries);
+    release();
 }
 
 template <typename T>
 Matrix<T> Matrix<T>::zero(int x, int y) {
     Matrix<T> zeroed(x, y);
-    CudaMath::cudaZeroArray(zeroed.entriesSize, zeroed.entries);
+    MatrixBackend::zeroArray(zeroed.entriesSize, zeroed.entries);
     return zeroed;
 }
 
 template <typename T>
 Matrix<T> Matrix<T>::identity(int n) {
     Matrix<T> identity(n, n);
-    CudaMath::cudaIdentityArray(identity.entriesSize, n, identity.entries);
+    MatrixBackend::identityArray(identity.entriesSize, n, identity.entries);
     return identity;
 }
 
+template <typename T>
+Matrix<T> Matrix<T>::adopt(int x, int y, T* entries, void (*unmap)(void*), void* owner) {
+    Matrix<T> adopted(0, 0);
+    adopted.entriesSize = (size_t)x * y;
+    adopted.width = x;
+    adopted.entries = entries;
+    adopted.storage = new Storage{{1}, entries, unmap, owner};
+    return adopted;
+}
+
 template <typename T>
 T& Matrix<T>::operator()(int x, int y) {
+    detach();
     return entries[x + y * width];
 }
 
@@ -70,71 +176,204 @@ const T& Matrix<T>::operator()(int x, int y) const {
     return entries[x + y * width];
 }
 
+template <typename T>
+int Matrix<T>::getWidth() const {
+    return width;
+}
+
+template <typename T>
+int Matrix<T>::getHeight() const {
+    return width == 0 ? 0 : (int)(entriesSize / width);
+}
+
+template <typename T>
+size_t Matrix<T>::size() const {
+    return entriesSize;
+}
+
+template <typename T>
+T* Matrix<T>::data() {
+    detach();
+    return entries;
+}
+
+template <typename T>
+const T* Matrix<T>::data() const {
+    return entries;
+}
+
+template <typename T>
+bool Matrix<T>::isShared() const {
+    return storage != nullptr && storage->references.load(std::memory_order_acquire) > 1;
+}
+
+template <typename T>
+MatrixView<T> Matrix<T>::row(int y) const {
+    return block(0, y, width, 1);
+}
+
+template <typename T>
+MatrixView<T> Matrix<T>::column(int x) const {
+    return block(x, 0, 1, getHeight());
+}
+
+template <typename T>
+MatrixView<T> Matrix<T>::block(int x, int y, int width, int height) const {
+    return MatrixView<T>(*this, x, y, width, height);
+}
+
+template <typename T>
+void Matrix<T>::assign(int x, int y, const MatrixView<T>& values) {
+    if (x < 0 || y < 0 || x + values.getWidth() > width || y + values.getHeight() > getHeight()) {
+        throw std::invalid_argument("Cannot assign a " + std::to_string(values.getHeight()) + "x" + std::to_string(values.getWidth()) + " matrix at row "
+                                    + std::to_string(y) + ", column " + std::to_string(x) + " of a " + std::to_string(getHeight()) + "x"
+                                    + std::to_string(width) + " matrix.");
+    }
+    if (values.size() == 0) return;
+
+    //A copy is a program that only loads its operand.
+    ElementwiseProgram<T> program;
+    program.steps[program.stepCount++] = {ElementwiseProgram<T>::Op::Load, 0, T(0)};
+    program.operands[program.operandCount] = values.data();
+    program.strides[program.operandCount++] = values.getStride();
+    MatrixBackend::evaluate<T>(values.getHeight(), values.getWidth(), program, data() + (size_t)y * width + x, width);
+}
+
 template <typename T>
 bool Matrix<T>::operator==(const Matrix<T> &rhs) const {
-    return entriesSize == rhs.entriesSize && width == rhs.width && CudaMath::cudaEqual<T>(entriesSize, entries, rhs.entries);
+    if (entriesSize != rhs.entriesSize || width != rhs.width) return false;
+    //Copies that still share their entries are equal without comparing them.
+    return entries == rhs.entries || MatrixBackend::equal<T>(entriesSize, entries, rhs.entries);
 }
 
 template <typename T>
 Matrix<T> Matrix<T>::transpose() const {
-    Matrix<T> transpose(this->entriesSize / this->width, this->width);
-    CudaMath::cudaTranspose(entriesSize, this->width, entries, transpose.entries);
+    Matrix<T> transpose(getHeight(), this->width);
+    MatrixBackend::transpose(entriesSize, this->width, entries, transpose.entries);
     return transpose;
 }
 
+template <typename T>
+void Matrix<T>::transposeInPlace() {
+    //Shared entries must be copied before they are written, so write the transpose as the copy.
+    if (width != getHeight() || isShared()) {
+        *this = transpose();
+        return;
+    }
+    MatrixBackend::transposeSquare<T>(width, entries);
+}
+
 template <typename T>
 Matrix<T> Matrix<T>::operator+(const Matrix<T>& rhs) const {
     Matrix<T> sum(this->width, this->entriesSize / this->width);
-    CudaMath::cudaAdd(entriesSize, this->entries, rhs.entries, sum.entries);
+    MatrixBackend::add(entriesSize, this->entries, rhs.entries, sum.entries);
     return sum;
 }
 
 template <typename T>
 Matrix<T> Matrix<T>::operator-(const Matrix<T> &rhs) const {
     Matrix<T> result(this->width, this->entriesSize / this->width);
-    CudaMath::cudaSubtract(entriesSize, this->entries, rhs.entries, result.entries);
+    MatrixBackend::subtract(entriesSize, this->entries, rhs.entries, result.entries);
     return result;
 }
 
 template <typename T>
 Matrix<T> Matrix<T>::operator*(const T &scalar) const {
     Matrix<T> product(this->width, this->entriesSize / this->width);
-    CudaMath::cudaScalarMultiply(entriesSize, this->entries, scalar, product.entries);
+    MatrixBackend::scalarMultiply(entriesSize, this->entries, scalar, product.entries);
     return product;
 }
 
 template <typename T>
-std::string Matrix<T>::toString() const {
-    std::stringstream stream;
-    stream << "[";
-    for (size_t i = 0; i < entriesSize; ++i) {
-        if (i > 0 and i % width == 0) stream << "] [";
-        stream << entries[i];
-        if (i % width != width - 1) {
-            stream << ", ";
-        }
+Matrix<T> Matrix<T>::operator*(const Matrix<T>& rhs) const {
+    if (width != rhs.getHeight()) {
+        throw std::invalid_argument("Cannot multiply a " + std::to_string(getHeight()) + "x" + std::to_string(width) + " matrix by a "
+                                    + std::to_string(rhs.getHeight()) + "x" + std::to_string(rhs.width) + " matrix.");
     }
-    stream << "]";
-    return stream.str();
-}
-
-template<typename T>
-std::vector<T> Matrix<T>::numericParse(const std::string &string) const {
-    std::vector<T> numericEntries;
-    size_t start = 0;
-    for (size_t i = 0; i < string.size(); ++i) {
-        if (string[i] >= '0' && string[i] <= '9') {
-            start = i;
-            while (i < string.size() && (string[i] >= '0' && string[i] <= '9') || (i + 1 < string.size() && string[i] == '.' && string[i + 1] >= '0' && string[i + 1] <= '9')) {
-                ++i;
-            }
-            std::stringstream stream(string.substr(start, i - start));
-            T value;
-            stream >> value;
-            numericEntries.push_back(value);
-        }
+    Matrix<T> product(rhs.width, getHeight());
+    MatrixBackend::matrixMultiply<T>(getHeight(), width, rhs.width, entries, rhs.entries, product.entries);
+    return product;
+}
+
+template <typename T>
+T Matrix<T>::sum() const {
+    return MatrixView<T>(*this).sum();
+}
+
+template <typename T>
+T Matrix<T>::mean() const {
+    return MatrixView<T>(*this).mean();
+}
+
+template <typename T>
+T Matrix<T>::min() const {
+    return MatrixView<T>(*this).min();
+}
+
+template <typename T>
+T Matrix<T>::max() const {
+    return MatrixView<T>(*this).max();
+}
+
+template <typename T>
+T Matrix<T>::norm1() const {
+    return MatrixView<T>(*this).norm1();
+}
+
+template <typename T>
+T Matrix<T>::norm2() const {
+    return MatrixView<T>(*this).norm2();
+}
+
+template <typename T>
+T Matrix<T>::dot(const Matrix<T>& rhs) const {
+    return MatrixView<T>(*this).dot(rhs);
+}
+
+template <typename T>
+void Matrix<T>::allocate(size_t n) {
+    if (n == 0) return;
+    entries = MatrixBackend::allocate<T>(n);
+    storage = new Storage{{1}, entries};
+}
+
+template <typename T>
+void Matrix<T>::release() {
+    if (storage != nullptr && storage->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        free(storage);
     }
-    return numericEntries;
+    storage = nullptr;
+    entries = nullptr;
+}
+
+template <typename T>
+void Matrix<T>::detach() {
+    if (!isShared()) return;
+    Storage* shared = storage;
+    T* sharedEntries = entries;
+    storage = nullptr;
+    allocate(entriesSize);
+    MatrixBackend::copy(entriesSize, sharedEntries, entries);
+    //Another copy may have released its reference since the check, so the last one frees the entries.
+    if (shared->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        free(shared);
+    }
+}
+
+template <typename T>
+void Matrix<T>::free(Storage* shared) {
+    if (shared->unmap != nullptr) {
+        shared->unmap(shared->owner);
+    }
+    else {
+        MatrixBackend::release(shared->entries);
+    }
+    delete shared;
+}
+
+template <typename T>
+std::string Matrix<T>::toString() const {
+    return MatrixView<T>(*this).toString();
 }
 
 #endif //TITANPLUSPLUS_MATRIX_TPP
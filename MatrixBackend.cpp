@@ -0,0 +1,239 @@
+/**
+ * @file MatrixBackend.cpp
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Selects between the CPU and CUDA implementations of matrix array math.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include "MatrixBackend.h"
+#include "CpuMath.h"
+
+#ifdef TITAN_CUDA
+#include <cuda_runtime.h>
+#include "CudaMath.h"
+#endif //TITAN_CUDA
+
+namespace {
+const std::align_val_t CpuAlignment{64}; ///< Cache-line alignment so SIMD loads never straddle lines.
+
+bool deviceSelected = false;                                         ///< Whether the device has been chosen.
+bool deviceLocked = false;                                           ///< Set once the first array is allocated.
+MatrixBackend::Device activeDevice = MatrixBackend::Device::CPU;     ///< The device in use once selected.
+
+/**
+ * @brief Returns true if operations on n elements should launch CUDA kernels.
+ */
+inline bool useCuda(size_t n) {
+    return MatrixBackend::device() == MatrixBackend::Device::CUDA && n >= MatrixBackend::CudaThreshold;
+}
+}
+
+bool MatrixBackend::cudaAvailable() {
+#ifdef TITAN_CUDA
+    int deviceCount = 0;
+    return cudaGetDeviceCount(&deviceCount) == cudaSuccess && deviceCount > 0;
+#else
+    return false;
+#endif //TITAN_CUDA
+}
+
+MatrixBackend::Device MatrixBackend::device() {
+    if (!deviceSelected) {
+        const char* requested = std::getenv("TITAN_MATRIX_BACKEND");
+        if (requested != nullptr && std::string(requested) == "cpu") {
+            activeDevice = Device::CPU;
+        }
+        else {
+            activeDevice = cudaAvailable() ? Device::CUDA : Device::CPU;
+        }
+        deviceSelected = true;
+    }
+    return activeDevice;
+}
+
+bool MatrixBackend::setDevice(MatrixBackend::Device device) {
+    if (device == Device::CUDA && !cudaAvailable()) return false;
+    if (deviceLocked && device != activeDevice) return false;
+    activeDevice = device;
+    deviceSelected = true;
+    return true;
+}
+
+template <typename T>
+T* MatrixBackend::allocate(size_t n) {
+    if (n == 0) return nullptr;
+    deviceLocked = true;
+#ifdef TITAN_CUDA
+    if (device() == Device::CUDA) {
+        T* a = nullptr;
+        if (cudaMallocManaged(&a, n * sizeof(T)) != cudaSuccess) throw std::bad_alloc();
+        return a;
+    }
+#endif //TITAN_CUDA
+    return static_cast<T*>(::operator new[](n * sizeof(T), CpuAlignment));
+}
+
+template <typename T>
+void MatrixBackend::release(T* a) {
+    if (a == nullptr) return;
+#ifdef TITAN_CUDA
+    if (device() == Device::CUDA) {
+        cudaFree(a);
+        return;
+    }
+#endif //TITAN_CUDA
+    ::operator delete[](a, CpuAlignment);
+}
+
+template <typename T>
+void MatrixBackend::copy(size_t n, const T* source, T* destination) {
+    CpuMath::parallelFor(n, [=](size_t begin, size_t end) {
+        std::memcpy(destination + begin, source + begin, (end - begin) * sizeof(T));
+    });
+}
+
+template <typename T>
+void MatrixBackend::add(size_t n, T* a, T* b, T* sum) {
+#ifdef TITAN_CUDA
+    if (useCuda(n)) return CudaMath::cudaAdd(n, a, b, sum);
+#endif //TITAN_CUDA
+    CpuMath::cpuAdd(n, a, b, sum);
+}
+
+template <typename T>
+void MatrixBackend::subtract(size_t n, T* a, T* b, T* result) {
+#ifdef TITAN_CUDA
+    if (useCuda(n)) return CudaMath::cudaSubtract(n, a, b, result);
+#endif //TITAN_CUDA
+    CpuMath::cpuSubtract(n, a, b, result);
+}
+
+template <typename T>
+void MatrixBackend::scalarMultiply(size_t n, T* a, T b, T* result) {
+#ifdef TITAN_CUDA
+    if (useCuda(n)) return CudaMath::cudaScalarMultiply(n, a, b, result);
+#endif //TITAN_CUDA
+    CpuMath::cpuScalarMultiply(n, a, b, result);
+}
+
+template <typename T>
+bool MatrixBackend::equal(size_t n, T* a, T* b) {
+#ifdef TITAN_CUDA
+    if (useCuda(n)) return CudaMath::cudaEqual(n, a, b);
+#endif //TITAN_CUDA
+    return CpuMath::cpuEqual(n, a, b);
+}
+
+template <typename T>
+void MatrixBackend::transpose(size_t n, size_t oldWidth, T* a, T* result) {
+#ifdef TITAN_CUDA
+    if (useCuda(n)) return CudaMath::cudaTranspose(n, oldWidth, a, result);
+#endif //TITAN_CUDA
+    CpuMath::cpuTranspose(n, oldWidth, a, result);
+}
+
+template <typename T>
+void MatrixBackend::transposeSquare(size_t width, T* a) {
+#ifdef TITAN_CUDA
+    if (useCuda(width * width)) return CudaMath::cudaTransposeSquare(width, a);
+#endif //TITAN_CUDA
+    CpuMath::cpuTransposeSquare(width, a);
+}
+
+template <typename T>
+void MatrixBackend::matrixMultiply(size_t m, size_t k, size_t n, T* a, T* b, T* result) {
+#ifdef TITAN_CUDA
+    if (useCuda(m * n) && k > 0) return CudaMath::cudaMatrixMultiply(m, k, n, a, b, result);
+#endif //TITAN_CUDA
+    CpuMath::cpuMatrixMultiply(m, k, n, a, b, result);
+}
+
+template <typename T>
+void MatrixBackend::evaluate(size_t rows, size_t columns, const ElementwiseProgram<T>& program, T* result, size_t resultStride) {
+#ifdef TITAN_CUDA
+    if (useCuda(rows * columns)) return CudaMath::cudaEvaluate(rows, columns, program, result, resultStride);
+#endif //TITAN_CUDA
+    CpuMath::cpuEvaluate(rows, columns, program, result, resultStride);
+}
+
+template <typename T>
+T MatrixBackend::reduce(size_t rows, size_t columns, Reduction reduction, const T* a, size_t aStride, const T* b, size_t bStride) {
+#ifdef TITAN_CUDA
+    if (useCuda(rows * columns)) return CudaMath::cudaReduce(rows, columns, reduction, a, aStride, b, bStride);
+#endif //TITAN_CUDA
+    return CpuMath::cpuReduce(rows, columns, reduction, a, aStride, b, bStride);
+}
+
+template <typename T>
+void MatrixBackend::zeroArray(size_t n, T* a) {
+#ifdef TITAN_CUDA
+    if (useCuda(n)) return CudaMath::cudaZeroArray(n, a);
+#endif //TITAN_CUDA
+    CpuMath::cpuZeroArray(n, a);
+}
+
+template <typename T>
+void MatrixBackend::identityArray(size_t n, size_t width, T* a) {
+#ifdef TITAN_CUDA
+    if (useCuda(n)) return CudaMath::cudaIdentityArray(n, width, a);
+#endif //TITAN_CUDA
+    CpuMath::cpuIdentityArray(n, width, a);
+}
+
+///Forward declarations
+//Allocation
+template float* MatrixBackend::allocate<float>(size_t n);
+template double* MatrixBackend::allocate<double>(size_t n);
+template void MatrixBackend::release<float>(float* a);
+template void MatrixBackend::release<double>(double* a);
+template void MatrixBackend::copy<float>(size_t n, const float* source, float* destination);
+template void MatrixBackend::copy<double>(size_t n, const double* source, double* destination);
+
+//Add
+template void MatrixBackend::add<float>(size_t n, float* a, float* b, float* sum);
+template void MatrixBackend::add<double>(size_t n, double* a, double* b, double* sum);
+
+//Subtract
+template void MatrixBackend::subtract<float>(size_t n, float* a, float* b, float* result);
+template void MatrixBackend::subtract<double>(size_t n, double* a, double* b, double* result);
+
+//Scalar multiply
+template void MatrixBackend::scalarMultiply<float>(size_t n, float* a, float b, float* result);
+template void MatrixBackend::scalarMultiply<double>(size_t n, double* a, double b, double* result);
+
+//Equal
+template bool MatrixBackend::equal<float>(size_t n, float* a, float* b);
+template bool MatrixBackend::equal<double>(size_t n, double* a, double* b);
+
+//Transpose
+template void MatrixBackend::transpose<float>(size_t n, size_t oldWidth, float* a, float* result);
+template void MatrixBackend::transpose<double>(size_t n, size_t oldWidth, double* a, double* result);
+
+//Transpose square
+template void MatrixBackend::transposeSquare<float>(size_t width, float* a);
+template void MatrixBackend::transposeSquare<double>(size_t width, double* a);
+
+//Matrix multiply
+template void MatrixBackend::matrixMultiply<float>(size_t m, size_t k, size_t n, float* a, float* b, float* result);
+template void MatrixBackend::matrixMultiply<double>(size_t m, size_t k, size_t n, double* a, double* b, double* result);
+
+//Evaluate
+template void MatrixBackend::evaluate<float>(size_t rows, size_t columns, const ElementwiseProgram<float>& program, float* result, size_t resultStride);
+template void MatrixBackend::evaluate<double>(size_t rows, size_t columns, const ElementwiseProgram<double>& program, double* result, size_t resultStride);
+
+//Reduce
+template float MatrixBackend::reduce<float>(size_t rows, size_t columns, Reduction reduction, const float* a, size_t aStride, const float* b, size_t bStride);
+template double MatrixBackend::reduce<double>(size_t rows, size_t columns, Reduction reduction, const double* a, size_t aStride, const double* b, size_t bStride);
+
+//Zero array
+template void MatrixBackend::zeroArray<float>(size_t n, float* a);
+template void MatrixBackend::zeroArray<double>(size_t n, double* a);
+
+//Identity array
+template void MatrixBackend::identityArray<float>(size_t n, size_t width, float* a);
+template void MatrixBackend::identityArray<double>(size_t n, size_t width, double* a);
@@ -0,0 +1,153 @@
+#ifndef TITANPLUSPLUS_MATRIXBACKEND_H
+#define TITANPLUSPLUS_MATRIXBACKEND_H
+
+/**
+ * @file MatrixBackend.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Selects between the CPU and CUDA implementations of matrix array math.
+ */
+
+#include <cstddef>
+#include "ElementwiseProgram.h"
+#include "Reduction.h"
+
+/**
+ * MatrixBackend is the only place Matrix<T> touches device memory or math kernels.
+ *
+ * The CUDA backend is only compiled in when TITAN_CUDA is defined (see the TITAN_ENABLE_CUDA
+ * CMake option). When it is, the device is picked on first use: CUDA if a GPU is present,
+ * otherwise CPU. The TITAN_MATRIX_BACKEND environment variable ("cpu" or "cuda") or
+ * setDevice() can override this at startup, before the first matrix is allocated.
+ *
+ * @note Even on the CUDA device, arrays smaller than CudaThreshold are processed on the CPU
+ * (CUDA memory is allocated as managed memory, so it is host-accessible) to avoid paying
+ * kernel-launch and synchronisation overhead for tiny matrices.
+ */
+namespace MatrixBackend {
+///Devices that can perform matrix math.
+enum class Device {
+    CPU,  ///< Multi-threaded, vectorised host code (CpuMath).
+    CUDA  ///< CUDA kernels on a GPU (CudaMath).
+};
+
+/**
+ * @brief Minimum number of elements before an operation on the CUDA device launches a kernel.
+ */
+const size_t CudaThreshold = 1 << 14;
+
+/**
+ * @brief Returns true if this build has the CUDA backend and a CUDA GPU is present.
+ */
+bool cudaAvailable();
+
+/**
+ * @brief Returns the active device, choosing one if none has been selected yet.
+ */
+Device device();
+
+/**
+ * @brief Selects the device used for all matrices.
+ * @param device The device to use.
+ * @return False if the device is unavailable, or a matrix has already been allocated on another device.
+ */
+bool setDevice(Device device);
+
+/**
+ * @brief Allocates an uninitialised array of n elements on the active device.
+ * @tparam T The type of element in the array.
+ * @param n The number of elements.
+ * @return Pointer to the array, or nullptr if n is zero.
+ */
+template <typename T>
+T* allocate(size_t n);
+
+/**
+ * @brief Frees an array returned by allocate().
+ * @tparam T The type of element in the array.
+ * @param a Pointer to the array, may be nullptr.
+ */
+template <typename T>
+void release(T* a);
+
+/**
+ * @brief Copies n elements from source into destination.
+ * @tparam T The type of element in the arrays.
+ * @param n The number of elements to copy.
+ * @param source Pointer to the array being copied.
+ * @param destination Pointer to the array being written.
+ */
+template <typename T>
+void copy(size_t n, const T* source, T* destination);
+
+/**
+ * @brief Performs point-wise addition on a and b, and stores the results in sum.
+ */
+template <typename T>
+void add(size_t n, T* a, T* b, T* sum);
+
+/**
+ * @brief Performs point-wise subtraction on a and b, and stores the results in result.
+ */
+template <typename T>
+void subtract(size_t n, T* a, T* b, T* result);
+
+/**
+ * @brief Performs point-wise scalar multiplication of a by b, and stores the results in result.
+ */
+template <typename T>
+void scalarMultiply(size_t n, T* a, T b, T* result);
+
+/**
+ * @brief Tests the element-wise equality of two arrays of size n.
+ */
+template <typename T>
+bool equal(size_t n, T* a, T* b);
+
+/**
+ * @brief Writes the transpose of a matrix with n elements and width oldWidth into result.
+ */
+template <typename T>
+void transpose(size_t n, size_t oldWidth, T* a, T* result);
+
+/**
+ * @brief Transposes a square matrix of dimension width in place.
+ */
+template <typename T>
+void transposeSquare(size_t width, T* a);
+
+/**
+ * @brief Multiplies the m x k matrix a by the k x n matrix b, and stores the m x n product in result.
+ */
+template <typename T>
+void matrixMultiply(size_t m, size_t k, size_t n, T* a, T* b, T* result);
+
+/**
+ * @brief Runs a fused elementwise program over a rows x columns matrix, and stores the results in result, whose rows are resultStride apart.
+ */
+template <typename T>
+void evaluate(size_t rows, size_t columns, const ElementwiseProgram<T>& program, T* result, size_t resultStride);
+
+/**
+ * @brief Reduces a rows x columns matrix, or a pair of them for Reduction::Dot and Reduction::Unequal, to a single value.
+ * @param aStride The distance between the starts of consecutive rows of a.
+ * @param bStride The distance between the starts of consecutive rows of b.
+ */
+template <typename T>
+T reduce(size_t rows, size_t columns, Reduction reduction, const T* a, size_t aStride, const T* b = nullptr, size_t bStride = 0);
+
+/**
+ * @brief Zeroes an array of size n.
+ */
+template <typename T>
+void zeroArray(size_t n, T* a);
+
+/**
+ * @brief Fills an array of size n with an identity matrix of dimension width.
+ */
+template <typename T>
+void identityArray(size_t n, size_t width, T* a);
+
+}
+
+#endif //TITANPLUSPLUS_MATRIXBACKEND_H
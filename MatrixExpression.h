@@ -0,0 +1,167 @@
+#ifndef TITANPLUSPLUS_MATRIXEXPRESSION_H
+#define TITANPLUSPLUS_MATRIXEXPRESSION_H
+
+/**
+ * @file MatrixExpression.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief The MatrixExpression class, a lazily evaluated elementwise matrix expression.
+ */
+
+#include <vector>
+#include "ElementwiseProgram.h"
+#include "Matrix.h"
+
+/**
+ * Elementwise operators on expressions don't compute anything. They append to an
+ * ElementwiseProgram that reads the matrices at the leaves of the expression, so an
+ * expression such as a + b - c * 2 becomes one program. The program runs as a single
+ * fused pass over memory, with no temporary matrices, the first time matrix() is called.
+ * The result is kept, so later calls are free.
+ *
+ * A program has a fixed maximum size. When combining two expressions would overflow it,
+ * one side is evaluated first and used as a leaf, so expressions can grow without bound.
+ *
+ * Leaves are MatrixViews, so an expression can read blocks of larger matrices in place. A
+ * block of a matrix is itself an expression that just loads the block, and is only copied
+ * if its value is needed as a whole matrix.
+ *
+ * @brief A matrix, or a pending elementwise expression over matrices.
+ * @tparam T The type of the elements, either float or double.
+ * @class MatrixExpression
+ */
+template <typename T>
+class MatrixExpression {
+public:
+    /**
+     * @brief Creates an expression that is just a matrix.
+     * @param matrix The matrix, shared rather than copied.
+     */
+    MatrixExpression(Matrix<T> matrix);
+
+    /**
+     * @brief Creates an expression that is just a view, without copying it.
+     * @param view The view, which becomes the value if it is a whole matrix and a leaf otherwise.
+     */
+    MatrixExpression(MatrixView<T> view);
+
+    /**
+     * @brief Returns the value of the expression, evaluating it on the first call.
+     */
+    const Matrix<T>& matrix() const;
+
+    /**
+     * @brief Returns a view of the value of the expression, without copying it if the expression is just a view.
+     */
+    MatrixView<T> view() const;
+
+    /**
+     * @brief Returns true if the expression has been evaluated, or was created from a matrix.
+     */
+    bool isEvaluated() const;
+
+    /**
+     * @brief Returns the number of columns the value of the expression has.
+     */
+    int getWidth() const;
+
+    /**
+     * @brief Returns the number of rows the value of the expression has.
+     */
+    int getHeight() const;
+
+    /**
+     * @brief Creates an expression for the element-wise sum of this and rhs.
+     * @throws std::invalid_argument If the operands have different dimensions.
+     */
+    MatrixExpression operator+(const MatrixExpression& rhs) const;
+
+    /**
+     * @brief Creates an expression for the element-wise difference between this and rhs.
+     * @throws std::invalid_argument If the operands have different dimensions.
+     */
+    MatrixExpression operator-(const MatrixExpression& rhs) const;
+
+    /**
+     * @brief Creates an expression for this multiplied by a scalar.
+     */
+    MatrixExpression operator*(const T& scalar) const;
+
+    /**
+     * @brief Creates an expression for the negation of this.
+     */
+    MatrixExpression operator-() const;
+
+    /**
+     * @brief Creates an expression that views a block of the value, evaluating this expression first unless it is just a view.
+     * @throws std::invalid_argument If the block doesn't fit inside the value.
+     */
+    MatrixExpression block(int x, int y, int width, int height) const;
+
+    /**
+     * Evaluates this expression, then runs the program of values straight into the block, so
+     * no temporary matrix is made for values. Values may read this expression's value, in
+     * which case it is copied first (see Matrix::assign()).
+     *
+     * @brief Overwrites the block of the value starting at (x, y) with the value of another expression.
+     * @throws std::invalid_argument If the block doesn't fit inside the value.
+     */
+    void assign(int x, int y, const MatrixExpression& values);
+
+    /**
+     * @brief Sets every entry of a block of the value to a scalar, evaluating this expression first.
+     * @throws std::invalid_argument If the block doesn't fit inside the value.
+     */
+    void assign(int x, int y, int width, int height, T scalar);
+
+private:
+    using Program = ElementwiseProgram<T>;
+    using Step = typename Program::Step;
+
+    /**
+     * @brief Creates an empty expression with the given dimensions.
+     */
+    MatrixExpression(int width, int height);
+
+    /**
+     * @brief Throws if a block with the given position and dimensions can't be assigned to the value.
+     */
+    void checkBlock(int x, int y, int width, int height) const;
+
+    /**
+     * @brief Returns the program of the expression, a single load if it has been evaluated.
+     */
+    Program program() const;
+
+    /**
+     * @brief Appends the steps of an expression, loading its leaves as operands of this expression.
+     * @return False if the steps or operands wouldn't fit, in which case this expression is unchanged.
+     */
+    bool append(const MatrixExpression& other);
+
+    /**
+     * @brief Combines two expressions with a binary step, evaluating one or both first if the result wouldn't fit.
+     */
+    static MatrixExpression combine(const MatrixExpression& lhs, const MatrixExpression& rhs, typename Program::Op op);
+
+    /**
+     * @brief Creates an expression that applies a unary step to another.
+     */
+    static MatrixExpression apply(const MatrixExpression& expression, Step step);
+
+    mutable std::vector<Step> steps;        ///< The steps of the pending program, cleared once evaluated.
+    mutable std::vector<MatrixView<T>> leaves; ///< The views the program reads, released once evaluated.
+    unsigned depth = 0;                     ///< The deepest stack the program needs.
+    int width = 0;                          ///< The width of the value.
+    int height = 0;                         ///< The height of the value.
+    mutable Matrix<T> value{0, 0};          ///< The value, once evaluated.
+    mutable bool evaluated = false;         ///< True once value holds the value of the expression.
+};
+
+//Forward declarations of expression types.
+typedef MatrixExpression<double> MatrixExpressionD; ///< Expression over double precision matrices.
+typedef MatrixExpression<float>  MatrixExpressionF; ///< Expression over single precision matrices.
+
+#include "MatrixExpression.tpp"
+
+#endif //TITANPLUSPLUS_MATRIXEXPRESSION_H
@@ -0,0 +1,214 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#ifndef TITANPLUSPLUS_MATRIXEXPRESSION_TPP
+#define TITANPLUSPLUS_MATRIXEXPRESSION_TPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "MatrixExpression.h"
+
+template <typename T>
+MatrixExpression<T>::MatrixExpression(Matrix<T> matrix)
+        : width(matrix.getWidth()), height(matrix.getHeight()), value(std::move(matrix)), evaluated(true) {}
+
+template <typename T>
+MatrixExpression<T>::MatrixExpression(MatrixView<T> view) : width(view.getWidth()), height(view.getHeight()) {
+    if (view.isWhole()) {
+        value = view.matrix();
+        evaluated = true;
+        return;
+    }
+    steps.push_back({Program::Op::Load, 0, T(0)});
+    leaves.push_back(std::move(view));
+    depth = 1;
+}
+
+template <typename T>
+MatrixExpression<T>::MatrixExpression(int width, int height) : width(width), height(height) {}
+
+template <typename T>
+const Matrix<T>& MatrixExpression<T>::matrix() const {
+    if (!evaluated) {
+        Matrix<T> result(width, height);
+        MatrixBackend::evaluate<T>(height, width, program(), result.data(), width);
+        value = std::move(result);
+        evaluated = true;
+        steps.clear();
+        leaves.clear();
+    }
+    return value;
+}
+
+template <typename T>
+MatrixView<T> MatrixExpression<T>::view() const {
+    if (!evaluated && steps.size() == 1) return leaves[0];
+    return matrix();
+}
+
+template <typename T>
+bool MatrixExpression<T>::isEvaluated() const {
+    return evaluated;
+}
+
+template <typename T>
+int MatrixExpression<T>::getWidth() const {
+    return width;
+}
+
+template <typename T>
+int MatrixExpression<T>::getHeight() const {
+    return height;
+}
+
+template <typename T>
+MatrixExpression<T> MatrixExpression<T>::operator+(const MatrixExpression<T>& rhs) const {
+    return combine(*this, rhs, Program::Op::Add);
+}
+
+template <typename T>
+MatrixExpression<T> MatrixExpression<T>::operator-(const MatrixExpression<T>& rhs) const {
+    return combine(*this, rhs, Program::Op::Subtract);
+}
+
+template <typename T>
+MatrixExpression<T> MatrixExpression<T>::operator*(const T& scalar) const {
+    return apply(*this, {Program::Op::Scale, 0, scalar});
+}
+
+template <typename T>
+MatrixExpression<T> MatrixExpression<T>::operator-() const {
+    return apply(*this, {Program::Op::Negate, 0, T(0)});
+}
+
+template <typename T>
+MatrixExpression<T> MatrixExpression<T>::block(int x, int y, int width, int height) const {
+    return MatrixExpression<T>(view().block(x, y, width, height));
+}
+
+template <typename T>
+void MatrixExpression<T>::assign(int x, int y, const MatrixExpression<T>& values) {
+    checkBlock(x, y, values.width, values.height);
+    //Assigning the whole value to itself changes nothing.
+    if (&values == this || values.width == 0 || values.height == 0) return;
+
+    matrix();
+    //The program's leaves hold references to what they read, so value copies its entries before they are overwritten if they are shared.
+    const Program program = values.program();
+    MatrixBackend::evaluate<T>(values.height, values.width, program, value.data() + (size_t)y * width + x, width);
+}
+
+template <typename T>
+void MatrixExpression<T>::assign(int x, int y, int width, int height, T scalar) {
+    checkBlock(x, y, width, height);
+    if (width == 0 || height == 0) return;
+
+    matrix();
+    T* entries = value.data();
+    for (int row = y; row < y + height; ++row) {
+        std::fill_n(entries + (size_t)row * this->width + x, width, scalar);
+    }
+}
+
+template <typename T>
+void MatrixExpression<T>::checkBlock(int x, int y, int width, int height) const {
+    if (x < 0 || y < 0 || width < 0 || height < 0 || x + width > this->width || y + height > this->height) {
+        throw std::invalid_argument("Cannot assign a " + std::to_string(height) + "x" + std::to_string(width) + " matrix at row " + std::to_string(y)
+                                    + ", column " + std::to_string(x) + " of a " + std::to_string(this->height) + "x"
+                                    + std::to_string(this->width) + " matrix.");
+    }
+}
+
+template <typename T>
+typename MatrixExpression<T>::Program MatrixExpression<T>::program() const {
+    Program program;
+    if (evaluated) {
+        program.steps[program.stepCount++] = {Program::Op::Load, 0, T(0)};
+        program.operands[program.operandCount] = value.data();
+        program.strides[program.operandCount++] = width;
+        return program;
+    }
+    std::copy(steps.begin(), steps.end(), program.steps);
+    program.stepCount = (unsigned)steps.size();
+    for (const MatrixView<T>& leaf : leaves) {
+        program.operands[program.operandCount] = leaf.data();
+        program.strides[program.operandCount++] = leaf.getStride();
+    }
+    return program;
+}
+
+template <typename T>
+bool MatrixExpression<T>::append(const MatrixExpression<T>& other) {
+    //Values already on the stack stay below the other expression's values while it runs.
+    const unsigned below = depth == 0 ? 0 : 1;
+    const unsigned otherDepth = other.evaluated ? 1 : other.depth;
+    const size_t otherSteps = other.evaluated ? 1 : other.steps.size();
+    if (steps.size() + otherSteps >= Program::MaxSteps || below + otherDepth > Program::MaxDepth) return false;
+
+    //An evaluated expression is a single leaf. Leaves both expressions read are only loaded once.
+    std::vector<MatrixView<T>> combined = leaves;
+    std::vector<uint8_t> operands;
+    for (const MatrixView<T>& leaf : other.evaluated ? std::vector<MatrixView<T>>{other.value} : other.leaves) {
+        auto same = std::find_if(combined.begin(), combined.end(), [&](const MatrixView<T>& existing) { return existing.data() == leaf.data(); });
+        operands.push_back((uint8_t)(same - combined.begin()));
+        if (same == combined.end()) combined.push_back(leaf);
+    }
+    if (combined.size() > Program::MaxOperands) return false;
+
+    leaves = std::move(combined);
+    if (other.evaluated) {
+        steps.push_back({Program::Op::Load, operands[0], T(0)});
+    }
+    else {
+        for (Step step : other.steps) {
+            if (step.op == Program::Op::Load) step.operand = operands[step.operand];
+            steps.push_back(step);
+        }
+    }
+    depth = std::max(depth, below + otherDepth);
+    return true;
+}
+
+template <typename T>
+MatrixExpression<T> MatrixExpression<T>::combine(const MatrixExpression<T>& lhs, const MatrixExpression<T>& rhs, typename Program::Op op) {
+    if (lhs.width != rhs.width || lhs.height != rhs.height) {
+        throw std::invalid_argument("Cannot combine a " + std::to_string(lhs.height) + "x" + std::to_string(lhs.width) + " matrix with a "
+                                    + std::to_string(rhs.height) + "x" + std::to_string(rhs.width) + " matrix element-wise.");
+    }
+
+    //Evaluate the right then the left operand until the combined program fits, two leaves always do.
+    for (int evaluate = 0;; ++evaluate) {
+        if (evaluate >= 1) rhs.matrix();
+        if (evaluate >= 2) lhs.matrix();
+
+        MatrixExpression<T> result(lhs.width, lhs.height);
+        if (result.append(lhs) && result.append(rhs)) {
+            result.steps.push_back({op, 0, T(0)});
+            return result;
+        }
+    }
+}
+
+template <typename T>
+MatrixExpression<T> MatrixExpression<T>::apply(const MatrixExpression<T>& expression, Step step) {
+    for (int evaluate = 0;; ++evaluate) {
+        if (evaluate >= 1) expression.matrix();
+
+        MatrixExpression<T> result(expression.width, expression.height);
+        if (result.append(expression)) {
+            //Consecutive scales fold into one.
+            if (step.op == Program::Op::Scale && result.steps.back().op == Program::Op::Scale) {
+                result.steps.back().scalar *= step.scalar;
+            }
+            else {
+                result.steps.push_back(step);
+            }
+            return result;
+        }
+    }
+}
+
+#endif //TITANPLUSPLUS_MATRIXEXPRESSION_TPP
@@ -0,0 +1,186 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include "MatrixFile.h"
+
+namespace {
+const char Magic[4] = {'T', 'T', 'N', 'M'}; ///< First four bytes of every matrix file.
+
+/**
+ * @brief The fixed-size header at the start of every matrix file.
+ */
+struct Header {
+    char magic[4];      ///< Always Magic.
+    uint32_t version;   ///< MatrixFile::Version of the writer.
+    uint32_t element;   ///< The MatrixFile::Element of the entries.
+    uint32_t alignment; ///< The alignment of the entries within the file.
+    uint64_t width;     ///< The number of columns.
+    uint64_t height;    ///< The number of rows, filled in when the writer is closed.
+    uint64_t offset;    ///< The byte offset of the first entry.
+};
+
+/**
+ * @brief Returns the MatrixFile::Element stored for entries of type T.
+ */
+template <typename T>
+constexpr MatrixFile::Element elementOf() {
+    return sizeof(T) == sizeof(float) ? MatrixFile::Element::Float : MatrixFile::Element::Double;
+}
+
+/**
+ * @brief Returns the size in bytes of an entry of the given type.
+ */
+size_t elementSize(MatrixFile::Element element) {
+    return element == MatrixFile::Element::Float ? sizeof(float) : sizeof(double);
+}
+
+/**
+ * @brief Reads the header of a mapped matrix file, checking it describes entries that fit inside the file.
+ * @throws std::invalid_argument If the header is missing, corrupt or from an incompatible version.
+ */
+Header readHeader(const MappedFile& file) {
+    Header header{};
+    if (!MatrixFile::isMatrixFile(file) || file.size() < sizeof(Header)) {
+        throw std::invalid_argument("Not a Titan matrix file.");
+    }
+    std::memcpy(&header, file.data(), sizeof(Header));
+    if (header.version != MatrixFile::Version) {
+        throw std::invalid_argument("Matrix file was written by an incompatible version of Titan.");
+    }
+
+    const auto element = (MatrixFile::Element)header.element;
+    if (element != MatrixFile::Element::Float && element != MatrixFile::Element::Double) {
+        throw std::invalid_argument("Matrix file has an unknown element type.");
+    }
+    //The mapping is page aligned, so the entries are aligned for their type if their offset is.
+    const size_t size = elementSize(element);
+    if (header.alignment == 0 || header.alignment % size != 0 || header.offset % header.alignment != 0 || header.offset < sizeof(Header)) {
+        throw std::invalid_argument("Matrix file has misaligned entries.");
+    }
+    if (header.width > INT_MAX || header.height > INT_MAX || (header.width > 0 && header.height > SIZE_MAX / size / header.width)) {
+        throw std::invalid_argument("Matrix file is too large.");
+    }
+    if (header.offset > file.size() || header.width * header.height * size > file.size() - header.offset) {
+        throw std::invalid_argument("Matrix file is truncated.");
+    }
+    return header;
+}
+}
+
+bool MatrixFile::isMatrixFile(const MappedFile &file) {
+    return file.size() >= sizeof(Magic) && std::memcmp(file.data(), Magic, sizeof(Magic)) == 0;
+}
+
+MatrixFile::Element MatrixFile::element(const MappedFile &file) {
+    return (Element)readHeader(file).element;
+}
+
+template <typename T>
+Matrix<T> MatrixFile::load(MappedFile file) {
+    const Header header = readHeader(file);
+    if ((Element)header.element != elementOf<T>()) {
+        throw std::invalid_argument(std::string("Matrix file has ") + (sizeof(T) == sizeof(float) ? "double" : "single")
+                                    + " precision entries, not " + (sizeof(T) == sizeof(float) ? "single" : "double") + " precision.");
+    }
+    const int width = (int)header.width;
+    const int height = (int)header.height;
+    T* entries = reinterpret_cast<T*>(file.writableData() + header.offset);
+
+    //CUDA kernels can't read a host mapping, so the entries are copied into managed memory.
+    if (MatrixBackend::device() != MatrixBackend::Device::CPU) {
+        Matrix<T> matrix(width, height);
+        MatrixBackend::copy(matrix.size(), entries, matrix.data());
+        return matrix;
+    }
+    auto* mapping = new MappedFile(std::move(file));
+    return Matrix<T>::adopt(width, height, entries, [](void* owner) { delete static_cast<MappedFile*>(owner); }, mapping);
+}
+
+template <typename T>
+Matrix<T> MatrixFile::load(const std::string &path) {
+    MappedFile file;
+    if (!file.open(path, MappedFile::Access::CopyOnWrite)) {
+        throw std::invalid_argument("Cannot open matrix file '" + path + "'.");
+    }
+    return load<T>(std::move(file));
+}
+
+template <typename T>
+MatrixWriter<T>::~MatrixWriter() {
+    if (stream.is_open()) close();
+}
+
+template <typename T>
+bool MatrixWriter<T>::open(const std::string &path, int width) {
+    if (stream.is_open()) close();
+    stream.open(path, std::ios::binary | std::ios::trunc);
+    if (!stream || width < 0) return false;
+    this->width = width;
+    height = 0;
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = MatrixFile::Version;
+    header.element = (uint32_t)elementOf<T>();
+    header.alignment = MatrixFile::Alignment;
+    header.width = (uint64_t)width;
+    header.offset = MatrixFile::Alignment;
+    static_assert(sizeof(Header) <= MatrixFile::Alignment, "The header must fit before the first entry.");
+
+    char padding[MatrixFile::Alignment] = {};
+    std::memcpy(padding, &header, sizeof(Header));
+    stream.write(padding, sizeof(padding));
+    return (bool)stream;
+}
+
+template <typename T>
+bool MatrixWriter<T>::write(const T *entries, size_t rows) {
+    if (!stream.is_open()) return false;
+    stream.write(reinterpret_cast<const char*>(entries), (std::streamsize)(rows * width * sizeof(T)));
+    height += rows;
+    return (bool)stream;
+}
+
+template <typename T>
+bool MatrixWriter<T>::write(const MatrixView<T> &rows) {
+    if (!stream.is_open() || rows.getWidth() != width) return false;
+    if (rows.getStride() == (size_t)width) return write(rows.data(), rows.getHeight());
+    //The rows of a narrower block are a stride apart, so they are written one at a time.
+    for (int y = 0; y < rows.getHeight(); ++y) {
+        if (!write(rows.data() + y * rows.getStride(), 1)) return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool MatrixWriter<T>::close() {
+    if (!stream.is_open()) return false;
+    stream.seekp(offsetof(Header, height));
+    stream.write(reinterpret_cast<const char*>(&height), sizeof(height));
+    const bool written = (bool)stream;
+    stream.close();
+    return written && !stream.fail();
+}
+
+template <typename T>
+bool MatrixWriter<T>::save(const MatrixView<T> &matrix, const std::string &path) {
+    MatrixWriter<T> writer;
+    return writer.open(path, matrix.getWidth()) && writer.write(matrix) && writer.close();
+}
+
+///Forward declarations
+//Loading
+template MatrixF MatrixFile::load<float>(MappedFile file);
+template MatrixD MatrixFile::load<double>(MappedFile file);
+template MatrixF MatrixFile::load<float>(const std::string& path);
+template MatrixD MatrixFile::load<double>(const std::string& path);
+
+//Writing
+template class MatrixWriter<float>;
+template class MatrixWriter<double>;
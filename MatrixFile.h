@@ -0,0 +1,145 @@
+#ifndef TITANPLUSPLUS_MATRIXFILE_H
+#define TITANPLUSPLUS_MATRIXFILE_H
+
+/**
+ * @file MatrixFile.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains the MatrixFile class, which loads matrix files, and the MatrixWriter class, which writes them.
+ */
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "MappedFile.h"
+#include "Matrix.h"
+
+/**
+ * Matrices are stored in a binary format whose entries can be used straight out of a
+ * memory-mapped file, so loading one costs no parsing and no copying. All fields are
+ * stored in the host's native byte order:
+ *
+ * | Field     | Contents                                                               |
+ * |-----------|------------------------------------------------------------------------|
+ * | Header    | Magic "TTNM", format Version, element type and the alignment of entries |
+ * | Shape     | uint64 width and height                                                |
+ * | Offset    | uint64 byte offset of the entries, a multiple of the alignment          |
+ * | Entries   | width * height raw floats or doubles, stored row by row                 |
+ *
+ * Files are written with MatrixWriter, which streams rows so a matrix never has to be
+ * held in memory whole.
+ *
+ * @class MatrixFile
+ * @brief Loads matrix files.
+ */
+struct MatrixFile {
+    static const uint32_t Version = 1;    ///< Bump whenever the layout of the format changes.
+    static const uint32_t Alignment = 64; ///< The alignment of the entries within the file, a cache line.
+
+    /**
+     * @brief The type of a matrix file's entries.
+     */
+    enum class Element : uint32_t {
+        Float = 1,  ///< Single precision entries, loaded as a MatrixF.
+        Double = 2, ///< Double precision entries, loaded as a MatrixD.
+    };
+
+    /**
+     * @brief Tests whether a mapped file starts with the matrix file magic.
+     * @param file The mapped file to test.
+     * @return True if the file looks like a matrix file, otherwise false.
+     */
+    static bool isMatrixFile(const MappedFile& file);
+
+    /**
+     * @brief Reads the type of the entries of a mapped matrix file, checking its header.
+     * @param file The mapped matrix file.
+     * @throws std::invalid_argument If the file isn't a matrix file, was written by an incompatible version of Titan, or is truncated.
+     */
+    static Element element(const MappedFile& file);
+
+    /**
+     * On the CPU backend the matrix uses the entries in place, and the mapping is released
+     * once no copy of the matrix shares them. Writing to the matrix never changes the file.
+     * The CUDA backend needs managed memory, so the entries are copied into it instead.
+     *
+     * @brief Loads the matrix in a file mapped with MappedFile::Access::CopyOnWrite.
+     * @tparam T The type of the entries, which must match element(file).
+     * @param file The mapped matrix file, taken over by the matrix.
+     * @throws std::invalid_argument If the file isn't a valid matrix file with entries of type T.
+     */
+    template <typename T>
+    static Matrix<T> load(MappedFile file);
+
+    /**
+     * @brief Maps and loads the matrix file at the given path.
+     * @tparam T The type of the entries, which must match the file's.
+     * @param path The path of the file to load.
+     * @throws std::invalid_argument If the file can't be opened or isn't a valid matrix file with entries of type T.
+     */
+    template <typename T>
+    static Matrix<T> load(const std::string& path);
+};
+
+/**
+ * Rows are appended as they are produced and the height is filled in by close(), so a
+ * matrix can be written without knowing its height or holding it in memory.
+ *
+ * @brief Writes a matrix file one block of rows at a time.
+ * @tparam T The type of the entries, either float or double.
+ * @class MatrixWriter
+ */
+template <typename T>
+class MatrixWriter {
+public:
+    MatrixWriter() = default;
+
+    /**
+     * @brief Closes the file if it is still open.
+     */
+    ~MatrixWriter();
+
+    MatrixWriter(const MatrixWriter&) = delete;
+    MatrixWriter& operator=(const MatrixWriter&) = delete;
+
+    /**
+     * @brief Creates a matrix file and writes its header, closing any file already open.
+     * @param path The path of the file to write.
+     * @param width The number of columns in the matrix.
+     * @return True if the file was created, otherwise false.
+     */
+    bool open(const std::string& path, int width);
+
+    /**
+     * @brief Appends rows to the matrix.
+     * @param entries The entries of the rows, stored row by row.
+     * @param rows The number of rows to append.
+     * @return True if the rows were written, otherwise false.
+     */
+    bool write(const T* entries, size_t rows);
+
+    /**
+     * @brief Appends the rows of a matrix or a block of one, which must have the width the writer was opened with.
+     * @return True if the rows were written, otherwise false.
+     */
+    bool write(const MatrixView<T>& rows);
+
+    /**
+     * @brief Writes the height of the matrix into the header and closes the file.
+     * @return True if every write succeeded, otherwise false.
+     */
+    bool close();
+
+    /**
+     * @brief Writes a whole matrix, or a block of one, to a matrix file.
+     * @return True if the file was written, otherwise false.
+     */
+    static bool save(const MatrixView<T>& matrix, const std::string& path);
+
+private:
+    std::ofstream stream; ///< The file being written.
+    int width = 0;        ///< The number of columns in the matrix.
+    uint64_t height = 0;  ///< The number of rows written so far.
+};
+
+#endif //TITANPLUSPLUS_MATRIXFILE_H
@@ -0,0 +1,171 @@
+#ifndef TITANPLUSPLUS_MATRIXVIEW_H
+#define TITANPLUSPLUS_MATRIXVIEW_H
+
+/**
+ * @file MatrixView.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief The MatrixView class, a read-only block of a matrix that doesn't copy its entries.
+ */
+
+#include <string>
+#include "Matrix.h"
+
+/**
+ * A view is a rectangular block of a matrix, such as a row, a column or a sub-block. It holds
+ * a shared reference to the matrix's entries, so taking a view is O(1) and the entries live at
+ * least as long as the view. The block's rows are a stride apart in the matrix, which the
+ * elementwise kernels and reductions of MatrixBackend read directly, so nothing is copied.
+ *
+ * Like a copy of a matrix, a view keeps the values the matrix had when it was taken: writing
+ * to the matrix afterwards gives the matrix its own entries first (copy-on-write).
+ *
+ * @brief A block of a matrix, read in place.
+ * @tparam T The type of the elements, either float or double.
+ * @class MatrixView
+ */
+template <typename T>
+class MatrixView {
+public:
+    /**
+     * @brief Creates a view of a whole matrix.
+     * @param matrix The matrix, shared rather than copied.
+     */
+    MatrixView(Matrix<T> matrix);
+
+    /**
+     * @brief Creates a view of a block of a matrix.
+     * @param matrix The matrix, shared rather than copied.
+     * @param x The column of the block's first entry.
+     * @param y The row of the block's first entry.
+     * @param width The number of columns in the block.
+     * @param height The number of rows in the block.
+     * @throws std::invalid_argument If the block doesn't fit inside the matrix.
+     */
+    MatrixView(Matrix<T> matrix, int x, int y, int width, int height);
+
+    /**
+     * @brief Returns the number of columns in the view.
+     */
+    int getWidth() const;
+
+    /**
+     * @brief Returns the number of rows in the view.
+     */
+    int getHeight() const;
+
+    /**
+     * @brief Returns the number of entries in the view.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the distance between the starts of consecutive rows, the width of the viewed matrix.
+     */
+    size_t getStride() const;
+
+    /**
+     * @brief Returns true if the view is the whole of its matrix.
+     */
+    bool isWhole() const;
+
+    /**
+     * @brief Returns a pointer to the view's first entry. Later rows start getStride() entries apart.
+     */
+    const T* data() const;
+
+    /**
+     * @brief Creates a const reference to a specific entry.
+     * @param x The x coordinate of the entry, relative to the view.
+     * @param y The y coordinate of the entry, relative to the view.
+     */
+    const T& operator()(int x, int y) const;
+
+    /**
+     * @brief Creates a view of a row of this view.
+     * @throws std::invalid_argument If the row is out of range.
+     */
+    MatrixView row(int y) const;
+
+    /**
+     * @brief Creates a view of a column of this view.
+     * @throws std::invalid_argument If the column is out of range.
+     */
+    MatrixView column(int x) const;
+
+    /**
+     * @brief Creates a view of a block of this view, with coordinates relative to this view.
+     * @throws std::invalid_argument If the block doesn't fit inside this view.
+     */
+    MatrixView block(int x, int y, int width, int height) const;
+
+    /**
+     * @brief Creates a matrix with the entries of the view, sharing them rather than copying if the view is the whole matrix.
+     */
+    Matrix<T> matrix() const;
+
+    /**
+     * @brief Returns the sum of the entries, or 0 if the view is empty.
+     */
+    T sum() const;
+
+    /**
+     * @brief Returns the mean of the entries.
+     * @throws std::invalid_argument If the view is empty.
+     */
+    T mean() const;
+
+    /**
+     * @brief Returns the smallest entry.
+     * @throws std::invalid_argument If the view is empty.
+     */
+    T min() const;
+
+    /**
+     * @brief Returns the largest entry.
+     * @throws std::invalid_argument If the view is empty.
+     */
+    T max() const;
+
+    /**
+     * @brief Returns the L1 norm of the entries, the sum of their absolute values.
+     */
+    T norm1() const;
+
+    /**
+     * @brief Returns the square root of the sum of the squares of the entries.
+     */
+    T norm2() const;
+
+    /**
+     * @brief Returns the sum of the products of the entries of this view and rhs.
+     * @param rhs The other operand, which must have the same dimensions as this view.
+     * @throws std::invalid_argument If the dimensions of the operands don't match.
+     */
+    T dot(const MatrixView& rhs) const;
+
+    /**
+     * @brief Creates a human-readable string representation of the entries of the view.
+     */
+    std::string toString() const;
+
+private:
+    /**
+     * @brief Reduces the entries of the view, or of the view and rhs.
+     */
+    T reduce(Reduction reduction, const MatrixView* rhs = nullptr) const;
+
+    Matrix<T> source; ///< The viewed matrix, sharing its entries.
+    int x = 0;        ///< The column of the view's first entry in the matrix.
+    int y = 0;        ///< The row of the view's first entry in the matrix.
+    int width = 0;    ///< The number of columns in the view.
+    int height = 0;   ///< The number of rows in the view.
+};
+
+//Forward declarations of view types.
+typedef MatrixView<double> MatrixViewD; ///< View of a double precision matrix.
+typedef MatrixView<float>  MatrixViewF; ///< View of a single precision matrix.
+
+#include "MatrixView.tpp"
+
+#endif //TITANPLUSPLUS_MATRIXVIEW_H
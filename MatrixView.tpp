@@ -0,0 +1,155 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#ifndef TITANPLUSPLUS_MATRIXVIEW_TPP
+#define TITANPLUSPLUS_MATRIXVIEW_TPP
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "MatrixView.h"
+
+template <typename T>
+MatrixView<T>::MatrixView(Matrix<T> matrix)
+        : source(std::move(matrix)), width(source.getWidth()), height(source.getHeight()) {}
+
+template <typename T>
+MatrixView<T>::MatrixView(Matrix<T> matrix, int x, int y, int width, int height)
+        : source(std::move(matrix)), x(x), y(y), width(width), height(height) {
+    if (x < 0 || y < 0 || width < 0 || height < 0 || x + width > source.getWidth() || y + height > source.getHeight()) {
+        throw std::invalid_argument("Cannot take a " + std::to_string(height) + "x" + std::to_string(width) + " block at row " + std::to_string(y)
+                                    + ", column " + std::to_string(x) + " of a " + std::to_string(source.getHeight()) + "x"
+                                    + std::to_string(source.getWidth()) + " matrix.");
+    }
+}
+
+template <typename T>
+int MatrixView<T>::getWidth() const {
+    return width;
+}
+
+template <typename T>
+int MatrixView<T>::getHeight() const {
+    return height;
+}
+
+template <typename T>
+size_t MatrixView<T>::size() const {
+    return (size_t)width * height;
+}
+
+template <typename T>
+size_t MatrixView<T>::getStride() const {
+    return source.getWidth();
+}
+
+template <typename T>
+bool MatrixView<T>::isWhole() const {
+    return size() == source.size();
+}
+
+template <typename T>
+const T* MatrixView<T>::data() const {
+    return source.data() + (size_t)y * getStride() + x;
+}
+
+template <typename T>
+const T& MatrixView<T>::operator()(int x, int y) const {
+    return data()[x + y * getStride()];
+}
+
+template <typename T>
+MatrixView<T> MatrixView<T>::row(int y) const {
+    return block(0, y, width, 1);
+}
+
+template <typename T>
+MatrixView<T> MatrixView<T>::column(int x) const {
+    return block(x, 0, 1, height);
+}
+
+template <typename T>
+MatrixView<T> MatrixView<T>::block(int x, int y, int width, int height) const {
+    if (x < 0 || y < 0 || width < 0 || height < 0 || x + width > this->width || y + height > this->height) {
+        throw std::invalid_argument("Cannot take a " + std::to_string(height) + "x" + std::to_string(width) + " block at row " + std::to_string(y)
+                                    + ", column " + std::to_string(x) + " of a " + std::to_string(this->height) + "x"
+                                    + std::to_string(this->width) + " matrix.");
+    }
+    return MatrixView<T>(source, this->x + x, this->y + y, width, height);
+}
+
+template <typename T>
+Matrix<T> MatrixView<T>::matrix() const {
+    if (isWhole()) return source;
+    Matrix<T> copy(width, height);
+    copy.assign(0, 0, *this);
+    return copy;
+}
+
+template <typename T>
+T MatrixView<T>::sum() const {
+    return reduce(Reduction::Sum);
+}
+
+template <typename T>
+T MatrixView<T>::mean() const {
+    if (size() == 0) throw std::invalid_argument("Cannot take the mean of an empty matrix.");
+    return sum() / (T)size();
+}
+
+template <typename T>
+T MatrixView<T>::min() const {
+    if (size() == 0) throw std::invalid_argument("Cannot take the minimum of an empty matrix.");
+    return reduce(Reduction::Min);
+}
+
+template <typename T>
+T MatrixView<T>::max() const {
+    if (size() == 0) throw std::invalid_argument("Cannot take the maximum of an empty matrix.");
+    return reduce(Reduction::Max);
+}
+
+template <typename T>
+T MatrixView<T>::norm1() const {
+    return reduce(Reduction::AbsoluteSum);
+}
+
+template <typename T>
+T MatrixView<T>::norm2() const {
+    return std::sqrt(reduce(Reduction::SquareSum));
+}
+
+template <typename T>
+T MatrixView<T>::dot(const MatrixView<T>& rhs) const {
+    if (width != rhs.width || height != rhs.height) {
+        throw std::invalid_argument("Cannot take the dot product of a " + std::to_string(height) + "x" + std::to_string(width) + " matrix and a "
+                                    + std::to_string(rhs.height) + "x" + std::to_string(rhs.width) + " matrix.");
+    }
+    return reduce(Reduction::Dot, &rhs);
+}
+
+template <typename T>
+std::string MatrixView<T>::toString() const {
+    std::stringstream stream;
+    stream << "[";
+    for (int y = 0; y < height; ++y) {
+        if (y > 0) stream << "] [";
+        for (int x = 0; x < width; ++x) {
+            if (x > 0) stream << ", ";
+            stream << (*this)(x, y);
+        }
+    }
+    stream << "]";
+    return stream.str();
+}
+
+template <typename T>
+T MatrixView<T>::reduce(Reduction reduction, const MatrixView<T>* rhs) const {
+    return MatrixBackend::reduce<T>(height, width, reduction, data(), getStride(), rhs == nullptr ? nullptr : rhs->data(),
+                                    rhs == nullptr ? 0 : rhs->getStride());
+}
+
+#endif //TITANPLUSPLUS_MATRIXVIEW_TPP
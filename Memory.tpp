@@ -45,7 +45,8 @@ T Memory::toValue(const std::vector<Op::Code> &codes) {
 
 template<typename T>
 T Memory::toValue(Op::Code a, Op::Code b) {
-    return toValue<T>(std::vector<Op::Code>{a, b});
+    //Same layout as toValue(std::vector), without allocating a vector on the VM's hot path.
+    return (T)a | ((T)b << (8 * sizeof (Op::Code)));
 }
 
 #endif //TITANPLUSPLUS_MEMORY_TPP
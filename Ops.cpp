@@ -1,22 +1,30 @@
+#include "Builtins.h"
 #include "Ops.h"
 
 int Op::instructionLength(Op::Code op) {
     switch (op) {
         case Add:            return 1;
+        case AddConstant:    return 2;
+        case CallBuiltin:    return 2;
         case Constant32:     return 3;
         case Constant:       return 2;
         case DefineGlobal32: return 3;
         case DefineGlobal:   return 2;
         case Divide:         return 1;
+        case DivideConstant: return 2;
         case Equal:          return 1;
         case False:          return 1;
         case GetGlobal32:    return 3;
         case GetGlobal:      return 2;
+        case GetGlobalAddConstant: return 3;
+        case GetIndex:       return 2;
+        case GetLocal:       return 2;
         case Greater:        return 1;
         case GreaterEqual:   return 1;
         case Less:           return 1;
         case LessEqual:      return 1;
         case Multiply:       return 1;
+        case MultiplyConstant: return 2;
         case Negate:         return 1;
         case Not:            return 1;
         case NotEqual:       return 1;
@@ -24,7 +32,14 @@ int Op::instructionLength(Op::Code op) {
         case Pop:            return 1;
         case Print:          return 1;
         case Return:         return 1;
+        case SetGlobal32:    return 3;
+        case SetGlobal:      return 2;
+        case SetGlobalIndex32: return 4;
+        case SetGlobalIndex: return 3;
+        case SetLocal:       return 2;
+        case SetLocalIndex:  return 3;
         case Subtract:       return 1;
+        case SubtractConstant: return 2;
         case True:           return 1;
         default:             return 1;
     }
@@ -33,20 +48,27 @@ int Op::instructionLength(Op::Code op) {
 std::string Op::instructionName(Op::Code op) {
     switch (op) {
         case Add:             return "OP_ADD";
+        case AddConstant:     return "OP_ADD_CONSTANT";
+        case CallBuiltin:     return "OP_CALL_BUILTIN";
         case Constant32:      return "OP_CONSTANT_32";
         case Constant:        return "OP_CONSTANT";
         case DefineGlobal32:  return "OP_DEFINE_GLOBAL_32";
         case DefineGlobal:    return "OP_DEFINE_GLOBAL";
         case Divide:          return "OP_DIVIDE";
+        case DivideConstant:  return "OP_DIVIDE_CONSTANT";
         case Equal:           return "OP_EQUAL";
         case False:           return "OP_FALSE";
         case GetGlobal32:     return "OP_GET_GLOBAL_32";
         case GetGlobal:       return "OP_GET_GLOBAL";
+        case GetGlobalAddConstant: return "OP_GET_GLOBAL_ADD_CONSTANT";
+        case GetIndex:        return "OP_GET_INDEX";
+        case GetLocal:        return "OP_GET_LOCAL";
         case Greater:         return "OP_GREATER";
         case GreaterEqual:    return "OP_GREATER_EQUAL";
         case Less:            return "OP_LESS";
         case LessEqual:       return "OP_LESS_EQUAL";
         case Multiply:        return "OP_MULTIPLY";
+        case MultiplyConstant: return "OP_MULTIPLY_CONSTANT";
         case Negate:          return "OP_NEGATE";
         case Not:             return "OP_NOT";
         case NotEqual:        return "OP_NOT_EQUAL";
@@ -54,9 +76,55 @@ std::string Op::instructionName(Op::Code op) {
         case Pop:             return "OP_POP";
         case Print:           return "OP_PRINT";
         case Return:          return "OP_RETURN";
+        case SetGlobal32:     return "OP_SET_GLOBAL_32";
+        case SetGlobal:       return "OP_SET_GLOBAL";
+        case SetGlobalIndex32: return "OP_SET_GLOBAL_INDEX_32";
+        case SetGlobalIndex:  return "OP_SET_GLOBAL_INDEX";
+        case SetLocal:        return "OP_SET_LOCAL";
+        case SetLocalIndex:   return "OP_SET_LOCAL_INDEX";
         case Subtract:        return "OP_SUBTRACT";
+        case SubtractConstant: return "OP_SUBTRACT_CONSTANT";
         case True:            return "OP_TRUE";
         default:              return "Unknown Op: " + std::to_string(op);
     }
 }
 
+
+
+size_t Op::subscriptLength(uint16_t flags) {
+    return 2 + (flags & Subscript::RowRange ? 1 : 0) + (flags & Subscript::ColumnRange ? 1 : 0);
+}
+
+int Op::stackEffect(const Op::Code* instruction) {
+    switch (instruction[0]) {
+        case Add:            return -1;
+        case CallBuiltin:    return 1 - Builtins::arity((Builtins::Function)instruction[1]);
+        case Constant32:     return 1;
+        case Constant:       return 1;
+        case DefineGlobal32: return -1;
+        case DefineGlobal:   return -1;
+        case Divide:         return -1;
+        case Equal:          return -1;
+        case False:          return 1;
+        case GetGlobal32:    return 1;
+        case GetGlobal:      return 1;
+        case GetGlobalAddConstant: return 1;
+        case GetIndex:       return -(int)subscriptLength(instruction[1]);
+        case GetLocal:       return 1;
+        case Greater:        return -1;
+        case GreaterEqual:   return -1;
+        case Less:           return -1;
+        case LessEqual:      return -1;
+        case Multiply:       return -1;
+        case NotEqual:       return -1;
+        case Null:           return 1;
+        case Pop:            return -1;
+        case Print:          return -1;
+        case SetGlobalIndex32: return -(int)subscriptLength(instruction[3]) - 1;
+        case SetGlobalIndex: return -(int)subscriptLength(instruction[2]) - 1;
+        case SetLocalIndex:  return -(int)subscriptLength(instruction[2]) - 1;
+        case Subtract:       return -1;
+        case True:           return 1;
+        default:             return 0;
+    }
+}
@@ -20,20 +20,27 @@ struct Op {
     ///List of all OpCodes, each is two byte.
     enum Code : uint16_t {
         Add,            ///< Adds and pops the two values at the back of the stack, then pushes the result.
+        AddConstant,    ///< Superinstruction for Constant, Add. Adds the constant given by the next Op::Code to the stack top.
+        CallBuiltin,    ///< Calls the Builtins::Function given by the next Op::Code, replacing its arguments on the stack with the result.
         Constant32,     ///< Load a 32-bit constant from the stream as an index for the constant pool.
         Constant,       ///< Load a constant using the next Op::Code in stream as an index for the constant pool.
-        DefineGlobal32, ///< Define a global variable with a 32-bit index in the VM's globals array.
-        DefineGlobal,   ///< Define a global variable in the VM's globals array.
+        DefineGlobal32, ///< Pops the stack top into the global variable slot given by a 32-bit operand.
+        DefineGlobal,   ///< Pops the stack top into the global variable slot given by the next Op::Code.
         Divide,         ///< Divides and pops the two values at the back of the stack, then pushes the result.
+        DivideConstant, ///< Superinstruction for Constant, Divide. Divides the stack top by the constant given by the next Op::Code.
         Equal,          ///< Tests if the top two values on the stack are equal.
         False,          ///< Represents a boolean 'false' value.
-        GetGlobal32,    ///< Loads a 32-bit-addressed global onto the stack.
-        GetGlobal,      ///< Loads a global onto the stack.
+        GetGlobal32,    ///< Pushes the global variable in the slot given by a 32-bit operand.
+        GetGlobal,      ///< Pushes the global variable in the slot given by the next Op::Code.
+        GetGlobalAddConstant, ///< Superinstruction for GetGlobal, Constant, Add. Operands are the global slot then the constant index.
+        GetIndex,       ///< Replaces a matrix and the subscript after it on the stack with the entry or block it selects. The next Op::Code holds Op::Subscript flags.
+        GetLocal,       ///< Pushes the local variable in the stack slot given by the next Op::Code.
         Greater,        ///< Tests the top two values of the stack and returns true if the second-most is greater.
         GreaterEqual,   ///< Tests the top two values of the stack and returns false if the second-most is lesser.
         Less,           ///< Tests the top two values of the stack and returns true if the second-most is lesser.
         LessEqual,      ///< Tests the top two values of the stack and returns false if the second-most is greater.
         Multiply,       ///< Multiplies and pops the two values at the back of the stack, then pushes the result.
+        MultiplyConstant, ///< Superinstruction for Constant, Multiply. Multiplies the stack top by the constant given by the next Op::Code.
         Negate,         ///< Negate the result from the top of the VM's stack.
         Not,            ///< Logically negate the top of the VM's stack.
         NotEqual,       ///< Tests if the topmost two values on the stack are inequal.
@@ -41,8 +48,29 @@ struct Op {
         Pop,            ///< Pops the top value from the stack.
         Print,          ///< Prints and pops a value from the stack.
         Return,         ///< Exit from VM processing cycle.
+        SetGlobal32,    ///< Assigns the stack top to the global variable slot given by a 32-bit operand, leaving it on the stack.
+        SetGlobal,      ///< Assigns the stack top to the global variable slot given by the next Op::Code, leaving it on the stack.
+        SetGlobalIndex32, ///< SetGlobalIndex with a 32-bit slot operand.
+        SetGlobalIndex, ///< Assigns the stack top to the entry or block of a global matrix selected by the subscript below it. Operands are the slot then Op::Subscript flags.
+        SetLocal,       ///< Assigns the stack top to the local variable in the stack slot given by the next Op::Code, leaving it on the stack.
+        SetLocalIndex,  ///< SetGlobalIndex for the local matrix in the stack slot given by the next Op::Code. Operands are the slot then Op::Subscript flags.
         Subtract,       ///< Subtracts and pops the two values at the back of the stack, then pushes the result.
+        SubtractConstant, ///< Superinstruction for Constant, Subtract. Subtracts the constant given by the next Op::Code from the stack top.
         True,           ///< Represents a boolean 'true' value.
+
+        //Number of op codes (Must be last)
+        SIZE,
+    };
+
+    /**
+     * A subscript is pushed as one value per dimension for an index, or two for a range, whose
+     * bounds are null where they were left out. Rows come before columns.
+     *
+     * @brief Flags for the operand of GetIndex and SetGlobalIndex, marking which dimensions of a subscript are ranges.
+     */
+    enum Subscript : uint16_t {
+        RowRange    = 1, ///< The rows are selected by a range, not a single index.
+        ColumnRange = 2, ///< The columns are selected by a range, not a single index.
     };
 
     /**
@@ -69,6 +97,20 @@ struct Op {
      * @return The name of the provided Op::Code as a human-readable string.
      */
     static std::string instructionName(Code op);
+
+    /**
+     * @brief Returns the number of values a subscript with the given Op::Subscript flags takes up on the stack.
+     */
+    static size_t subscriptLength(uint16_t flags);
+
+    /**
+     * Titan has no jumps, so summing the effects of a batch's instructions in order
+     * follows the depth of the stack exactly.
+     *
+     * @brief Returns the number of values an instruction leaves on the stack, minus the number it pops.
+     * @param instruction Pointer to the instruction's Op::Code, followed by its operands.
+     */
+    static int stackEffect(const Code* instruction);
 };
 
 #endif //TITANPLUSPLUS_OPS_H
@@ -0,0 +1,96 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#include <initializer_list>
+#include "Optimiser.h"
+
+namespace {
+/**
+ * @brief Returns the superinstruction that applies an arithmetic op to a constant, or Op::Code::SIZE if there isn't one.
+ */
+Op::Code withConstantOperand(Op::Code op) {
+    switch (op) {
+        case Op::Code::Add:      return Op::Code::AddConstant;
+        case Op::Code::Subtract: return Op::Code::SubtractConstant;
+        case Op::Code::Multiply: return Op::Code::MultiplyConstant;
+        case Op::Code::Divide:   return Op::Code::DivideConstant;
+        default:                 return Op::Code::SIZE;
+    }
+}
+
+/**
+ * @brief Returns true if the op pushes a value without any other effect.
+ */
+bool isPureLoad(Op::Code op) {
+    switch (op) {
+        case Op::Code::Constant:
+        case Op::Code::Constant32:
+        case Op::Code::False:
+        case Op::Code::GetLocal:
+        case Op::Code::Null:
+        case Op::Code::True:
+            return true;
+        default:
+            return false;
+    }
+}
+}
+
+void Optimiser::optimise(Batch &batch) {
+    //Index of the first Op::Code of each instruction.
+    std::vector<size_t> starts;
+    for (size_t index = 0; index < batch.opcodes.size(); index += Op::instructionLength(batch.opcodes[index])) {
+        starts.push_back(index);
+    }
+
+    std::vector<Op::Code> opcodes;
+    std::vector<int> lines;
+    opcodes.reserve(batch.opcodes.size());
+    lines.reserve(batch.lines.size());
+
+    auto op = [&](size_t n) {
+        return n < starts.size() ? batch.opcodes[starts[n]] : Op::Code::SIZE;
+    };
+    auto operand = [&](size_t n) {
+        return batch.opcodes[starts[n] + 1];
+    };
+    auto line = [&](size_t n) {
+        return batch.lines[starts[n]];
+    };
+    auto emit = [&](std::initializer_list<Op::Code> codes, int lineNum) {
+        for (Op::Code code : codes) {
+            opcodes.push_back(code);
+            lines.push_back(lineNum);
+        }
+    };
+
+    for (size_t n = 0; n < starts.size();) {
+        //Fused instructions take the line of the op that can raise a runtime error. Both halves of
+        //GetGlobalAddConstant can, so it keeps the GetGlobal's line, where an undefined variable is reported.
+        if (op(n) == Op::Code::GetGlobal && op(n + 1) == Op::Code::Constant && op(n + 2) == Op::Code::Add) {
+            emit({Op::Code::GetGlobalAddConstant, operand(n), operand(n + 1)}, line(n));
+            n += 3;
+        }
+        else if (op(n) == Op::Code::Constant && withConstantOperand(op(n + 1)) != Op::Code::SIZE) {
+            emit({withConstantOperand(op(n + 1)), operand(n)}, line(n + 1));
+            n += 2;
+        }
+        else if ((op(n) == Op::Code::Equal || op(n) == Op::Code::NotEqual) && op(n + 1) == Op::Code::Not) {
+            emit({op(n) == Op::Code::Equal ? Op::Code::NotEqual : Op::Code::Equal}, line(n));
+            n += 2;
+        }
+        else if (isPureLoad(op(n)) && op(n + 1) == Op::Code::Pop) {
+            n += 2;
+        }
+        else {
+            const size_t end = n + 1 < starts.size() ? starts[n + 1] : batch.opcodes.size();
+            opcodes.insert(opcodes.end(), batch.opcodes.begin() + (long)starts[n], batch.opcodes.begin() + (long)end);
+            lines.insert(lines.end(), batch.lines.begin() + (long)starts[n], batch.lines.begin() + (long)end);
+            n += 1;
+        }
+    }
+
+    batch.opcodes = std::move(opcodes);
+    batch.lines = std::move(lines);
+}
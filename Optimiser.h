@@ -0,0 +1,40 @@
+#ifndef TITANPLUSPLUS_OPTIMISER_H
+#define TITANPLUSPLUS_OPTIMISER_H
+
+/**
+ * @file Optimiser.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains the Optimiser class, a peephole pass over compiled batches.
+ */
+
+#include "Batch.h"
+
+/**
+ * Runs after the compiler has emitted a whole batch and rewrites short
+ * instruction sequences into fewer, equivalent instructions, so the VM
+ * dispatches fewer times per statement:
+ *
+ * | Sequence                   | Rewritten to                                   |
+ * |----------------------------|------------------------------------------------|
+ * | GetGlobal, Constant, Add   | GetGlobalAddConstant                           |
+ * | Constant, Add/Subtract/... | AddConstant/SubtractConstant/...               |
+ * | Equal, Not                 | NotEqual                                       |
+ * | NotEqual, Not              | Equal                                          |
+ * | Constant/True/False/Null, Pop | (removed)                                   |
+ *
+ * Only the single Op::Code operand forms of instructions are fused. Titan has no
+ * jumps, so instructions can be removed without patching any offsets.
+ *
+ * @class Optimiser
+ * @brief Performs peephole optimisation on compiled batches.
+ */
+struct Optimiser {
+    /**
+     * @brief Rewrites the instructions of a batch in place.
+     * @param batch The batch to optimise, must end in a Return.
+     */
+    static void optimise(Batch& batch);
+};
+
+#endif //TITANPLUSPLUS_OPTIMISER_H
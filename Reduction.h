@@ -0,0 +1,29 @@
+#ifndef TITANPLUSPLUS_REDUCTION_H
+#define TITANPLUSPLUS_REDUCTION_H
+
+/**
+ * @file Reduction.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief The reductions both the CPU and CUDA backends can run over an array.
+ */
+
+#include <cstdint>
+
+/**
+ * Each reduction maps every entry (or pair of entries, for Dot and Unequal) to a value,
+ * then combines the values into one. Run by MatrixBackend::reduce().
+ *
+ * @brief A reduction of an array to a single value.
+ */
+enum class Reduction : uint8_t {
+    Sum,         ///< The sum of the entries of a.
+    AbsoluteSum, ///< The sum of the absolute values of the entries of a.
+    SquareSum,   ///< The sum of the squares of the entries of a.
+    Dot,         ///< The sum of the products of the entries of a and b.
+    Min,         ///< The smallest entry of a.
+    Max,         ///< The largest entry of a.
+    Unequal      ///< The number of entries of a and b that differ by more than a relative epsilon.
+};
+
+#endif //TITANPLUSPLUS_REDUCTION_H
@@ -0,0 +1,30 @@
+#ifndef TITANPLUSPLUS_REGISTERBATCH_H
+#define TITANPLUSPLUS_REGISTERBATCH_H
+
+/**
+ * @file RegisterBatch.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief The RegisterBatch class, the register machine form of a code batch.
+ */
+
+#include <vector>
+#include "RegisterOps.h"
+#include "Value.h"
+
+/**
+ * Generated from a compiled Batch by RegisterGenerator, and run alongside it by
+ * VM::interpret(Batch&, RegisterBatch&). Line numbers aren't stored again: each
+ * instruction records the stack instruction it came from, whose line is in the Batch.
+ *
+ * @class RegisterBatch
+ * @brief Holds the register instructions and constant pool for a code batch.
+ */
+struct RegisterBatch {
+    std::vector<RegisterOp::Instruction> instructions; ///< The register instructions of the batch.
+    std::vector<Value> constantPool;                   ///< The batch's constants, followed by null, true and false.
+    std::vector<size_t> origins;                       ///< For each instruction, the index in the Batch of the stack instruction it was generated from.
+    size_t registers = 0;                              ///< The number of registers in the frame.
+};
+
+#endif //TITANPLUSPLUS_REGISTERBATCH_H
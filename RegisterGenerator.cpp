@@ -0,0 +1,269 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#include <algorithm>
+#include "Builtins.h"
+#include "Memory.h"
+#include "RegisterGenerator.h"
+
+namespace {
+/**
+ * @brief Returns the register op of a stack op that combines two operands, or RegisterOp::Code::SIZE if it doesn't.
+ */
+RegisterOp::Code binaryOp(Op::Code op) {
+    switch (op) {
+        case Op::Code::Add:
+        case Op::Code::AddConstant:      return RegisterOp::Code::Add;
+        case Op::Code::Divide:
+        case Op::Code::DivideConstant:   return RegisterOp::Code::Divide;
+        case Op::Code::Equal:            return RegisterOp::Code::Equal;
+        case Op::Code::Greater:          return RegisterOp::Code::Greater;
+        case Op::Code::GreaterEqual:     return RegisterOp::Code::GreaterEqual;
+        case Op::Code::Less:             return RegisterOp::Code::Less;
+        case Op::Code::LessEqual:        return RegisterOp::Code::LessEqual;
+        case Op::Code::Multiply:
+        case Op::Code::MultiplyConstant: return RegisterOp::Code::Multiply;
+        case Op::Code::NotEqual:         return RegisterOp::Code::NotEqual;
+        case Op::Code::Subtract:
+        case Op::Code::SubtractConstant: return RegisterOp::Code::Subtract;
+        default:                         return RegisterOp::Code::SIZE;
+    }
+}
+
+/**
+ * @brief Follows the stack of a batch, emitting the register instructions for each stack instruction.
+ */
+class Generator {
+public:
+    Generator(const Batch& batch, RegisterBatch& registers) : batch(batch), registers(registers) {}
+
+    bool generate() {
+        registers.constantPool = batch.constantPool;
+        const size_t null = addConstant(Value::fromNull());
+        const size_t isTrue = addConstant(Value::fromBool(true));
+        const size_t isFalse = addConstant(Value::fromBool(false));
+
+        for (size_t index = 0; index < batch.opcodes.size(); index += Op::instructionLength(batch.opcodes[index])) {
+            origin = index;
+            const Op::Code op = batch.opcodes[index];
+            auto operand = [&](size_t n) -> uint16_t { return batch.opcodes[index + n]; };
+            auto wideOperand = [&](size_t n) { return Memory::toValue<size_t>(batch.opcodes[index + n], batch.opcodes[index + n + 1]); };
+
+            switch (op) {
+                case Op::Code::AddConstant:
+                case Op::Code::DivideConstant:
+                case Op::Code::MultiplyConstant:
+                case Op::Code::SubtractConstant: {
+                    const uint16_t rhs = constant(operand(1));
+                    const uint16_t lhs = pop();
+                    binary(binaryOp(op), lhs, rhs);
+                    break;
+                }
+                case Op::Code::CallBuiltin: {
+                    const size_t base = entries.size() - Builtins::arity((Builtins::Function)operand(1));
+                    call(RegisterOp::Code::CallBuiltin, base, operand(1));
+                    break;
+                }
+                case Op::Code::Constant:    push(constant(operand(1)));   break;
+                case Op::Code::Constant32:  push(constant(wideOperand(1))); break;
+                case Op::Code::False:       push(constant(isFalse));      break;
+                case Op::Code::Null:        push(constant(null));         break;
+                case Op::Code::True:        push(constant(isTrue));       break;
+                case Op::Code::DefineGlobal: {
+                    emit(RegisterOp::Code::DefineGlobal, pop(), operand(1));
+                    break;
+                }
+                case Op::Code::DefineGlobal32:
+                    emit(RegisterOp::Code::DefineGlobal32, pop(), operand(1), operand(2));
+                    break;
+                case Op::Code::GetGlobal:
+                case Op::Code::GetGlobal32:
+                case Op::Code::GetGlobalAddConstant: {
+                    const uint16_t target = top();
+                    if (op == Op::Code::GetGlobal32) emit(RegisterOp::Code::GetGlobal32, target, operand(1), operand(2));
+                    else emit(RegisterOp::Code::GetGlobal, target, operand(1));
+                    push(target);
+                    if (op == Op::Code::GetGlobalAddConstant) {
+                        const uint16_t rhs = constant(operand(2));
+                        binary(RegisterOp::Code::Add, pop(), rhs);
+                    }
+                    break;
+                }
+                case Op::Code::GetIndex: {
+                    call(RegisterOp::Code::GetIndex, entries.size() - Op::subscriptLength(operand(1)) - 1, operand(1));
+                    break;
+                }
+                case Op::Code::GetLocal:
+                    //The local's value is used from wherever it is held, without copying it.
+                    push(entries[operand(1)]);
+                    break;
+                case Op::Code::Negate:
+                case Op::Code::Not: {
+                    const uint16_t value = pop();
+                    emit(op == Op::Code::Negate ? RegisterOp::Code::Negate : RegisterOp::Code::Not, top(), value);
+                    push(top());
+                    break;
+                }
+                case Op::Code::Pop:
+                    pop();
+                    break;
+                case Op::Code::Print:
+                    emit(RegisterOp::Code::Print, pop());
+                    break;
+                case Op::Code::Return:
+                    emit(RegisterOp::Code::Return);
+                    break;
+                case Op::Code::SetGlobal:
+                    emit(RegisterOp::Code::SetGlobal, entries.back(), operand(1));
+                    break;
+                case Op::Code::SetGlobal32:
+                    emit(RegisterOp::Code::SetGlobal32, entries.back(), operand(1), operand(2));
+                    break;
+                case Op::Code::SetGlobalIndex: {
+                    const size_t base = entries.size() - Op::subscriptLength(operand(2)) - 2;
+                    call(RegisterOp::Code::SetGlobalIndex, base, operand(2), operand(1));
+                    break;
+                }
+                case Op::Code::SetGlobalIndex32: {
+                    const size_t base = entries.size() - Op::subscriptLength(operand(3)) - 2;
+                    call(RegisterOp::Code::SetGlobalIndex32, base, operand(3));
+                    emit(RegisterOp::Code::SetGlobalIndex32, 0, operand(1), operand(2));
+                    break;
+                }
+                case Op::Code::SetLocal: {
+                    const uint16_t slot = operand(1);
+                    detach(slot);
+                    if (entries.back() != slot) emit(RegisterOp::Code::Move, slot, entries.back());
+                    entries[slot] = slot;
+                    break;
+                }
+                case Op::Code::SetLocalIndex: {
+                    //The local's matrix is written in place, so it needs a register of its own.
+                    const uint16_t slot = operand(1);
+                    materialise(slot);
+                    detach(slot);
+                    call(RegisterOp::Code::SetLocalIndex, entries.size() - Op::subscriptLength(operand(2)) - 2, operand(2), slot);
+                    break;
+                }
+                default: {
+                    const uint16_t rhs = pop();
+                    const uint16_t lhs = pop();
+                    binary(binaryOp(op), lhs, rhs);
+                    break;
+                }
+            }
+        }
+        return !overflow;
+    }
+
+private:
+    const Batch& batch;          ///< The batch being translated.
+    RegisterBatch& registers;    ///< The register batch being generated.
+    std::vector<uint16_t> entries; ///< The RK operand holding the value of each stack slot, the slot's own register once it is materialised.
+    size_t origin = 0;           ///< The index of the stack instruction being translated.
+    bool overflow = false;       ///< Set if the frame needs more registers than an operand can address.
+
+    /**
+     * @brief Appends a constant to the register batch's pool and returns its index.
+     */
+    size_t addConstant(const Value& value) {
+        registers.constantPool.push_back(value);
+        return registers.constantPool.size() - 1;
+    }
+
+    /**
+     * @brief Appends an instruction generated from the current stack instruction.
+     */
+    void emit(RegisterOp::Code op, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0) {
+        registers.instructions.push_back({op, a, b, c});
+        registers.origins.push_back(origin);
+    }
+
+    /**
+     * @brief Returns the register of the first free stack slot.
+     */
+    uint16_t top() {
+        use(entries.size() + 1);
+        return (uint16_t)entries.size();
+    }
+
+    /**
+     * @brief Grows the frame to hold the given number of registers.
+     */
+    void use(size_t count) {
+        registers.registers = std::max(registers.registers, count);
+        if (count > RegisterOp::MaxRegisters) overflow = true;
+    }
+
+    void push(uint16_t operand) {
+        entries.push_back(operand);
+        use(entries.size());
+    }
+
+    uint16_t pop() {
+        const uint16_t operand = entries.back();
+        entries.pop_back();
+        return operand;
+    }
+
+    /**
+     * Constants past the reach of an RK operand are loaded into the first free register.
+     *
+     * @brief Returns an RK operand for the constant at the given index.
+     */
+    uint16_t constant(size_t index) {
+        if (index < RegisterOp::ConstantBit) return (uint16_t)(RegisterOp::ConstantBit | index);
+        const uint16_t scratch = top();
+        const std::vector<Op::Code> halves = Memory::toOpCodes((uint32_t)index);
+        emit(RegisterOp::Code::LoadConstant32, scratch, halves[0], halves[1]);
+        return scratch;
+    }
+
+    /**
+     * @brief Emits an instruction combining two operands into the register of the first free stack slot, and pushes it.
+     */
+    void binary(RegisterOp::Code op, uint16_t lhs, uint16_t rhs) {
+        const uint16_t target = top();
+        emit(op, target, lhs, rhs);
+        push(target);
+    }
+
+    /**
+     * @brief Copies the value of a stack slot into the slot's own register, if it isn't already there.
+     */
+    void materialise(size_t slot) {
+        if (entries[slot] == slot) return;
+        emit(RegisterOp::Code::Move, (uint16_t)slot, entries[slot]);
+        entries[slot] = (uint16_t)slot;
+    }
+
+    /**
+     * @brief Materialises every other stack slot whose value is held in a local's register, before the local is written.
+     */
+    void detach(uint16_t local) {
+        for (size_t slot = 0; slot < entries.size(); ++slot) {
+            if (slot != local && entries[slot] == local) materialise(slot);
+        }
+    }
+
+    /**
+     * Used by instructions that read their operands from consecutive registers, and leave
+     * their result in the first of them.
+     *
+     * @brief Materialises the stack slots from base up, emits the instruction and replaces the slots with its result.
+     */
+    void call(RegisterOp::Code op, size_t base, uint16_t b, uint16_t c = 0) {
+        for (size_t slot = base; slot < entries.size(); ++slot) {
+            materialise(slot);
+        }
+        emit(op, (uint16_t)base, b, c);
+        entries.resize(base + 1);
+    }
+};
+}
+
+bool RegisterGenerator::generate(const Batch &batch, RegisterBatch &registers) {
+    Generator generator(batch, registers);
+    return generator.generate();
+}
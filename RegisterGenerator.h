@@ -0,0 +1,40 @@
+#ifndef TITANPLUSPLUS_REGISTERGENERATOR_H
+#define TITANPLUSPLUS_REGISTERGENERATOR_H
+
+/**
+ * @file RegisterGenerator.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains the RegisterGenerator class, which translates compiled batches into register instructions.
+ */
+
+#include "Batch.h"
+#include "RegisterBatch.h"
+
+/**
+ * The compiler's front end is shared by both machines: a script is compiled and optimised
+ * into a Batch as usual, then each stack slot becomes the register of the same index.
+ * Titan has no jumps, so the depth of the stack before every instruction is known and
+ * the generator can follow it in a single pass.
+ *
+ * Loads don't emit any instructions. Constants, true, false, null and local variables
+ * are remembered as the operand that holds them, and used directly by the instruction
+ * that consumes them, so `a + b * c` with local variables is a Multiply and an Add
+ * rather than six stack instructions. Values are only copied into their stack slot's
+ * register when an instruction reads a range of registers, or when the local they
+ * were read from is about to be assigned.
+ *
+ * @class RegisterGenerator
+ * @brief Generates register instructions from compiled batches.
+ */
+struct RegisterGenerator {
+    /**
+     * @brief Generates the register form of a batch.
+     * @param batch The compiled batch, which must end in a Return.
+     * @param registers The register batch to generate, which must be empty.
+     * @return True if the batch was translated, or false if it needs more than RegisterOp::MaxRegisters registers.
+     */
+    static bool generate(const Batch& batch, RegisterBatch& registers);
+};
+
+#endif //TITANPLUSPLUS_REGISTERGENERATOR_H
@@ -0,0 +1,42 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#include "RegisterOps.h"
+
+int RegisterOp::instructionLength(RegisterOp::Code op) {
+    return op == SetGlobalIndex32 ? 2 : 1;
+}
+
+std::string RegisterOp::instructionName(RegisterOp::Code op) {
+    switch (op) {
+        case Add:             return "REG_ADD";
+        case CallBuiltin:     return "REG_CALL_BUILTIN";
+        case DefineGlobal32:  return "REG_DEFINE_GLOBAL_32";
+        case DefineGlobal:    return "REG_DEFINE_GLOBAL";
+        case Divide:          return "REG_DIVIDE";
+        case Equal:           return "REG_EQUAL";
+        case GetGlobal32:     return "REG_GET_GLOBAL_32";
+        case GetGlobal:       return "REG_GET_GLOBAL";
+        case GetIndex:        return "REG_GET_INDEX";
+        case Greater:         return "REG_GREATER";
+        case GreaterEqual:    return "REG_GREATER_EQUAL";
+        case Less:            return "REG_LESS";
+        case LessEqual:       return "REG_LESS_EQUAL";
+        case LoadConstant32:  return "REG_LOAD_CONSTANT_32";
+        case Move:            return "REG_MOVE";
+        case Multiply:        return "REG_MULTIPLY";
+        case Negate:          return "REG_NEGATE";
+        case Not:             return "REG_NOT";
+        case NotEqual:        return "REG_NOT_EQUAL";
+        case Print:           return "REG_PRINT";
+        case Return:          return "REG_RETURN";
+        case SetGlobal32:     return "REG_SET_GLOBAL_32";
+        case SetGlobal:       return "REG_SET_GLOBAL";
+        case SetGlobalIndex32: return "REG_SET_GLOBAL_INDEX_32";
+        case SetGlobalIndex:  return "REG_SET_GLOBAL_INDEX";
+        case SetLocalIndex:   return "REG_SET_LOCAL_INDEX";
+        case Subtract:        return "REG_SUBTRACT";
+        default:              return "Unknown Op: " + std::to_string(op);
+    }
+}
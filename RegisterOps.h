@@ -0,0 +1,92 @@
+#ifndef TITANPLUSPLUS_REGISTEROPS_H
+#define TITANPLUSPLUS_REGISTEROPS_H
+
+/**
+ * @file RegisterOps.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Definitions of the register machine's instructions.
+ */
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Register instructions are three-address: each names its destination and source
+ * registers directly, rather than implicitly popping and pushing the value stack.
+ * Registers are indexed relative to the frame, so R[0] is the first value of the frame.
+ *
+ * Source operands written RK(x) are either a register or, if their ConstantBit is set,
+ * an index into the constant pool, so a constant never needs to be loaded into a
+ * register before it can be used.
+ *
+ * @class RegisterOp
+ * @brief Contains all methods and data relating to register instructions.
+ */
+struct RegisterOp {
+    ///List of all register op codes.
+    enum Code : uint16_t {
+        Add,            ///< R[a] = RK(b) + RK(c).
+        CallBuiltin,    ///< Calls the Builtins::Function b with its arguments in R[a] onwards, putting the result in R[a].
+        DefineGlobal32, ///< DefineGlobal for the 32-bit slot held by b and c.
+        DefineGlobal,   ///< Defines the global in slot b as RK(a), moving it out of R[a]. Globals are only defined outside blocks, where every register is a temporary.
+        Divide,         ///< R[a] = RK(b) / RK(c).
+        Equal,          ///< R[a] = RK(b) == RK(c).
+        GetGlobal32,    ///< R[a] = the global in the 32-bit slot held by b and c.
+        GetGlobal,      ///< R[a] = the global in slot b.
+        GetIndex,       ///< R[a] = the entry or block of R[a] selected by the subscript in R[a + 1] onwards. b holds Op::Subscript flags.
+        Greater,        ///< R[a] = RK(b) > RK(c).
+        GreaterEqual,   ///< R[a] = RK(b) >= RK(c).
+        Less,           ///< R[a] = RK(b) < RK(c).
+        LessEqual,      ///< R[a] = RK(b) <= RK(c).
+        LoadConstant32, ///< R[a] = the constant at the 32-bit index held by b and c, for constants past the reach of RK operands.
+        Move,           ///< R[a] = RK(b).
+        Multiply,       ///< R[a] = RK(b) * RK(c).
+        Negate,         ///< R[a] = -RK(b).
+        Not,            ///< R[a] = !RK(b).
+        NotEqual,       ///< R[a] = RK(b) != RK(c).
+        Print,          ///< Prints RK(a).
+        Return,         ///< Exit from VM processing cycle.
+        SetGlobal32,    ///< Assigns RK(a) to the global in the 32-bit slot held by b and c.
+        SetGlobal,      ///< Assigns RK(a) to the global in slot b.
+        SetGlobalIndex32, ///< SetGlobalIndex whose 32-bit slot is held by b and c of the following instruction.
+        SetGlobalIndex, ///< Assigns the value after the subscript in R[a + 1] onwards to the global matrix in slot c. b holds Op::Subscript flags, and the value is left in R[a].
+        SetLocalIndex,  ///< SetGlobalIndex for the local matrix in R[c].
+        Subtract,       ///< R[a] = RK(b) - RK(c).
+
+        //Number of op codes (Must be last)
+        SIZE,
+    };
+
+    static const uint16_t ConstantBit = 0x8000;   ///< Set in an RK operand that indexes the constant pool.
+    static const size_t MaxRegisters = ConstantBit; ///< Registers must be addressable by an RK operand.
+
+    /**
+     * @brief A single register instruction and its operands. Unused operands are 0.
+     */
+    struct Instruction {
+        Code op;    ///< The instruction to execute.
+        uint16_t a; ///< The first operand, usually the destination register.
+        uint16_t b; ///< The second operand.
+        uint16_t c; ///< The third operand.
+    };
+
+    /**
+     * @brief Returns true if an RK operand indexes the constant pool rather than a register.
+     */
+    static constexpr bool isConstant(uint16_t operand) {
+        return operand & ConstantBit;
+    }
+
+    /**
+     * @brief Returns the number of Instructions the provided op takes up, including any that only hold operands.
+     */
+    static int instructionLength(Code op);
+
+    /**
+     * @brief Returns the name of the provided register op as a human-readable string.
+     */
+    static std::string instructionName(Code op);
+};
+
+#endif //TITANPLUSPLUS_REGISTEROPS_H
@@ -0,0 +1,219 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include "ScanSimd.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TITAN_SCAN_SSE2
+#include <immintrin.h>
+#endif
+
+//AVX2 functions are compiled for AVX2 with a target attribute and only called after a runtime CPU check.
+#if defined(TITAN_SCAN_SSE2) && defined(__GNUC__)
+#define TITAN_SCAN_AVX2
+#define TITAN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+///The kinds of run that can be skipped.
+enum class Run {
+    Whitespace, ///< Spaces, tabs, '\r' and '\n'.
+    Identifier, ///< Letters, digits and underscores.
+    Digits,     ///< '0' to '9'.
+    Find        ///< Anything except the target character.
+};
+
+ScanSimd::Level activeLevel = ScanSimd::Level::Scalar; ///< The level every scan uses.
+bool levelSelected = false;                            ///< True once activeLevel has been chosen.
+
+/**
+ * @brief Returns true if c continues a run of the given kind.
+ */
+template <Run run>
+inline bool continues(char c, char target) {
+    if constexpr (run == Run::Whitespace) return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    if constexpr (run == Run::Identifier) return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    if constexpr (run == Run::Digits) return c >= '0' && c <= '9';
+    if constexpr (run == Run::Find) return c != target;
+}
+
+/**
+ * @brief Returns true if runs of the given kind can contain '\n', so lines need counting.
+ */
+constexpr bool countsLines(Run run) {
+    return run == Run::Whitespace || run == Run::Find;
+}
+
+template <Run run>
+size_t scanScalar(const char* data, size_t size, size_t index, char target, int& lines) {
+    for (; index < size && continues<run>(data[index], target); ++index) {
+        if (countsLines(run) && data[index] == '\n') ++lines;
+    }
+    return index;
+}
+
+#ifdef TITAN_SCAN_SSE2
+/**
+ * @brief Sets each byte of the result to 0xFF where lo <= c <= hi. Only valid for ASCII bounds.
+ */
+inline __m128i inRangeSse2(__m128i c, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8((char)(lo - 1))), _mm_cmplt_epi8(c, _mm_set1_epi8((char)(hi + 1))));
+}
+
+/**
+ * @brief Sets each byte of the result to 0xFF where the character continues a run of the given kind.
+ */
+template <Run run>
+inline __m128i continuesSse2(__m128i c, char target) {
+    if constexpr (run == Run::Whitespace) {
+        return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\t'))),
+                            _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\n'))));
+    }
+    if constexpr (run == Run::Identifier) {
+        //Setting bit 5 folds upper case onto lower case, digits and '_' are unaffected by the fold test.
+        const __m128i letter = inRangeSse2(_mm_or_si128(c, _mm_set1_epi8(0x20)), 'a', 'z');
+        return _mm_or_si128(_mm_or_si128(letter, inRangeSse2(c, '0', '9')), _mm_cmpeq_epi8(c, _mm_set1_epi8('_')));
+    }
+    if constexpr (run == Run::Digits) return inRangeSse2(c, '0', '9');
+    if constexpr (run == Run::Find) return _mm_xor_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(target)), _mm_set1_epi8(-1));
+}
+
+template <Run run>
+size_t scanSse2(const char* data, size_t size, size_t index, char target, int& lines) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (size - index >= 16) {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+        const uint32_t stop = ~(uint32_t)_mm_movemask_epi8(continuesSse2<run>(c, target)) & 0xFFFFu;
+        const uint32_t newlines = countsLines(run) ? (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, newline)) : 0;
+        if (stop != 0) {
+            const int offset = std::countr_zero(stop);
+            lines += std::popcount(newlines & ((1u << offset) - 1));
+            return index + offset;
+        }
+        lines += std::popcount(newlines);
+        index += 16;
+    }
+    return scanScalar<run>(data, size, index, target, lines);
+}
+#endif //TITAN_SCAN_SSE2
+
+#ifdef TITAN_SCAN_AVX2
+/**
+ * @brief Sets each byte of the result to 0xFF where lo <= c <= hi. Only valid for ASCII bounds.
+ */
+TITAN_TARGET_AVX2 inline __m256i inRangeAvx2(__m256i c, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8((char)(lo - 1))), _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(hi + 1)), c));
+}
+
+/**
+ * @brief Sets each byte of the result to 0xFF where the character continues a run of the given kind.
+ */
+template <Run run>
+TITAN_TARGET_AVX2 inline __m256i continuesAvx2(__m256i c, char target) {
+    if constexpr (run == Run::Whitespace) {
+        return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\t'))),
+                               _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n'))));
+    }
+    if constexpr (run == Run::Identifier) {
+        const __m256i letter = inRangeAvx2(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), 'a', 'z');
+        return _mm256_or_si256(_mm256_or_si256(letter, inRangeAvx2(c, '0', '9')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')));
+    }
+    if constexpr (run == Run::Digits) return inRangeAvx2(c, '0', '9');
+    if constexpr (run == Run::Find) return _mm256_xor_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(target)), _mm256_set1_epi8(-1));
+}
+
+template <Run run>
+TITAN_TARGET_AVX2 size_t scanAvx2(const char* data, size_t size, size_t index, char target, int& lines) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    while (size - index >= 32) {
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+        const uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(continuesAvx2<run>(c, target));
+        const uint32_t newlines = countsLines(run) ? (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, newline)) : 0;
+        if (stop != 0) {
+            const int offset = std::countr_zero(stop);
+            lines += std::popcount(newlines & (uint32_t)((1ull << offset) - 1));
+            return index + offset;
+        }
+        lines += std::popcount(newlines);
+        index += 32;
+    }
+    //Finish with SSE2, which every AVX2 CPU has, before falling back to scalar code.
+    return scanSse2<run>(data, size, index, target, lines);
+}
+#endif //TITAN_SCAN_AVX2
+
+/**
+ * @brief Skips a run of the given kind at the active level.
+ */
+template <Run run>
+size_t scan(std::string_view source, size_t index, char target, int& lines) {
+    if (index >= source.size()) return index;
+    switch (ScanSimd::level()) {
+#ifdef TITAN_SCAN_AVX2
+        case ScanSimd::Level::AVX2: return scanAvx2<run>(source.data(), source.size(), index, target, lines);
+#endif
+#ifdef TITAN_SCAN_SSE2
+        case ScanSimd::Level::SSE2: return scanSse2<run>(source.data(), source.size(), index, target, lines);
+#endif
+        default:                    return scanScalar<run>(source.data(), source.size(), index, target, lines);
+    }
+}
+}
+
+bool ScanSimd::supported(ScanSimd::Level level) {
+    switch (level) {
+        case Level::Scalar: return true;
+#ifdef TITAN_SCAN_SSE2
+        case Level::SSE2:   return true;
+#endif
+#ifdef TITAN_SCAN_AVX2
+        case Level::AVX2:   return __builtin_cpu_supports("avx2");
+#endif
+        default:            return false;
+    }
+}
+
+ScanSimd::Level ScanSimd::level() {
+    if (!levelSelected) {
+        activeLevel = supported(Level::AVX2) ? Level::AVX2 : supported(Level::SSE2) ? Level::SSE2 : Level::Scalar;
+
+        const char* requested = std::getenv("TITAN_SCAN_SIMD");
+        if (requested != nullptr) {
+            const std::string name(requested);
+            if (name == "scalar") activeLevel = Level::Scalar;
+            else if (name == "sse2" && supported(Level::SSE2)) activeLevel = Level::SSE2;
+        }
+        levelSelected = true;
+    }
+    return activeLevel;
+}
+
+bool ScanSimd::setLevel(ScanSimd::Level level) {
+    if (!supported(level)) return false;
+    activeLevel = level;
+    levelSelected = true;
+    return true;
+}
+
+size_t ScanSimd::skipWhitespace(std::string_view source, size_t index, int& lines) {
+    return scan<Run::Whitespace>(source, index, '\0', lines);
+}
+
+size_t ScanSimd::skipIdentifier(std::string_view source, size_t index) {
+    int lines = 0;
+    return scan<Run::Identifier>(source, index, '\0', lines);
+}
+
+size_t ScanSimd::skipDigits(std::string_view source, size_t index) {
+    int lines = 0;
+    return scan<Run::Digits>(source, index, '\0', lines);
+}
+
+size_t ScanSimd::find(std::string_view source, size_t index, char target, int& lines) {
+    return scan<Run::Find>(source, index, target, lines);
+}
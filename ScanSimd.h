@@ -0,0 +1,82 @@
+#ifndef TITANPLUSPLUS_SCANSIMD_H
+#define TITANPLUSPLUS_SCANSIMD_H
+
+/**
+ * @file ScanSimd.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains vectorised character scanning for the Scanner.
+ */
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * The Scanner spends most of its time stepping over runs of characters of a single
+ * class: whitespace, identifier characters, digits, and the bodies of comments, strings
+ * and matrix literals. These functions skip such runs 16 (SSE2) or 32 (AVX2) bytes at a
+ * time, classifying a whole block with a few compares and finding the end of the run
+ * with a bit scan. The remaining tail of the source is scanned one character at a time.
+ *
+ * The level is chosen on first use: AVX2 if the CPU supports it, otherwise SSE2 on x86-64,
+ * otherwise scalar. The TITAN_SCAN_SIMD environment variable ("scalar", "sse2" or "avx2")
+ * or setLevel() can lower it, e.g. for benchmarking.
+ */
+namespace ScanSimd {
+///Instruction sets runs can be scanned with.
+enum class Level {
+    Scalar, ///< One character at a time.
+    SSE2,   ///< 16 bytes at a time.
+    AVX2    ///< 32 bytes at a time.
+};
+
+/**
+ * @brief Returns true if this build and CPU can scan at the given level.
+ */
+bool supported(Level level);
+
+/**
+ * @brief Returns the active level, choosing one if none has been selected yet.
+ */
+Level level();
+
+/**
+ * @brief Selects the level used by every scan.
+ * @param level The level to use.
+ * @return False if the level isn't supported, in which case the active level is unchanged.
+ */
+bool setLevel(Level level);
+
+/**
+ * @brief Returns the index of the first character at or after index that isn't a space, tab, '\r' or '\n'.
+ * @param source The source being scanned.
+ * @param index The index to start scanning from.
+ * @param lines Incremented by the number of '\n' characters skipped.
+ */
+size_t skipWhitespace(std::string_view source, size_t index, int& lines);
+
+/**
+ * @brief Returns the index of the first character at or after index that isn't a letter, digit or underscore.
+ * @param source The source being scanned.
+ * @param index The index to start scanning from.
+ */
+size_t skipIdentifier(std::string_view source, size_t index);
+
+/**
+ * @brief Returns the index of the first character at or after index that isn't a digit.
+ * @param source The source being scanned.
+ * @param index The index to start scanning from.
+ */
+size_t skipDigits(std::string_view source, size_t index);
+
+/**
+ * @brief Returns the index of the first occurrence of target at or after index, or the size of the source if there isn't one.
+ * @param source The source being scanned.
+ * @param index The index to start scanning from.
+ * @param target The character to find.
+ * @param lines Incremented by the number of '\n' characters skipped.
+ */
+size_t find(std::string_view source, size_t index, char target, int& lines);
+}
+
+#endif //TITANPLUSPLUS_SCANSIMD_H
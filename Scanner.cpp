@@ -4,8 +4,9 @@
 
 #include <iostream>
 #include "Scanner.h"
+#include "ScanSimd.h"
 
-void Scanner::parse(const std::string &titanSource) {
+void Scanner::parse(std::string_view titanSource) {
     titanSourceCode = titanSource;
     start = 0;
     current = 0;
@@ -20,13 +21,13 @@ void Scanner::parse(const std::string &titanSource) {
             printf("   | ");
         }
         std::cout << "Size: " << current - start << "\n";
-        std::cout << titanSourceCode.substr(token.start, token.length) << "\n";
+        std::cout << token.text(titanSourceCode) << "\n";
 
         if (token.type == Token::Type::END_OF_FILE) break;
     }
 }
 
-void Scanner::init(const std::string &titanSource) {
+void Scanner::init(std::string_view titanSource) {
     titanSourceCode = titanSource;
     start = 0;
     current = 0;
@@ -57,6 +58,9 @@ Token Scanner::scanToken() {
         case ')': return Token(Token::Type::RIGHT_PAREN, start, current - start, line);
         case '{': return Token(Token::Type::LEFT_BRACE, start, current - start, line);
         case '}': return Token(Token::Type::RIGHT_BRACE, start, current - start, line);
+        case '[': return Token(Token::Type::LEFT_BRACKET, start, current - start, line);
+        case ']': return Token(Token::Type::RIGHT_BRACKET, start, current - start, line);
+        case ':': return Token(Token::Type::COLON, start, current - start, line);
         case ';': return Token(Token::Type::SEMICOLON, start, current - start, line);
         case ',': return Token(Token::Type::COMMA, start, current - start, line);
         case '.': return Token(Token::Type::DOT, start, current - start, line);
@@ -92,6 +96,18 @@ bool Scanner::isDigit(char c) {
     return c >= '0' && c <= '9';
 }
 
+void Scanner::skipDigits() {
+    //Short runs of digits are stepped over, long ones are finished with a vector scan.
+    const size_t end = current + ShortRun;
+    while (isDigit(peek())) {
+        if (current == end) {
+            current = ScanSimd::skipDigits(titanSourceCode, current);
+            break;
+        }
+        advanceIndex();
+    }
+}
+
 bool Scanner::isMatrixPrefix(char c) const {
     return c == '[' && peek() == '[';
 }
@@ -101,7 +117,9 @@ char Scanner::advanceIndex() {
 }
 
 char Scanner::peek(int offset) const {
-    return titanSourceCode[current + offset];
+    //A view has no terminating '\0' to stop lookahead at the end of the source.
+    const size_t index = current + offset;
+    return index < titanSourceCode.size() ? titanSourceCode[index] : '\0';
 }
 
 void Scanner::skipWhitespace() {
@@ -115,14 +133,13 @@ void Scanner::skipWhitespace() {
             case '\n':
                 line++;
                 current++;
+                //Gaps between tokens are usually one character, but indentation and blank lines are worth a vector scan.
+                current = ScanSimd::skipWhitespace(titanSourceCode, current, line);
                 break;
             case '/': {
-                if (current + 1 < titanSourceCode.size() && titanSourceCode[current + 1] == '/') {
-                    while (current < titanSourceCode.size() && titanSourceCode[current] != '\n') current++;
-                }
-                else {
-                    return;
-                }
+                if (peek(1) != '/') return;
+                //Comment bodies run to the end of the line.
+                current = ScanSimd::find(titanSourceCode, current, '\n', line);
                 break;
             }
             default: return;
@@ -167,20 +184,16 @@ Token::Type Scanner::getIdentifierType() {
     return Token::IDENTIFIER;
 }
 
-Token::Type Scanner::checkKeyword(int startIndex, const std::string &name, Token::Type type) {
-    if (titanSourceCode.substr(start + startIndex, name.size()) == name) {
+Token::Type Scanner::checkKeyword(int startIndex, std::string_view name, Token::Type type) {
+    //The whole identifier must be the keyword, so that e.g. 'andy' isn't scanned as 'and'.
+    if (current - start == startIndex + name.size() && titanSourceCode.compare(start + startIndex, name.size(), name) == 0) {
         return type;
     }
     return Token::Type::IDENTIFIER;
 }
 
 Token Scanner::parseString() {
-    while (current < titanSourceCode.size() && titanSourceCode[current] != '"') {
-        if (titanSourceCode[current] == '\n') {
-            line++;
-        }
-        current++;
-    }
+    current = ScanSimd::find(titanSourceCode, current, '"', line);
 
     if (current >= titanSourceCode.size()) {
         return Token(Token::Type::END_OF_FILE, start, current - start, line);
@@ -191,23 +204,39 @@ Token Scanner::parseString() {
 }
 
 Token Scanner::parseNumber() {
-    while (isDigit(peek())) advanceIndex();
+    skipDigits();
 
     if (peek() == '.' && isDigit(peek(1))) {
         advanceIndex();
 
-        while (isDigit(peek())) advanceIndex();
+        skipDigits();
     }
     return Token(Token::Type::NUMBER, start, current - start, line);
 }
 
 Token Scanner::parseIdentifer() {
-    while (isAlphaCharacter(peek()) || isDigit(peek())) advanceIndex();
+    //Short identifiers are stepped over, long ones are finished with a vector scan.
+    const size_t end = current + ShortRun;
+    while (isAlphaCharacter(peek()) || isDigit(peek())) {
+        if (current == end) {
+            current = ScanSimd::skipIdentifier(titanSourceCode, current);
+            break;
+        }
+        advanceIndex();
+    }
     return Token(getIdentifierType(), start, current - start, line);
 }
 
 Token Scanner::parseMatrix() {
-    while (peek() != ']' || peek(1) != ']') advanceIndex();
+    //Skip from one ']' to the next until two are adjacent.
+    for (;;) {
+        current = ScanSimd::find(titanSourceCode, current, ']', line);
+        if (current >= titanSourceCode.size()) {
+            return Token(Token::Type::ERROR, start, current - start, line);
+        }
+        if (peek(1) == ']') break;
+        advanceIndex();
+    }
     //Consume the two ']' characters.
     advanceIndex();
     advanceIndex();
@@ -9,12 +9,17 @@
  */
 
 #include <string>
+#include <string_view>
 #include "Token.h"
 
 /**
  * Provides methods for lexically parsing Titan source code into
  * tokens.
  *
+ * The scanner never copies the source. It scans a non-owning view, which may
+ * point into a memory-mapped file, and tokens refer back into it by offset, so
+ * the source must outlive the scanner and every token it produces.
+ *
  * @class Scanner
  * @brief Provides methods for parsing Titan source code.
  */
@@ -26,13 +31,13 @@ public:
      * @brief Parses a string of Titan source code.
      * @param titanSource A string of Titan source code to be parsed.
      */
-    void parse(const std::string& titanSource);
+    void parse(std::string_view titanSource);
 
     /**
-     * @brief Sets the parsing string to a copy of the provided source code.
-     * @param titanSource A source of Titan source code to be parsed.
+     * @brief Sets the parsing string to a view of the provided source code.
+     * @param titanSource A source of Titan source code to be parsed, must outlive the scanner.
      */
-    void init(const std::string& titanSource);
+    void init(std::string_view titanSource);
 
     /**
       *  Returns the next Token created through the process of lexical parsing
@@ -43,11 +48,13 @@ public:
       */
     Token scanToken();
 protected:
-    std::string titanSourceCode;     ///< The current source code being analysed.
+    std::string_view titanSourceCode; ///< The current source code being analysed.
     size_t start = 0;                ///< Index of starting character of the current lexeme.
     size_t current = 0;              ///< Index of the current character being analysed in the current lexeme.
     int line = 0;                    ///< Line number of the current lexeme.
 
+    static const size_t ShortRun = 8; ///< Characters stepped over one at a time before a run is handed to ScanSimd.
+
     /**
      * The function consumes the matched character if a match is detected,
      * otherwise the next character in sequences remains unconsumed.
@@ -74,6 +81,11 @@ protected:
      */
     static inline bool isDigit(char c);
 
+    /**
+     * @brief Advances 'current' past a run of digits.
+     */
+    void skipDigits();
+
     /**
      * Tests whether the given character is a '[' followed by another '['.
      * @param c The character to be tested.
@@ -90,7 +102,7 @@ protected:
     /**
      * @brief Returns the character at the current position plus an offset.
      * @param offset The number of characters to look forward or backwards.
-     * @return The character in the source at position 'current + offset'.
+     * @return The character in the source at position 'current + offset', or '\0' past the end of the source.
      */
     char peek(int offset = 0) const;
 
@@ -117,7 +129,7 @@ protected:
      * @param type The token type to return if the provided keyword is found.
      * @return The token type for the given keyword if found, otherwise returns Token::Type::Identifier.
      */
-    Token::Type checkKeyword(int startIndex, const std::string &name, Token::Type type);
+    Token::Type checkKeyword(int startIndex, std::string_view name, Token::Type type);
 
     /**
      * Parses a string from the current position in the Titan source
@@ -148,7 +160,7 @@ protected:
 
     /**
      * @brief Scan the next token as a matrix.
-     * @return A token representing the matrix.
+     * @return A token representing the matrix, or an error token if the matrix is unterminated.
      */
     Token parseMatrix();
 };
@@ -0,0 +1,19 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+#include "Strings.h"
+
+Value Strings::intern(std::string_view text) {
+    auto found = table.find(text);
+    if (found != table.end()) return found->second;
+
+    Value string = Value::fromString(std::string(text));
+    //The key views the interned Object's own characters, which never move while the table holds it.
+    table.emplace(string.asString(), string);
+    return string;
+}
+
+size_t Strings::size() const {
+    return table.size();
+}
@@ -0,0 +1,48 @@
+#ifndef TITANPLUSPLUS_STRINGS_H
+#define TITANPLUSPLUS_STRINGS_H
+
+/**
+ * @file Strings.h
+ * @author Bryn McKerracher
+ * @date 16/10/2026
+ * @brief Contains the Strings class, the VM's table of interned strings.
+ */
+
+#include <string_view>
+#include <unordered_map>
+#include "Value.h"
+
+/**
+ * Every string constant the compiler emits, or a batch file loads, is interned here,
+ * so equal string constants share a single heap Object no matter how many batches
+ * refer to them. Two interned strings are then equal exactly when their Values have
+ * the same bits, which Value::operator== tests before comparing characters.
+ *
+ * The table holds a reference to each string, so interned strings live as long as
+ * the VM. Strings built at runtime (e.g. by concatenation) are not interned.
+ *
+ * @class Strings
+ * @brief Interns string values by their contents.
+ */
+class Strings {
+public:
+    /**
+     * Returns the interned string with the given contents, creating and
+     * interning a new one if there isn't one already.
+     *
+     * @brief Interns a string.
+     * @param text The contents of the string.
+     * @return A string Value sharing the interned Object.
+     */
+    Value intern(std::string_view text);
+
+    /**
+     * @brief Returns the number of interned strings.
+     */
+    size_t size() const;
+
+private:
+    std::unordered_map<std::string_view, Value> table; ///< Interned strings, keyed by views of their own contents.
+};
+
+#endif //TITANPLUSPLUS_STRINGS_H
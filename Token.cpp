@@ -4,7 +4,7 @@
 
 #include "Token.h"
 
-Token::Token(size_t index, const std::string& titanSource) {
+Token::Token(size_t index, std::string_view titanSource) {
     start = index;
 
     if (index >= titanSource.size()) {
@@ -21,3 +21,7 @@ Token::Token(Token::Type tokenType, size_t index, size_t tokenLength, int tokenL
     length = tokenLength;
     line = tokenLine;
 }
+
+std::string_view Token::text(std::string_view titanSource) const {
+    return titanSource.substr(start, length);
+}
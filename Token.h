@@ -10,6 +10,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 /**
  * An object for holding and accessing information about a single lexeme.
@@ -32,7 +33,8 @@ public:
     enum Type {
         LEFT_PAREN, RIGHT_PAREN,
         LEFT_BRACE, RIGHT_BRACE,
-        COMMA, DOT, MINUS, PLUS,
+        LEFT_BRACKET, RIGHT_BRACKET,
+        COLON, COMMA, DOT, MINUS, PLUS,
         SEMICOLON, SLASH, STAR,
 
         // One or two character tokens.
@@ -70,7 +72,7 @@ public:
      * @param index The index of the Token's starting character in the source code.
      * @param titanSource The string of Titan source code to generate a token from.
      */
-    Token(size_t index, const std::string& titanSource);
+    Token(size_t index, std::string_view titanSource);
 
     /**
      * Creates a token.
@@ -87,6 +89,13 @@ public:
      * @brief Default constructor.
      */
     Token() = default;
+
+    /**
+     * @brief Returns a view of this token's characters in the source it was scanned from.
+     * @param titanSource The source code the token was scanned from.
+     * @return A view of the token's lexeme, valid for as long as the source is.
+     */
+    std::string_view text(std::string_view titanSource) const;
 };
 
 
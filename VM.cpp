@@ -1,256 +1,1082 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
 #include "VM.h"
 
-VM::VM() {
-    stack.reserve(MaxStackSize);
-}
+//Use labels-as-values threaded dispatch where the compiler supports it.
+#if defined(__GNUC__) && !defined(TITAN_SWITCH_DISPATCH)
+#define TITAN_COMPUTED_GOTO
+#endif
 
-VM::InterpretResult VM::interpret(const std::string &titanCode) {
-    Compiler compiler;
+//Print stack values and disassemble each instruction before it runs, only in the traced instantiation of run().
+#define VM_TRACE() do { if constexpr (Traced) traceExecution(batch, top); } while (false)
+
+//Op::Code dispatch, each handler ends by jumping straight to the next instruction's handler.
+#ifdef TITAN_COMPUTED_GOTO
+#define VM_DISPATCH_BEGIN VM_DISPATCH();
+#define VM_CASE(op) op##Label:
+#define VM_DISPATCH() do { VM_TRACE(); goto *dispatchTable[*pc++]; } while (false)
+#define VM_DISPATCH_END
+#else
+#define VM_DISPATCH_BEGIN for (;;) { VM_TRACE(); switch (*pc++) {
+#define VM_CASE(op) case Op::Code::op:
+#define VM_DISPATCH() continue
+#define VM_DISPATCH_END default: break; } }
+#endif //TITAN_COMPUTED_GOTO
+
+//Pops the stack top, releasing its value so the slot holds no Object once it is above the top.
+#define VM_POP() (*--top = Value())
+
+//Pops every value above the given slot, for instructions that leave their result in their first operand's slot.
+#define VM_POP_TO(first) do { Value* const newTop = (first); while (top > newTop) VM_POP(); } while (false)
+
+//Applies a numeric binary operator in place: the result overwrites the left operand's slot, then the right operand is popped.
+//The right operand is a number, so popping it has nothing to release.
+#define VM_BINARY_NUMBER_OP(resultType, op) \
+    do { \
+        Value& rhs = top[-1]; \
+        Value& lhs = top[-2]; \
+        if (!lhs.isNumber() || !rhs.isNumber()) { \
+            runtimeError("Operands must be numbers.", batch); \
+            return InterpretResult::RUNTIME_ERROR; \
+        } \
+        lhs = Value::resultType(lhs.toType<double>() op rhs.toType<double>()); \
+        --top; \
+    } while (false)
+
+//Applies a numeric binary operator in place between the stack top and the constant given by the next Op::Code.
+#define VM_CONSTANT_NUMBER_OP(op) \
+    do { \
+        Value& lhs = top[-1]; \
+        const Value& rhs = batch.constantPool[*pc++]; \
+        if (!lhs.isNumber() || !rhs.isNumber()) { \
+            runtimeError("Operands must be numbers.", batch); \
+            return InterpretResult::RUNTIME_ERROR; \
+        } \
+        lhs = Value::fromNumber(lhs.toType<double>() op rhs.toType<double>()); \
+    } while (false)
+
+//RegisterOp::Instruction dispatch, each handler ends by jumping straight to the next instruction's handler.
+#ifdef TITAN_COMPUTED_GOTO
+#define REGISTER_DISPATCH_BEGIN REGISTER_DISPATCH();
+#define REGISTER_CASE(op) op##Label:
+#define REGISTER_DISPATCH() do { instruction = ip++; goto *dispatchTable[instruction->op]; } while (false)
+#define REGISTER_DISPATCH_END
+#else
+#define REGISTER_DISPATCH_BEGIN for (;;) { instruction = ip++; switch (instruction->op) {
+#define REGISTER_CASE(op) case RegisterOp::Code::op:
+#define REGISTER_DISPATCH() continue
+#define REGISTER_DISPATCH_END default: break; } }
+#endif //TITAN_COMPUTED_GOTO
+
+//The value of an RK operand, a register or a constant.
+#define REGISTER_RK(operand) (RegisterOp::isConstant(operand) ? constants[(operand) & ~RegisterOp::ConstantBit] : frame[operand])
+
+//Points pc at the stack instruction the current register instruction came from, so runtimeError() reports its line.
+#define REGISTER_SYNC() (pc = &batch.opcodes[registers.origins[instruction - &registers.instructions[0]]] + 1)
+
+//Applies a numeric binary operator to RK(b) and RK(c), storing the result in R[a].
+#define REGISTER_BINARY_NUMBER_OP(resultType, op) \
+    do { \
+        const Value& lhs = REGISTER_RK(instruction->b); \
+        const Value& rhs = REGISTER_RK(instruction->c); \
+        if (!lhs.isNumber() || !rhs.isNumber()) { \
+            REGISTER_SYNC(); \
+            runtimeError("Operands must be numbers.", batch); \
+            return InterpretResult::RUNTIME_ERROR; \
+        } \
+        frame[instruction->a] = Value::resultType(lhs.toType<double>() op rhs.toType<double>()); \
+    } while (false)
+
+//Applies an arithmetic operator to RK(b) and RK(c) through one of the VM's helpers when they aren't both numbers.
+#define REGISTER_ARITHMETIC_OP(helper, op) \
+    do { \
+        const Value& lhs = REGISTER_RK(instruction->b); \
+        const Value& rhs = REGISTER_RK(instruction->c); \
+        if (lhs.isNumber() && rhs.isNumber()) { \
+            frame[instruction->a] = Value::fromNumber(lhs.toType<double>() op rhs.toType<double>()); \
+        } \
+        else { \
+            Value result = lhs; \
+            REGISTER_SYNC(); \
+            if (!helper(result, rhs, batch)) { \
+                return InterpretResult::RUNTIME_ERROR; \
+            } \
+            frame[instruction->a] = std::move(result); \
+        } \
+    } while (false)
+
+VM::VM() : stack(std::make_unique<Value[]>(MaxStackSize)) {}
+
+VM::InterpretResult VM::interpret(std::string_view titanCode) {
     Batch batch;
 
-    if (!compiler.compile(titanCode, batch)) {
+    if (!compile(titanCode, batch)) {
         return InterpretResult::COMPILE_ERROR;
     }
 
+    return interpret(batch);
+}
+
+VM::InterpretResult VM::interpret(Batch &batch) {
+    if (!checkStack(batch, batch.maxStackDepth)) {
+        return InterpretResult::RUNTIME_ERROR;
+    }
     //Point PC to first instruction
     pc = &batch.opcodes[0];
-    InterpretResult result = run(batch);
+    InterpretResult result = tracing ? run<true>(batch, stack.get()) : run<false>(batch, stack.get());
+    //Release the values still on the stack, such as locals.
+    releaseStack(batch.maxStackDepth);
 
     return result;
 }
 
-VM::InterpretResult VM::run(Batch &batch) {
-    while (true) {
-        //Print stack values and disassemble instructions if we're in debug mode.
-        #ifdef DEBUG_TRACE_EXECUTION
-            if (!stack.empty()) {
-                std::cout << "\t\t";
-                for (auto &value: stack) {
-                    std::cout << "[" << value.toString() << "]";
-                }
-                std::cout << "\n";
-            }
-            Debug::disassembleInstruction(batch, (size_t) (pc - &batch.opcodes[0]));
-        #endif //DEBUG_TRACE_EXECUTION
-        //Op::Code dispatch
-        switch (*pc++) {
-            case Op::Code::Add: {
-                if (checkBinaryOperandsHaveType(Value::Type::NUMBER)) {
-                    const auto operands = popBinaryOperands();
-                    stack.push_back(Value::fromNumber(operands[1].toType<double>() + operands[0].toType<double>()));
-                }
-                else if (checkBinaryOperandsHaveType(Value::Type::STRING)) {
-                    const auto operands = popBinaryOperands();
-                    stack.push_back(Value::fromString(operands[1].toType<std::string>() + operands[0].toType<std::string>()));
-                }
-                else if (checkBinaryOperandsHaveType(Value::Type::MATRIXF)) {
-                    const auto operands = popBinaryOperands();
-                    stack.push_back(Value::fromMatrixF(operands[1].toType<MatrixF>() + operands[0].toType<MatrixF>()));
-                }
-                else if (checkBinaryOperandsHaveType(Value::Type::MATRIXD)) {
-                    const auto operands = popBinaryOperands();
-                    stack.push_back(Value::fromMatrixD(operands[1].toType<MatrixD>() + operands[0].toType<MatrixD>()));
-                }
-                else {
-                    runtimeError("Operands must be two numbers or two strings.", batch);
-                    return InterpretResult::RUNTIME_ERROR;
-                }
-                break;
+VM::InterpretResult VM::interpret(Batch &batch, RegisterBatch &registers) {
+    if (!checkStack(batch, registers.registers)) {
+        return InterpretResult::RUNTIME_ERROR;
+    }
+    InterpretResult result = run(batch, registers);
+    //Release the values still held in registers.
+    releaseStack(registers.registers);
+
+    return result;
+}
+
+VM::InterpretResult VM::interpret(Batch &batch, NativeBatch &native) {
+    if (!checkStack(batch, batch.maxStackDepth)) {
+        return InterpretResult::RUNTIME_ERROR;
+    }
+    NativeContext context{this, &batch, stack.get(), batch.constantPool.data()};
+    const Value* top = native.entry()(&context, stack.get(), globals.values.data());
+    //Release the values still on the stack, such as locals.
+    releaseStack(batch.maxStackDepth);
+
+    return top != nullptr ? InterpretResult::OK : InterpretResult::RUNTIME_ERROR;
+}
+
+NativeStep VM::nativeStep(Op::Code op) {
+    static const auto steps = []<size_t... ops>(std::index_sequence<ops...>) {
+        return std::array<NativeStep, Op::Code::SIZE>{&VM::nativeStep<(Op::Code)ops>...};
+    }(std::make_index_sequence<Op::Code::SIZE>());
+    return steps[op];
+}
+
+Value* VM::nativeRun(NativeContext *context, Value *top, size_t from, size_t to) {
+    const std::vector<Op::Code>& opcodes = context->batch->opcodes;
+    for (size_t index = from; index < to && top != nullptr; index += Op::instructionLength(opcodes[index])) {
+        top = nativeStep(opcodes[index])(context, top, index);
+    }
+    return top;
+}
+
+template <Op::Code op>
+Value* VM::nativeStep(NativeContext *context, Value *top, size_t instructionIndex) {
+    return context->vm->step<op>(*context->batch, context->frame, top, instructionIndex);
+}
+
+Value* VM::nativeResume(NativeContext *context, Value *top, size_t instructionIndex) {
+    return context->vm->resume(*context->batch, context->frame, top, instructionIndex);
+}
+
+bool VM::compile(std::string_view titanCode, Batch &batch) {
+    Compiler compiler;
+    if (!compiler.compile(titanCode, batch, globals, strings)) {
+        return false;
+    }
+    if (disassembling) {
+        Debug::disassembleBatch(batch);
+    }
+    return true;
+}
+
+void VM::setTracing(bool enabled) {
+    tracing = enabled;
+}
+
+void VM::setDisassembling(bool enabled) {
+    disassembling = enabled;
+}
+
+bool VM::isDisassembling() const {
+    return disassembling;
+}
+
+Globals &VM::getGlobals() {
+    return globals;
+}
+
+Strings &VM::getStrings() {
+    return strings;
+}
+
+template <bool Traced>
+VM::InterpretResult VM::run(Batch &batch, Value* top) {
+#ifdef TITAN_COMPUTED_GOTO
+    //Jump targets for each Op::Code, must be in the same order as the Op::Code enum.
+    static void* dispatchTable[] = {
+        &&AddLabel, &&AddConstantLabel, &&CallBuiltinLabel, &&Constant32Label, &&ConstantLabel,
+        &&DefineGlobal32Label, &&DefineGlobalLabel, &&DivideLabel, &&DivideConstantLabel, &&EqualLabel,
+        &&FalseLabel, &&GetGlobal32Label, &&GetGlobalLabel, &&GetGlobalAddConstantLabel, &&GetIndexLabel,
+        &&GetLocalLabel, &&GreaterLabel, &&GreaterEqualLabel, &&LessLabel, &&LessEqualLabel,
+        &&MultiplyLabel, &&MultiplyConstantLabel, &&NegateLabel, &&NotLabel, &&NotEqualLabel,
+        &&NullLabel, &&PopLabel, &&PrintLabel, &&ReturnLabel, &&SetGlobal32Label,
+        &&SetGlobalLabel, &&SetGlobalIndex32Label, &&SetGlobalIndexLabel, &&SetLocalLabel, &&SetLocalIndexLabel,
+        &&SubtractLabel, &&SubtractConstantLabel, &&TrueLabel,
+    };
+    static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == Op::Code::SIZE, "Dispatch table is missing Op::Codes.");
+#endif //TITAN_COMPUTED_GOTO
+
+    //Titan has no call frames yet, so a local's slot is its index in the stack.
+    Value* frame = stack.get();
+
+    VM_DISPATCH_BEGIN
+        VM_CASE(Add) {
+            if (!add(top[-2], top[-1], batch)) {
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::Constant32: {
-                Op::Code firstHalf = *pc++;
-                Op::Code secondHalf = *pc++;
-                Value constant = batch.constantPool[Memory::toValue<size_t>(firstHalf, secondHalf)];
-                stack.push_back(constant);
-                break;
+            VM_POP();
+            VM_DISPATCH();
+        }
+        VM_CASE(AddConstant) {
+            if (!add(top[-1], batch.constantPool[*pc++], batch)) {
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::Constant: {
-                Value constant = batch.constantPool[*pc++];
-                stack.push_back(constant);
-                break;
+            VM_DISPATCH();
+        }
+        VM_CASE(CallBuiltin) {
+            const auto function = (Builtins::Function)*pc++;
+            Value* arguments = top - Builtins::arity(function);
+            if (!callBuiltin(function, arguments, batch)) {
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::DefineGlobal32: {
-                Op::Code firstHalf = *pc++;
-                Op::Code secondHalf = *pc++;
-                Value globalVarName = batch.constantPool[Memory::toValue<size_t>(firstHalf, secondHalf)];
-                globals[globalVarName.toString()] = stack.back();
-                stack.pop_back();
-                break;
+            VM_POP_TO(arguments + 1);
+            VM_DISPATCH();
+        }
+        VM_CASE(Constant32) {
+            Op::Code firstHalf = *pc++;
+            Op::Code secondHalf = *pc++;
+            *top++ = batch.constantPool[Memory::toValue<size_t>(firstHalf, secondHalf)];
+            VM_DISPATCH();
+        }
+        VM_CASE(Constant) {
+            *top++ = batch.constantPool[*pc++];
+            VM_DISPATCH();
+        }
+        VM_CASE(DefineGlobal32) {
+            Op::Code firstHalf = *pc++;
+            Op::Code secondHalf = *pc++;
+            globals.values[Memory::toValue<size_t>(firstHalf, secondHalf)] = std::move(*--top);
+            VM_DISPATCH();
+        }
+        VM_CASE(DefineGlobal) {
+            globals.values[*pc++] = std::move(*--top);
+            VM_DISPATCH();
+        }
+        VM_CASE(Divide) {
+            VM_BINARY_NUMBER_OP(fromNumber, /);
+            VM_DISPATCH();
+        }
+        VM_CASE(DivideConstant) {
+            VM_CONSTANT_NUMBER_OP(/);
+            VM_DISPATCH();
+        }
+        VM_CASE(Equal) {
+            const bool equal = top[-2] == top[-1];
+            VM_POP();
+            top[-1] = Value::fromBool(equal);
+            VM_DISPATCH();
+        }
+        VM_CASE(False) {
+            *top++ = Value::fromBool(false);
+            VM_DISPATCH();
+        }
+        VM_CASE(GetGlobal32) {
+            Op::Code firstHalf = *pc++;
+            Op::Code secondHalf = *pc++;
+            const size_t slot = Memory::toValue<size_t>(firstHalf, secondHalf);
+            if (globals.values[slot].isUndefined()) {
+                runtimeError("Undefined variable '" + globals.names[slot] + "'", batch);
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::DefineGlobal: {
-                Value globalVarName = batch.constantPool[*pc++];
-                globals[globalVarName.toString()] = stack.back();
-                stack.pop_back();
-                break;
+            *top++ = globals.values[slot];
+            VM_DISPATCH();
+        }
+        VM_CASE(GetGlobal) {
+            const size_t slot = *pc++;
+            if (globals.values[slot].isUndefined()) {
+                runtimeError("Undefined variable '" + globals.names[slot] + "'", batch);
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::Divide: {
-                if (checkBinaryOperandsHaveType(Value::Type::NUMBER)) {
-                    const auto operands = popBinaryOperands();
-                    stack.push_back(Value::fromNumber(operands[1].toType<double>() / operands[0].toType<double>()));
-                }
-                else {
-                    runtimeError("Operands must be numbers.", batch);
-                    return InterpretResult::RUNTIME_ERROR;
-                }
-                break;
+            *top++ = globals.values[slot];
+            VM_DISPATCH();
+        }
+        VM_CASE(GetGlobalAddConstant) {
+            const size_t slot = *pc++;
+            if (globals.values[slot].isUndefined()) {
+                runtimeError("Undefined variable '" + globals.names[slot] + "'", batch);
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::Equal: {
-                Value b = popValue();
-                Value a = popValue();
-                stack.push_back(Value::fromBool(b == a));
-                break;
+            *top++ = globals.values[slot];
+            if (!add(top[-1], batch.constantPool[*pc++], batch)) {
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::False: {
-                stack.push_back(Value::fromBool(false));
-                break;
+            VM_DISPATCH();
+        }
+        VM_CASE(GetIndex) {
+            const uint16_t flags = *pc++;
+            Value* operands = top - Op::subscriptLength(flags) - 1;
+            if (!getIndex(operands, flags, batch)) {
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::GetGlobal32: {
-                Op::Code firstHalf = *pc++;
-                Op::Code secondHalf = *pc++;
-                Value globalVarName = batch.constantPool[Memory::toValue<size_t>(firstHalf, secondHalf)];
-                stack.pop_back();
-                try {
-                    stack.push_back(globals.at(globalVarName.toString()));
-                }
-                catch (const std::out_of_range& exception) {
-                    runtimeError("Undefined variable '" + globalVarName.toString() + "'", batch);
-                    return InterpretResult::RUNTIME_ERROR;
-                }
-                break;
+            VM_POP_TO(operands + 1);
+            VM_DISPATCH();
+        }
+        VM_CASE(GetLocal) {
+            *top++ = frame[*pc++];
+            VM_DISPATCH();
+        }
+        VM_CASE(Greater) {
+            VM_BINARY_NUMBER_OP(fromBool, >);
+            VM_DISPATCH();
+        }
+        VM_CASE(GreaterEqual) {
+            VM_BINARY_NUMBER_OP(fromBool, >=);
+            VM_DISPATCH();
+        }
+        VM_CASE(Less) {
+            VM_BINARY_NUMBER_OP(fromBool, <);
+            VM_DISPATCH();
+        }
+        VM_CASE(LessEqual) {
+            VM_BINARY_NUMBER_OP(fromBool, <=);
+            VM_DISPATCH();
+        }
+        VM_CASE(Multiply) {
+            Value& lhs = top[-2];
+            if (lhs.isNumber() && top[-1].isNumber()) {
+                lhs = Value::fromNumber(lhs.toType<double>() * top[-1].toType<double>());
+                --top;
             }
-            case Op::Code::GetGlobal: {
-                Value globalVarName = batch.constantPool[*pc++];
-                stack.pop_back();
-                try {
-                    stack.push_back(globals.at(globalVarName.toString()));
-                }
-                catch (const std::out_of_range& exception) {
-                    runtimeError("Undefined variable '" + globalVarName.toString() + "'", batch);
-                    return InterpretResult::RUNTIME_ERROR;
-                }
-                break;
+            else if (multiply(lhs, top[-1], batch)) {
+                VM_POP();
             }
-            case Op::Code::Greater: {
-                if (checkBinaryOperandsHaveType(Value::Type::NUMBER)) {
-                    Value b = popValue();
-                    Value a = popValue();
-                    stack.push_back(Value::fromBool(a.toType<double>() > b.toType<double>()));
-                }
-                else {
-                    runtimeError("Operands must be numbers.", batch);
-                    return InterpretResult::RUNTIME_ERROR;
-                }
-                break;
+            else {
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::GreaterEqual: {
-                if (checkBinaryOperandsHaveType(Value::Type::NUMBER)) {
-                    Value b = popValue();
-                    Value a = popValue();
-                    stack.push_back(Value::fromBool(a.toType<double>() >= b.toType<double>()));
-                }
-                else {
-                    runtimeError("Operands must be numbers.", batch);
-                    return InterpretResult::RUNTIME_ERROR;
-                }
-                break;
+            VM_DISPATCH();
+        }
+        VM_CASE(MultiplyConstant) {
+            const Value& rhs = batch.constantPool[*pc++];
+            if (top[-1].isNumber() && rhs.isNumber()) {
+                top[-1] = Value::fromNumber(top[-1].toType<double>() * rhs.toType<double>());
             }
-            case Op::Code::Less: {
-                if (checkBinaryOperandsHaveType(Value::Type::NUMBER)) {
-                    Value b = popValue();
-                    Value a = popValue();
-                    stack.push_back(Value::fromBool(a.toType<double>() < b.toType<double>()));
-                }
-                else {
-                    runtimeError("Operands must be numbers.", batch);
-                    return InterpretResult::RUNTIME_ERROR;
-                }
-                break;
+            else if (!multiply(top[-1], rhs, batch)) {
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::LessEqual: {
-                if (checkBinaryOperandsHaveType(Value::Type::NUMBER)) {
-                    Value b = popValue();
-                    Value a = popValue();
-                    stack.push_back(Value::fromBool(a.toType<double>() <= b.toType<double>()));
-                }
-                else {
-                    runtimeError("Operands must be numbers.", batch);
+            VM_DISPATCH();
+        }
+        VM_CASE(Negate) {
+            Value& operand = top[-1];
+            switch (operand.type()) {
+                case Value::Type::NUMBER:  operand = Value::fromNumber(-operand.toType<double>());   break;
+                case Value::Type::MATRIXF: operand = Value::fromExpressionF(-operand.asExpressionF()); break;
+                case Value::Type::MATRIXD: operand = Value::fromExpressionD(-operand.asExpressionD()); break;
+                default:
+                    runtimeError("Operand must be a number or a matrix.", batch);
                     return InterpretResult::RUNTIME_ERROR;
-                }
-                break;
             }
-            case Op::Code::Multiply: {
-                if (checkBinaryOperandsHaveType(Value::Type::NUMBER)) {
-                    const auto operands = popBinaryOperands();
-                    stack.push_back(Value::fromNumber(operands[1].toType<double>() * operands[0].toType<double>()));
-                }
-                else {
-                    runtimeError("Operands must be numbers.", batch);
-                    return InterpretResult::RUNTIME_ERROR;
-                }
-                break;
+            VM_DISPATCH();
+        }
+        VM_CASE(Not) {
+            top[-1] = Value::fromBool(isFalsey(top[-1]));
+            VM_DISPATCH();
+        }
+        VM_CASE(NotEqual) {
+            const bool equal = top[-2] == top[-1];
+            VM_POP();
+            top[-1] = Value::fromBool(!equal);
+            VM_DISPATCH();
+        }
+        VM_CASE(Null) {
+            *top++ = Value::fromNull();
+            VM_DISPATCH();
+        }
+        VM_CASE(Pop) {
+            VM_POP();
+            VM_DISPATCH();
+        }
+        VM_CASE(Print) {
+            std::cout << top[-1].toString() << "\n";
+            VM_POP();
+            VM_DISPATCH();
+        }
+        VM_CASE(Return) {
+            return InterpretResult::OK;
+        }
+        VM_CASE(SetGlobal32) {
+            Op::Code firstHalf = *pc++;
+            Op::Code secondHalf = *pc++;
+            const size_t slot = Memory::toValue<size_t>(firstHalf, secondHalf);
+            if (globals.values[slot].isUndefined()) {
+                runtimeError("Undefined variable '" + globals.names[slot] + "'", batch);
+                return InterpretResult::RUNTIME_ERROR;
+            }
+            globals.values[slot] = top[-1];
+            VM_DISPATCH();
+        }
+        VM_CASE(SetGlobal) {
+            const size_t slot = *pc++;
+            if (globals.values[slot].isUndefined()) {
+                runtimeError("Undefined variable '" + globals.names[slot] + "'", batch);
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::Negate: {
-                if (stack.back().type != Value::Type::NUMBER) {
-                    runtimeError("Operand must be a number.", batch);
+            globals.values[slot] = top[-1];
+            VM_DISPATCH();
+        }
+        VM_CASE(SetGlobalIndex32) {
+            Op::Code firstHalf = *pc++;
+            Op::Code secondHalf = *pc++;
+            const uint16_t flags = *pc++;
+            Value* operands = top - Op::subscriptLength(flags) - 2;
+            if (!setGlobalIndex(Memory::toValue<size_t>(firstHalf, secondHalf), operands, flags, batch)) {
+                return InterpretResult::RUNTIME_ERROR;
+            }
+            VM_POP_TO(operands + 1);
+            VM_DISPATCH();
+        }
+        VM_CASE(SetGlobalIndex) {
+            const size_t slot = *pc++;
+            const uint16_t flags = *pc++;
+            Value* operands = top - Op::subscriptLength(flags) - 2;
+            if (!setGlobalIndex(slot, operands, flags, batch)) {
+                return InterpretResult::RUNTIME_ERROR;
+            }
+            VM_POP_TO(operands + 1);
+            VM_DISPATCH();
+        }
+        VM_CASE(SetLocal) {
+            frame[*pc++] = top[-1];
+            VM_DISPATCH();
+        }
+        VM_CASE(SetLocalIndex) {
+            Value& local = frame[*pc++];
+            const uint16_t flags = *pc++;
+            Value* operands = top - Op::subscriptLength(flags) - 2;
+            if (!setIndex(local, operands, flags, batch)) {
+                return InterpretResult::RUNTIME_ERROR;
+            }
+            VM_POP_TO(operands + 1);
+            VM_DISPATCH();
+        }
+        VM_CASE(Subtract) {
+            Value& lhs = top[-2];
+            if (lhs.isNumber() && top[-1].isNumber()) {
+                lhs = Value::fromNumber(lhs.toType<double>() - top[-1].toType<double>());
+                --top;
+            }
+            else if (subtract(lhs, top[-1], batch)) {
+                VM_POP();
+            }
+            else {
+                return InterpretResult::RUNTIME_ERROR;
+            }
+            VM_DISPATCH();
+        }
+        VM_CASE(SubtractConstant) {
+            const Value& rhs = batch.constantPool[*pc++];
+            if (top[-1].isNumber() && rhs.isNumber()) {
+                top[-1] = Value::fromNumber(top[-1].toType<double>() - rhs.toType<double>());
+            }
+            else if (!subtract(top[-1], rhs, batch)) {
+                return InterpretResult::RUNTIME_ERROR;
+            }
+            VM_DISPATCH();
+        }
+        VM_CASE(True) {
+            *top++ = Value::fromBool(true);
+            VM_DISPATCH();
+        }
+    VM_DISPATCH_END
+    return VM::OK;
+}
+
+VM::InterpretResult VM::run(Batch &batch, RegisterBatch &registers) {
+#ifdef TITAN_COMPUTED_GOTO
+    //Jump targets for each RegisterOp::Code, must be in the same order as the RegisterOp::Code enum.
+    static void* dispatchTable[] = {
+        &&AddLabel, &&CallBuiltinLabel, &&DefineGlobal32Label, &&DefineGlobalLabel, &&DivideLabel,
+        &&EqualLabel, &&GetGlobal32Label, &&GetGlobalLabel, &&GetIndexLabel, &&GreaterLabel,
+        &&GreaterEqualLabel, &&LessLabel, &&LessEqualLabel, &&LoadConstant32Label, &&MoveLabel,
+        &&MultiplyLabel, &&NegateLabel, &&NotLabel, &&NotEqualLabel, &&PrintLabel,
+        &&ReturnLabel, &&SetGlobal32Label, &&SetGlobalLabel, &&SetGlobalIndex32Label, &&SetGlobalIndexLabel,
+        &&SetLocalIndexLabel, &&SubtractLabel,
+    };
+    static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == RegisterOp::Code::SIZE, "Dispatch table is missing RegisterOp::Codes.");
+#endif //TITAN_COMPUTED_GOTO
+
+    Value* frame = stack.get();
+    const Value* constants = registers.constantPool.data();
+    const RegisterOp::Instruction* ip = registers.instructions.data();
+    const RegisterOp::Instruction* instruction;
+
+    //Reports an undefined global and leaves the loop.
+    auto undefined = [&](size_t slot) {
+        REGISTER_SYNC();
+        runtimeError("Undefined variable '" + globals.names[slot] + "'", batch);
+        return InterpretResult::RUNTIME_ERROR;
+    };
+
+    REGISTER_DISPATCH_BEGIN
+        REGISTER_CASE(Add) {
+            REGISTER_ARITHMETIC_OP(add, +);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(CallBuiltin) {
+            REGISTER_SYNC();
+            if (!callBuiltin((Builtins::Function)instruction->b, &frame[instruction->a], batch)) {
+                return InterpretResult::RUNTIME_ERROR;
+            }
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(DefineGlobal32) {
+            const size_t slot = Memory::toValue<size_t>((Op::Code)instruction->b, (Op::Code)instruction->c);
+            if (RegisterOp::isConstant(instruction->a)) globals.values[slot] = REGISTER_RK(instruction->a);
+            else globals.values[slot] = std::move(frame[instruction->a]);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(DefineGlobal) {
+            if (RegisterOp::isConstant(instruction->a)) globals.values[instruction->b] = REGISTER_RK(instruction->a);
+            else globals.values[instruction->b] = std::move(frame[instruction->a]);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(Divide) {
+            REGISTER_BINARY_NUMBER_OP(fromNumber, /);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(Equal) {
+            frame[instruction->a] = Value::fromBool(REGISTER_RK(instruction->b) == REGISTER_RK(instruction->c));
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(GetGlobal32) {
+            const size_t slot = Memory::toValue<size_t>((Op::Code)instruction->b, (Op::Code)instruction->c);
+            if (globals.values[slot].isUndefined()) {
+                return undefined(slot);
+            }
+            frame[instruction->a] = globals.values[slot];
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(GetGlobal) {
+            const size_t slot = instruction->b;
+            if (globals.values[slot].isUndefined()) {
+                return undefined(slot);
+            }
+            frame[instruction->a] = globals.values[slot];
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(GetIndex) {
+            REGISTER_SYNC();
+            if (!getIndex(&frame[instruction->a], instruction->b, batch)) {
+                return InterpretResult::RUNTIME_ERROR;
+            }
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(Greater) {
+            REGISTER_BINARY_NUMBER_OP(fromBool, >);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(GreaterEqual) {
+            REGISTER_BINARY_NUMBER_OP(fromBool, >=);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(Less) {
+            REGISTER_BINARY_NUMBER_OP(fromBool, <);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(LessEqual) {
+            REGISTER_BINARY_NUMBER_OP(fromBool, <=);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(LoadConstant32) {
+            frame[instruction->a] = constants[Memory::toValue<size_t>((Op::Code)instruction->b, (Op::Code)instruction->c)];
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(Move) {
+            frame[instruction->a] = REGISTER_RK(instruction->b);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(Multiply) {
+            REGISTER_ARITHMETIC_OP(multiply, *);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(Negate) {
+            const Value& operand = REGISTER_RK(instruction->b);
+            switch (operand.type()) {
+                case Value::Type::NUMBER:  frame[instruction->a] = Value::fromNumber(-operand.toType<double>());   break;
+                case Value::Type::MATRIXF: frame[instruction->a] = Value::fromExpressionF(-operand.asExpressionF()); break;
+                case Value::Type::MATRIXD: frame[instruction->a] = Value::fromExpressionD(-operand.asExpressionD()); break;
+                default:
+                    REGISTER_SYNC();
+                    runtimeError("Operand must be a number or a matrix.", batch);
                     return InterpretResult::RUNTIME_ERROR;
-                }
-                stack.back().data = stack.back().toType<double>() * -1;
-                break;
             }
-            case Op::Code::Not: {
-                stack.push_back(Value::fromBool(isFalsey(stack.back())));
-                break;
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(Not) {
+            frame[instruction->a] = Value::fromBool(isFalsey(REGISTER_RK(instruction->b)));
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(NotEqual) {
+            frame[instruction->a] = Value::fromBool(!(REGISTER_RK(instruction->b) == REGISTER_RK(instruction->c)));
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(Print) {
+            std::cout << REGISTER_RK(instruction->a).toString() << "\n";
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(Return) {
+            return InterpretResult::OK;
+        }
+        REGISTER_CASE(SetGlobal32) {
+            const size_t slot = Memory::toValue<size_t>((Op::Code)instruction->b, (Op::Code)instruction->c);
+            if (globals.values[slot].isUndefined()) {
+                return undefined(slot);
             }
-            case Op::Code::NotEqual: {
-                Value b = popValue();
-                Value a = popValue();
-                stack.push_back(Value::fromBool(!(b == a)));
-                break;
+            globals.values[slot] = REGISTER_RK(instruction->a);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(SetGlobal) {
+            const size_t slot = instruction->b;
+            if (globals.values[slot].isUndefined()) {
+                return undefined(slot);
             }
-            case Op::Code::Null: {
-                stack.push_back(Value::fromNull());
-                break;
+            globals.values[slot] = REGISTER_RK(instruction->a);
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(SetGlobalIndex32) {
+            //The slot is held by the following instruction.
+            const size_t slot = Memory::toValue<size_t>((Op::Code)ip->b, (Op::Code)ip->c);
+            ++ip;
+            REGISTER_SYNC();
+            if (!setGlobalIndex(slot, &frame[instruction->a], instruction->b, batch)) {
+                return InterpretResult::RUNTIME_ERROR;
             }
-            case Op::Code::Pop: {
-                stack.pop_back();
-                break;
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(SetGlobalIndex) {
+            REGISTER_SYNC();
+            if (!setGlobalIndex(instruction->c, &frame[instruction->a], instruction->b, batch)) {
+                return InterpretResult::RUNTIME_ERROR;
+            }
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(SetLocalIndex) {
+            REGISTER_SYNC();
+            if (!setIndex(frame[instruction->c], &frame[instruction->a], instruction->b, batch)) {
+                return InterpretResult::RUNTIME_ERROR;
+            }
+            REGISTER_DISPATCH();
+        }
+        REGISTER_CASE(Subtract) {
+            REGISTER_ARITHMETIC_OP(subtract, -);
+            REGISTER_DISPATCH();
+        }
+    REGISTER_DISPATCH_END
+    return VM::OK;
+}
+
+Value* VM::resume(Batch &batch, Value* frame, Value* top, size_t instructionIndex) {
+    pc = &batch.opcodes[instructionIndex];
+    const InterpretResult result = tracing ? run<true>(batch, top) : run<false>(batch, top);
+    return result == InterpretResult::OK ? frame : nullptr;
+}
+
+template <Op::Code op>
+Value* VM::step(Batch &batch, Value* frame, Value* top, size_t instructionIndex) {
+    const Op::Code* code = &batch.opcodes[instructionIndex];
+    //Points past the Op::Code, as run() does, so runtimeError() finds the instruction's line.
+    pc = const_cast<Op::Code*>(code) + 1;
+    auto wideOperand = [&] { return Memory::toValue<size_t>(code[1], code[2]); };
+    //Releases the values from first up to the stack top, and returns first as the new top.
+    auto popTo = [&](Value* first) {
+        for (Value* value = first; value < top; ++value) *value = Value();
+        return first;
+    };
+    auto undefined = [&](size_t slot) -> Value* {
+        runtimeError("Undefined variable '" + globals.names[slot] + "'", batch);
+        return nullptr;
+    };
+    auto numbers = [&](auto apply) -> Value* {
+        if (!top[-2].isNumber() || !top[-1].isNumber()) {
+            runtimeError("Operands must be numbers.", batch);
+            return nullptr;
+        }
+        top[-2] = apply(top[-2].toType<double>(), top[-1].toType<double>());
+        return popTo(top - 1);
+    };
+
+    switch (op) {
+        case Op::Code::Add:
+            return add(top[-2], top[-1], batch) ? popTo(top - 1) : nullptr;
+        case Op::Code::AddConstant:
+            return add(top[-1], batch.constantPool[code[1]], batch) ? top : nullptr;
+        case Op::Code::CallBuiltin: {
+            Value* arguments = top - Builtins::arity((Builtins::Function)code[1]);
+            return callBuiltin((Builtins::Function)code[1], arguments, batch) ? popTo(arguments + 1) : nullptr;
+        }
+        case Op::Code::Constant32:
+            *top = batch.constantPool[wideOperand()];
+            return top + 1;
+        case Op::Code::Constant:
+            *top = batch.constantPool[code[1]];
+            return top + 1;
+        case Op::Code::DefineGlobal32:
+            globals.values[wideOperand()] = std::move(top[-1]);
+            return top - 1;
+        case Op::Code::DefineGlobal:
+            globals.values[code[1]] = std::move(top[-1]);
+            return top - 1;
+        case Op::Code::Divide:
+            return numbers([](double lhs, double rhs) { return Value::fromNumber(lhs / rhs); });
+        case Op::Code::DivideConstant: {
+            const Value& rhs = batch.constantPool[code[1]];
+            if (!top[-1].isNumber() || !rhs.isNumber()) {
+                runtimeError("Operands must be numbers.", batch);
+                return nullptr;
+            }
+            top[-1] = Value::fromNumber(top[-1].toType<double>() / rhs.toType<double>());
+            return top;
+        }
+        case Op::Code::Equal:
+        case Op::Code::NotEqual: {
+            const bool equal = top[-2] == top[-1];
+            top[-2] = Value::fromBool(op == Op::Code::Equal ? equal : !equal);
+            return popTo(top - 1);
+        }
+        case Op::Code::False:
+            *top = Value::fromBool(false);
+            return top + 1;
+        case Op::Code::GetGlobal32:
+        case Op::Code::GetGlobal:
+        case Op::Code::GetGlobalAddConstant: {
+            const size_t slot = op == Op::Code::GetGlobal32 ? wideOperand() : (size_t)code[1];
+            if (globals.values[slot].isUndefined()) return undefined(slot);
+            *top = globals.values[slot];
+            if (op == Op::Code::GetGlobalAddConstant && !add(*top, batch.constantPool[code[2]], batch)) return nullptr;
+            return top + 1;
+        }
+        case Op::Code::GetIndex: {
+            Value* target = top - Op::subscriptLength(code[1]) - 1;
+            return getIndex(target, code[1], batch) ? popTo(target + 1) : nullptr;
+        }
+        case Op::Code::GetLocal:
+            *top = frame[code[1]];
+            return top + 1;
+        case Op::Code::Greater:
+            return numbers([](double lhs, double rhs) { return Value::fromBool(lhs > rhs); });
+        case Op::Code::GreaterEqual:
+            return numbers([](double lhs, double rhs) { return Value::fromBool(lhs >= rhs); });
+        case Op::Code::Less:
+            return numbers([](double lhs, double rhs) { return Value::fromBool(lhs < rhs); });
+        case Op::Code::LessEqual:
+            return numbers([](double lhs, double rhs) { return Value::fromBool(lhs <= rhs); });
+        case Op::Code::Multiply:
+            return multiply(top[-2], top[-1], batch) ? popTo(top - 1) : nullptr;
+        case Op::Code::MultiplyConstant:
+            return multiply(top[-1], batch.constantPool[code[1]], batch) ? top : nullptr;
+        case Op::Code::Negate: {
+            Value& operand = top[-1];
+            switch (operand.type()) {
+                case Value::Type::NUMBER:  operand = Value::fromNumber(-operand.toType<double>());   break;
+                case Value::Type::MATRIXF: operand = Value::fromExpressionF(-operand.asExpressionF()); break;
+                case Value::Type::MATRIXD: operand = Value::fromExpressionD(-operand.asExpressionD()); break;
+                default:
+                    runtimeError("Operand must be a number or a matrix.", batch);
+                    return nullptr;
+            }
+            return top;
+        }
+        case Op::Code::Not:
+            top[-1] = Value::fromBool(isFalsey(top[-1]));
+            return top;
+        case Op::Code::Null:
+            *top = Value::fromNull();
+            return top + 1;
+        case Op::Code::Pop:
+            return popTo(top - 1);
+        case Op::Code::Print:
+            std::cout << top[-1].toString() << "\n";
+            return popTo(top - 1);
+        case Op::Code::SetGlobal32:
+        case Op::Code::SetGlobal: {
+            const size_t slot = op == Op::Code::SetGlobal32 ? wideOperand() : (size_t)code[1];
+            if (globals.values[slot].isUndefined()) return undefined(slot);
+            globals.values[slot] = top[-1];
+            return top;
+        }
+        case Op::Code::SetGlobalIndex32: {
+            Value* operands = top - Op::subscriptLength(code[3]) - 2;
+            return setGlobalIndex(wideOperand(), operands, code[3], batch) ? popTo(operands + 1) : nullptr;
+        }
+        case Op::Code::SetGlobalIndex: {
+            Value* operands = top - Op::subscriptLength(code[2]) - 2;
+            return setGlobalIndex(code[1], operands, code[2], batch) ? popTo(operands + 1) : nullptr;
+        }
+        case Op::Code::SetLocal:
+            frame[code[1]] = top[-1];
+            return top;
+        case Op::Code::SetLocalIndex: {
+            Value* operands = top - Op::subscriptLength(code[2]) - 2;
+            return setIndex(frame[code[1]], operands, code[2], batch) ? popTo(operands + 1) : nullptr;
+        }
+        case Op::Code::Subtract:
+            return subtract(top[-2], top[-1], batch) ? popTo(top - 1) : nullptr;
+        case Op::Code::SubtractConstant:
+            return subtract(top[-1], batch.constantPool[code[1]], batch) ? top : nullptr;
+        case Op::Code::True:
+            *top = Value::fromBool(true);
+            return top + 1;
+        default:
+            //Return is compiled inline.
+            return top;
+    }
+}
+
+bool VM::add(Value &lhs, const Value &rhs, Batch &batch) {
+    try {
+        switch (typePair(lhs.type(), rhs.type())) {
+            case typePair(Value::Type::NUMBER, Value::Type::NUMBER):
+                lhs = Value::fromNumber(lhs.toType<double>() + rhs.toType<double>());
+                return true;
+            case typePair(Value::Type::STRING, Value::Type::STRING):
+                lhs = Value::fromString(lhs.asString() + rhs.asString());
+                return true;
+            case typePair(Value::Type::MATRIXF, Value::Type::MATRIXF):
+                lhs = Value::fromExpressionF(lhs.asExpressionF() + rhs.asExpressionF());
+                return true;
+            case typePair(Value::Type::MATRIXD, Value::Type::MATRIXD):
+                lhs = Value::fromExpressionD(lhs.asExpressionD() + rhs.asExpressionD());
+                return true;
+            default:
+                runtimeError("Operands must be two numbers, two strings or two matrices of the same precision.", batch);
+                return false;
+        }
+    }
+    catch (const std::invalid_argument& error) {
+        runtimeError(error.what(), batch);
+        return false;
+    }
+}
+
+bool VM::subtract(Value &lhs, const Value &rhs, Batch &batch) {
+    try {
+        switch (typePair(lhs.type(), rhs.type())) {
+            case typePair(Value::Type::NUMBER, Value::Type::NUMBER):
+                lhs = Value::fromNumber(lhs.toType<double>() - rhs.toType<double>());
+                return true;
+            case typePair(Value::Type::MATRIXF, Value::Type::MATRIXF):
+                lhs = Value::fromExpressionF(lhs.asExpressionF() - rhs.asExpressionF());
+                return true;
+            case typePair(Value::Type::MATRIXD, Value::Type::MATRIXD):
+                lhs = Value::fromExpressionD(lhs.asExpressionD() - rhs.asExpressionD());
+                return true;
+            default:
+                runtimeError("Operands must be two numbers or two matrices of the same precision.", batch);
+                return false;
+        }
+    }
+    catch (const std::invalid_argument& error) {
+        runtimeError(error.what(), batch);
+        return false;
+    }
+}
+
+bool VM::multiply(Value &lhs, const Value &rhs, Batch &batch) {
+    try {
+        switch (typePair(lhs.type(), rhs.type())) {
+            case typePair(Value::Type::NUMBER, Value::Type::NUMBER):
+                lhs = Value::fromNumber(lhs.toType<double>() * rhs.toType<double>());
+                return true;
+            case typePair(Value::Type::MATRIXF, Value::Type::MATRIXF):
+                lhs = Value::fromMatrixF(lhs.asMatrixF() * rhs.asMatrixF());
+                return true;
+            case typePair(Value::Type::MATRIXD, Value::Type::MATRIXD):
+                lhs = Value::fromMatrixD(lhs.asMatrixD() * rhs.asMatrixD());
+                return true;
+            case typePair(Value::Type::NUMBER, Value::Type::MATRIXF):
+                lhs = Value::fromExpressionF(rhs.asExpressionF() * (float)lhs.toType<double>());
+                return true;
+            case typePair(Value::Type::NUMBER, Value::Type::MATRIXD):
+                lhs = Value::fromExpressionD(rhs.asExpressionD() * lhs.toType<double>());
+                return true;
+            case typePair(Value::Type::MATRIXF, Value::Type::NUMBER):
+                lhs = Value::fromExpressionF(lhs.asExpressionF() * (float)rhs.toType<double>());
+                return true;
+            case typePair(Value::Type::MATRIXD, Value::Type::NUMBER):
+                lhs = Value::fromExpressionD(lhs.asExpressionD() * rhs.toType<double>());
+                return true;
+            default:
+                runtimeError("Operands must be numbers or matrices of the same precision.", batch);
+                return false;
+        }
+    }
+    catch (const std::invalid_argument& error) {
+        runtimeError(error.what(), batch);
+        return false;
+    }
+}
+
+bool VM::callBuiltin(Builtins::Function function, Value* arguments, Batch &batch) {
+    try {
+        arguments[0] = Builtins::call(function, arguments);
+        return true;
+    }
+    catch (const std::invalid_argument& error) {
+        runtimeError(error.what(), batch);
+        return false;
+    }
+}
+
+VM::Selection VM::select(const Value* subscript, uint16_t flags, int height, int width) {
+    const std::string dimensions = std::to_string(height) + "x" + std::to_string(width);
+    //Reads one dimension into first and count, and returns the number of values it took.
+    auto dimension = [&](const Value* values, bool range, int size, const std::string& name, int& first, int& count) -> size_t {
+        auto bound = [&](const Value& value, double missing) {
+            if (range && value.type() == Value::Type::NIL) return missing;
+            if (!value.isNumber() || std::trunc(value.toType<double>()) != value.toType<double>()) {
+                throw std::invalid_argument("Matrix indices must be integers.");
+            }
+            return value.toType<double>();
+        };
+        if (!range) {
+            const double index = bound(values[0], 0);
+            if (index < 0 || index >= size) {
+                throw std::invalid_argument(name + " " + std::to_string((long long)index) + " is out of range for a " + dimensions + " matrix.");
             }
-            case Op::Code::Print: {
-                std::cout << stack.back().toString() << "\n";
-                stack.pop_back();
+            first = (int)index;
+            count = 1;
+            return 1;
+        }
+        const double begin = bound(values[0], 0);
+        const double end = bound(values[1], size);
+        if (begin < 0 || end > size || begin > end) {
+            throw std::invalid_argument(name + "s " + std::to_string((long long)begin) + ":" + std::to_string((long long)end)
+                                        + " are out of range for a " + dimensions + " matrix.");
+        }
+        first = (int)begin;
+        count = (int)(end - begin);
+        return 2;
+    };
+
+    Selection selection{};
+    const size_t rowValues = dimension(subscript, flags & Op::Subscript::RowRange, height, "Row", selection.row, selection.rows);
+    dimension(subscript + rowValues, flags & Op::Subscript::ColumnRange, width, "Column", selection.column, selection.columns);
+    selection.entry = !(flags & (Op::Subscript::RowRange | Op::Subscript::ColumnRange));
+    return selection;
+}
+
+bool VM::getIndex(Value* target, uint16_t flags, Batch &batch) {
+    try {
+        Value result;
+        switch (target->type()) {
+            case Value::Type::MATRIXF: {
+                const MatrixExpressionF& matrix = target->asExpressionF();
+                const Selection selection = select(target + 1, flags, matrix.getHeight(), matrix.getWidth());
+                result = selection.entry ? Value::fromNumber(matrix.view()(selection.column, selection.row))
+                                         : Value::fromExpressionF(matrix.block(selection.column, selection.row, selection.columns, selection.rows));
                 break;
             }
-            case Op::Code::Return: {
-                return InterpretResult::OK;
+            case Value::Type::MATRIXD: {
+                const MatrixExpressionD& matrix = target->asExpressionD();
+                const Selection selection = select(target + 1, flags, matrix.getHeight(), matrix.getWidth());
+                result = selection.entry ? Value::fromNumber(matrix.view()(selection.column, selection.row))
+                                         : Value::fromExpressionD(matrix.block(selection.column, selection.row, selection.columns, selection.rows));
+                break;
             }
-            case Op::Code::Subtract: {
-                if (checkBinaryOperandsHaveType(Value::Type::NUMBER)) {
-                    const auto operands = popBinaryOperands();
-                    stack.push_back(Value::fromNumber(operands[1].toType<double>() - operands[0].toType<double>()));
+            default:
+                runtimeError("Only matrices can be subscripted.", batch);
+                return false;
+        }
+        *target = std::move(result);
+        return true;
+    }
+    catch (const std::invalid_argument& error) {
+        runtimeError(error.what(), batch);
+        return false;
+    }
+}
+
+bool VM::setGlobalIndex(size_t slot, Value* operands, uint16_t flags, Batch &batch) {
+    if (globals.values[slot].isUndefined()) {
+        runtimeError("Undefined variable '" + globals.names[slot] + "'", batch);
+        return false;
+    }
+    return setIndex(globals.values[slot], operands, flags, batch);
+}
+
+bool VM::setIndex(Value &variable, Value* operands, uint16_t flags, Batch &batch) {
+    //Drop the copy of the variable pushed before the subscript, so its matrix is only copied if another value shares it.
+    operands[0] = Value();
+    Value& value = operands[Op::subscriptLength(flags) + 1];
+
+    try {
+        switch (typePair(variable.type(), value.type())) {
+            case typePair(Value::Type::MATRIXF, Value::Type::NUMBER):
+            case typePair(Value::Type::MATRIXF, Value::Type::MATRIXF): {
+                const Selection selection = select(operands + 1, flags, variable.asExpressionF().getHeight(), variable.asExpressionF().getWidth());
+                MatrixExpressionF& matrix = variable.uniqueExpressionF();
+                if (value.isNumber()) {
+                    matrix.assign(selection.column, selection.row, selection.columns, selection.rows, (float)value.toType<double>());
+                    break;
                 }
-                else {
-                    runtimeError("Operands must be numbers.", batch);
-                    return InterpretResult::RUNTIME_ERROR;
+                const MatrixExpressionF& values = value.asExpressionF();
+                if (values.getWidth() != selection.columns || values.getHeight() != selection.rows) {
+                    throw std::invalid_argument("Cannot assign a " + std::to_string(values.getHeight()) + "x" + std::to_string(values.getWidth())
+                                                + " matrix to a " + std::to_string(selection.rows) + "x" + std::to_string(selection.columns) + " block.");
                 }
+                matrix.assign(selection.column, selection.row, values);
                 break;
             }
-            case Op::Code::True: {
-                stack.push_back(Value::fromBool(true));
+            case typePair(Value::Type::MATRIXD, Value::Type::NUMBER):
+            case typePair(Value::Type::MATRIXD, Value::Type::MATRIXD): {
+                const Selection selection = select(operands + 1, flags, variable.asExpressionD().getHeight(), variable.asExpressionD().getWidth());
+                MatrixExpressionD& matrix = variable.uniqueExpressionD();
+                if (value.isNumber()) {
+                    matrix.assign(selection.column, selection.row, selection.columns, selection.rows, value.toType<double>());
+                    break;
+                }
+                const MatrixExpressionD& values = value.asExpressionD();
+                if (values.getWidth() != selection.columns || values.getHeight() != selection.rows) {
+                    throw std::invalid_argument("Cannot assign a " + std::to_string(values.getHeight()) + "x" + std::to_string(values.getWidth())
+                                                + " matrix to a " + std::to_string(selection.rows) + "x" + std::to_string(selection.columns) + " block.");
+                }
+                matrix.assign(selection.column, selection.row, values);
                 break;
             }
+            default:
+                runtimeError("Only a number or a matrix of the same precision can be assigned to a subscript of a matrix.", batch);
+                return false;
         }
     }
-    return VM::OK;
-}
+    catch (const std::invalid_argument& error) {
+        runtimeError(error.what(), batch);
+        return false;
+    }
 
-std::vector<Value> VM::popBinaryOperands() {
-    return std::vector<Value>{popValue(), popValue()};
+    operands[0] = std::move(value);
+    return true;
 }
 
-Value VM::popValue() {
-    Value value = stack.back();
-    stack.pop_back();
-    return value;
+void VM::traceExecution(Batch& batch, const Value* top) const {
+    if (top != stack.get()) {
+        std::cout << "\t\t";
+        for (const Value* value = stack.get(); value < top; ++value) {
+            std::cout << "[" << value->toString() << "]";
+        }
+        std::cout << "\n";
+    }
+    Debug::disassembleInstruction(batch, (size_t) (pc - &batch.opcodes[0]));
 }
 
 void VM::runtimeError(const std::string &format, Batch& batch) {
@@ -258,14 +1084,20 @@ void VM::runtimeError(const std::string &format, Batch& batch) {
     size_t instruction = pc - &batch.opcodes[0] - 1;
     size_t line = batch.lines[instruction];
     std::cerr << "[Line " << line << "] in script\n";
+}
 
-    stack.clear();
+bool VM::checkStack(Batch& batch, size_t depth) {
+    if (depth <= MaxStackSize) return true;
+    //Nothing has run yet, so the error is reported against the batch's first instruction.
+    pc = &batch.opcodes[0] + 1;
+    runtimeError("Stack overflow.", batch);
+    return false;
 }
 
-bool VM::isFalsey(const Value &value) {
-    return value.type == Value::Type::NIL || (value.type == Value::Type::BOOL && !value.toType<bool>());
+void VM::releaseStack(size_t depth) {
+    std::fill_n(stack.get(), depth, Value());
 }
 
-bool VM::checkBinaryOperandsHaveType(Value::Type type) const {
-    return stack.size() > 1 && stack.back().type == type && stack[stack.size() - 2].type == type;
+bool VM::isFalsey(const Value &value) {
+    return value.isFalsey();
 }
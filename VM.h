@@ -8,18 +8,19 @@
  * @brief Contains the definition for Virtual Machine.
  */
 
-#include <unordered_set>
 #include <iostream>
 #include <memory>
 #include "Batch.h"
+#include "Builtins.h"
 #include "Ops.h"
 #include "Memory.h"
 #include "Debug.h"
 #include "Compiler.h"
 #include "Value.h"
-
-//Enable verbose tracing of bytecode execution
-#define DEBUG_TRACE_EXECUTION
+#include "Globals.h"
+#include "Jit.h"
+#include "RegisterBatch.h"
+#include "Strings.h"
 
 /**
  * The meat of Titan.
@@ -39,7 +40,7 @@ public:
     };
 
     /**
-     * Reserves stack space for the VM using MaxStackSize.
+     * Allocates the VM's fixed stack of MaxStackSize values.
      */
     VM();
 
@@ -50,54 +51,214 @@ public:
      * @param titanCode
      * @return OK if no errors found, otherwise COMPILE_ERROR or RUNTIME_ERROR.
      */
-    InterpretResult interpret(const std::string& titanCode);
+    InterpretResult interpret(std::string_view titanCode);
+
+    /**
+     * Runs a batch that has already been compiled against this VM's globals,
+     * e.g. by compile() or BatchFile::load().
+     *
+     * @brief Interprets a compiled batch.
+     * @param batch The batch to run.
+     * @return OK if no errors found, otherwise RUNTIME_ERROR.
+     */
+    InterpretResult interpret(Batch& batch);
+
+    /**
+     * Runs the register instructions generated from a batch by RegisterGenerator. The batch
+     * itself is only used for the line numbers of runtime errors.
+     *
+     * @brief Interprets a batch on the register machine.
+     * @param batch The compiled batch the register batch was generated from.
+     * @param registers The register batch to run.
+     * @return OK if no errors found, otherwise RUNTIME_ERROR.
+     */
+    InterpretResult interpret(Batch& batch, RegisterBatch& registers);
+
+    /**
+     * @brief Runs the native code compiled from a batch by Jit.
+     * @param batch The compiled batch the native code was compiled from.
+     * @param native The native code to run.
+     * @return OK if no errors found, otherwise RUNTIME_ERROR.
+     */
+    InterpretResult interpret(Batch& batch, NativeBatch& native);
+
+    /**
+     * Native code calls these for every instruction it has no template for, and whenever an
+     * operand fails a template's type checks. Each op has a function of its own, so native
+     * code calls straight into that op's handler rather than through a switch, whose
+     * indirect jump would be mispredicted from call sites that each run once.
+     *
+     * @brief Returns the function that runs one instruction of the given op on the raw value stack of native code.
+     */
+    static NativeStep nativeStep(Op::Code op);
+
+    /**
+     * Native code calls this for a run of consecutive instructions without templates, which
+     * are then dispatched from one place, as run() does, rather than from a call site each.
+     *
+     * @brief Runs the instructions of a batch between two indices on the raw value stack of native code.
+     * @param context The VM, batch and stack bottom of the native code.
+     * @param top The stack top, the slot the next push writes to.
+     * @param from The index of the first instruction's Op::Code.
+     * @param to The index of the Op::Code after the last instruction.
+     * @return The new stack top, or nullptr after a runtime error.
+     */
+    static Value* nativeRun(NativeContext* context, Value* top, size_t from, size_t to);
+
+    /**
+     * Native code calls this when a value fails a check its template speculated on, such as
+     * a global that isn't a number, and the rest of the batch is run by run() instead.
+     *
+     * @brief Hands the raw value stack of native code over to the stack machine, and runs the batch from an instruction to its Return.
+     * @param context The VM, batch and stack bottom of the native code.
+     * @param top The stack top, the slot the next push writes to.
+     * @param instructionIndex The index of the Op::Code to continue from.
+     * @return The stack bottom if the batch returned, or nullptr after a runtime error.
+     */
+    static Value* nativeResume(NativeContext* context, Value* top, size_t instructionIndex);
+
+    /**
+     * @brief Compiles Titan source code against this VM's globals without running it.
+     * @param titanCode A string containing Titan source code.
+     * @param batch The batch to compile the bytecode into.
+     * @return True if no compilation errors were found, otherwise false.
+     */
+    bool compile(std::string_view titanCode, Batch& batch);
+
+    /**
+     * Tracing runs batches on a separate instantiation of the stack machine's loop, so
+     * the loop batches normally run on has no tracing code in it at all. The register
+     * machine and native code aren't traced.
+     *
+     * @brief Sets whether the stack machine prints the stack and disassembles each instruction before running it.
+     * @param enabled True to trace batches run from now on.
+     */
+    void setTracing(bool enabled);
+
+    /**
+     * @brief Sets whether compile() disassembles each batch it compiles.
+     * @param enabled True to disassemble batches compiled from now on.
+     */
+    void setDisassembling(bool enabled);
+
+    /**
+     * @brief Returns true if compiled batches are disassembled, see setDisassembling().
+     */
+    bool isDisassembling() const;
+
+    /**
+     * @brief Returns the VM's global variable table.
+     */
+    Globals& getGlobals();
+
+    /**
+     * @brief Returns the VM's interned string table.
+     */
+    Strings& getStrings();
 protected:
     Op::Code* pc = nullptr;                         ///< Program counter.
-    std::vector<Value> stack;                       ///< The VM's value stack.
-    const size_t MaxStackSize = 4096;               ///< The maximum size of the value stack before stack overflow.
-    std::unordered_set<std::string> strings;        ///< Interned hashmap of all defined strings.
-    std::unordered_map<std::string, Value> globals; ///< Hashmap of all global variables by name.
+    static constexpr size_t MaxStackSize = 4096;    ///< The number of values the stack holds, batches that need more overflow before they run.
+    std::unique_ptr<Value[]> stack;                 ///< The VM's value stack. Slots above the stack top never hold Objects.
+    Strings strings;                                ///< Interned string constants, shared with every compile.
+    Globals globals;                                ///< Global variables, indexed by slot.
+    bool tracing = false;                           ///< Run batches on the traced stack machine loop, see setTracing().
+    bool disassembling = false;                     ///< Disassemble batches once they are compiled, see setDisassembling().
 
     /**
      * Executes the bytecode instructions of a batch.
      *
+     * Instructions are dispatched with computed gotos (threaded code) on GCC and Clang,
+     * and with a switch loop elsewhere or when TITAN_SWITCH_DISPATCH is defined. The stack
+     * top is a raw pointer, and the batch's Batch::maxStackDepth has already been checked
+     * against MaxStackSize, so pushes never check for overflow.
+     *
      * @brief Runs the Titan bytecode of a single batch.
+     * @tparam Traced True to call traceExecution() before every instruction, see setTracing().
      * @param batch The batch to be run.
+     * @param top The stack top, the slot the first push writes to.
      * @return OK if no errors found, otherwise COMPILE_ERROR or RUNTIME_ERROR.
      */
-    InterpretResult run(Batch& batch);
+    template <bool Traced>
+    InterpretResult run(Batch& batch, Value* top);
 
     /**
-     * Pops the two back-most values from the stack
-     * and returns them as a vector.
-     *
-     * This is a helper-function for operations that have two operands
-     * intended to reduce verbosity in the dispatch loop (run()).
+     * The registers are the values of the stack, whose size is checked against the frame
+     * before the batch runs. Instructions are dispatched like run()'s.
      *
-     * @brief Pops and returns the two back-most stack values.
-     * @return The two back-most values on the stack.
+     * @brief Runs the register instructions of a single batch.
+     * @param batch The compiled batch, for error reporting.
+     * @param registers The register batch to be run.
+     * @return OK if no errors found, otherwise RUNTIME_ERROR.
+     */
+    InterpretResult run(Batch& batch, RegisterBatch& registers);
+
+    /**
+     * @brief Runs one instruction of a batch on the raw value stack of native code, see nativeStep(Op::Code).
+     * @param context The VM, batch and stack bottom of the native code.
+     * @param top The stack top, the slot the next push writes to.
+     * @param instructionIndex The index of the instruction's Op::Code in the batch, which must be op.
+     * @return The new stack top, or nullptr after a runtime error.
      */
-    inline std::vector<Value> popBinaryOperands();
+    template <Op::Code op>
+    static Value* nativeStep(NativeContext* context, Value* top, size_t instructionIndex);
 
     /**
-     * Pops and returns a copy of the back-most value on the stack.
+     * Slots above the stack top never hold Objects, so native code can push other values
+     * without releasing what it overwrites: every value popped here is reset to null.
      *
-     * This is a helper function for reducing the verbosity of
-     * popping a value from the stack where the intention is to
-     * retain its value.
+     * @brief Runs one instruction of a batch on a raw value stack, see nativeStep(Op::Code).
+     * @tparam op The Op::Code of the instruction.
+     * @param batch The batch being run.
+     * @param frame The bottom of the stack, where local variable slots are counted from.
+     * @param top The stack top.
+     * @param instructionIndex The index of the instruction's Op::Code in the batch.
+     * @return The new stack top, or nullptr after a runtime error.
+     */
+    template <Op::Code op>
+    Value* step(Batch& batch, Value* frame, Value* top, size_t instructionIndex);
+
+    /**
+     * @brief Continues a batch on the stack machine from native code, see nativeResume().
+     * @param batch The batch being run.
+     * @param frame The bottom of the stack, which must be the stack's own storage.
+     * @param top The stack top.
+     * @param instructionIndex The index of the Op::Code to continue from.
+     * @return frame if the batch returned, or nullptr after a runtime error.
+     */
+    Value* resume(Batch& batch, Value* frame, Value* top, size_t instructionIndex);
+
+    /**
+     * Only called from the traced instantiation of run(), see setTracing().
      *
-     * @brief Pops and returns the back-most value on the stack.
-     * @return The back-most value on the stack.
+     * @brief Prints the stack and disassembles the instruction at the program counter.
+     * @param batch The batch being run.
+     * @param top The stack top.
      */
-    inline Value popValue();
+    void traceExecution(Batch& batch, const Value* top) const;
 
     /**
-     * @brief Prints an error, resets the stack and halts runtime execution.
+     * The values left on the stack are released by the interpret() that ran the batch.
+     *
+     * @brief Prints an error and halts runtime execution.
      * @param format The error string to print.
      * @param batch The batch that caused the runtime error.
      */
     void runtimeError(const std::string& format, Batch& batch);
 
+    /**
+     * @brief Reports a stack overflow if a batch needs more stack slots than the VM has.
+     * @param batch The batch about to run.
+     * @param depth The number of slots the batch needs.
+     * @return True if the slots fit on the stack, otherwise false after a runtime error.
+     */
+    bool checkStack(Batch& batch, size_t depth);
+
+    /**
+     * @brief Releases the values in the bottom slots of the stack once a batch has finished with them.
+     * @param depth The number of slots the batch used.
+     */
+    void releaseStack(size_t depth);
+
     /**
      * @brief Returns true if the value can be evaluated to false.
      * @param value The value to be tested for falsiness.
@@ -106,11 +267,114 @@ protected:
     static bool isFalsey(const Value& value);
 
     /**
-     * @brief Checks if the backmost two values on the stack have the provided type.
-     * @param type The type we expect the top two values on the stack to have.
-     * @return True if the backmost two values have the provided type, otherwise false.
+     * Shared by Add and the superinstructions that add a constant. Matrices are added
+     * lazily, see MatrixExpression.
+     *
+     * @brief Adds rhs to lhs in place, reporting a runtime error if they can't be added.
+     * @param lhs The left-hand operand, overwritten with the result.
+     * @param rhs The right-hand operand.
+     * @param batch The batch being run, for error reporting.
+     * @return True if the operands were added, otherwise false after a runtime error.
+     */
+    bool add(Value& lhs, const Value& rhs, Batch& batch);
+
+    /**
+     * Shared by Subtract and SubtractConstant. Matrices are subtracted lazily, see MatrixExpression.
+     *
+     * @brief Subtracts rhs from lhs in place, reporting a runtime error if they can't be subtracted.
+     * @param lhs The left-hand operand, overwritten with the result.
+     * @param rhs The right-hand operand.
+     * @param batch The batch being run, for error reporting.
+     * @return True if the operands were subtracted, otherwise false after a runtime error.
+     */
+    bool subtract(Value& lhs, const Value& rhs, Batch& batch);
+
+    /**
+     * Shared by Multiply and MultiplyConstant. Numbers multiply numbers and scale matrices
+     * lazily, and matrices of the same precision take their matrix product.
+     *
+     * @brief Multiplies lhs by rhs in place, reporting a runtime error if they can't be multiplied.
+     * @param lhs The left-hand operand, overwritten with the result.
+     * @param rhs The right-hand operand.
+     * @param batch The batch being run, for error reporting.
+     * @return True if the operands were multiplied, otherwise false after a runtime error.
+     */
+    bool multiply(Value& lhs, const Value& rhs, Batch& batch);
+
+    /**
+     * @brief Calls a built-in, overwriting its first argument with the result.
+     * @param function The built-in to call.
+     * @param arguments Pointer to the first of the built-in's arguments.
+     * @param batch The batch being run, for error reporting.
+     * @return True if the call succeeded, otherwise false after a runtime error.
+     */
+    bool callBuiltin(Builtins::Function function, Value* arguments, Batch& batch);
+
+    /**
+     * @brief The entry or block of a matrix a subscript selects.
+     */
+    struct Selection {
+        int row;     ///< The first row selected.
+        int column;  ///< The first column selected.
+        int rows;    ///< The number of rows selected.
+        int columns; ///< The number of columns selected.
+        bool entry;  ///< True if both dimensions are single indices, so the subscript selects one entry.
+    };
+
+    /**
+     * @brief Works out the entry or block of a height x width matrix a subscript selects.
+     * @param subscript Pointer to the first of the subscript's Op::subscriptLength(flags) values.
+     * @param flags The Op::Subscript flags of the subscript.
+     * @throws std::invalid_argument If an index isn't an integer or is out of range.
+     */
+    static Selection select(const Value* subscript, uint16_t flags, int height, int width);
+
+    /**
+     * Blocks are views of the matrix, see MatrixView, so subscripting never copies entries.
+     *
+     * @brief Overwrites a matrix with the entry or block selected by the subscript after it.
+     * @param target Pointer to the matrix, followed by the subscript's values.
+     * @param flags The Op::Subscript flags of the subscript.
+     * @param batch The batch being run, for error reporting.
+     * @return True if the subscript was valid, otherwise false after a runtime error.
+     */
+    bool getIndex(Value* target, uint16_t flags, Batch& batch);
+
+    /**
+     * The variable's matrix is written in place, and only copied first if another value
+     * shares it. The assigned value is moved into operands[0] as the result.
+     *
+     * @brief Assigns a value to the entry or block of a variable's matrix selected by a subscript.
+     * @param variable The global or local variable holding the matrix.
+     * @param operands Pointer to a copy of the variable, which is released first, followed by the subscript's values then the value to assign.
+     * @param flags The Op::Subscript flags of the subscript.
+     * @param batch The batch being run, for error reporting.
+     * @return True if the assignment succeeded, otherwise false after a runtime error.
+     */
+    bool setIndex(Value& variable, Value* operands, uint16_t flags, Batch& batch);
+
+    /**
+     * @brief Calls setIndex() on a global variable, reporting a runtime error if it is undefined.
+     * @param slot The global slot of the matrix.
+     * @param operands The operands of setIndex().
+     * @param flags The Op::Subscript flags of the subscript.
+     * @param batch The batch being run, for error reporting.
+     * @return True if the assignment succeeded, otherwise false after a runtime error.
+     */
+    bool setGlobalIndex(size_t slot, Value* operands, uint16_t flags, Batch& batch);
+
+    /**
+     * Combines the types of two operands into a single integer, so binary
+     * operators can dispatch on both types with one switch.
+     *
+     * @brief Returns a unique key for an ordered pair of value types.
+     * @param lhs The type of the left-hand operand.
+     * @param rhs The type of the right-hand operand.
+     * @return The key for the pair of types.
      */
-    bool checkBinaryOperandsHaveType(Value::Type type) const;
+    static constexpr int typePair(Value::Type lhs, Value::Type rhs) {
+        return lhs * 8 + rhs;
+    }
 };
 
 #endif //TITANPLUSPLUS_VM_H
@@ -1,50 +1,55 @@
 #include "Value.h"
 
-Value Value::fromBool(bool value) {
-    return {Value::Type::BOOL, value};
+Value Value::fromString(std::string value) {
+    return fromObject(new ObjectOf<std::string>{{Value::Type::STRING}, std::move(value)});
 }
 
-Value Value::fromNull() {
-    return {Value::Type::NIL, 0.f};
+Value Value::fromMatrixF(MatrixF value) {
+    return fromExpressionF(MatrixExpressionF(std::move(value)));
 }
 
-Value Value::fromNumber(double value) {
-    return {Value::Type::NUMBER, value};
+Value Value::fromMatrixD(MatrixD value) {
+    return fromExpressionD(MatrixExpressionD(std::move(value)));
 }
 
-Value Value::fromString(const std::string &value) {
-    return {Value::Type::STRING, value};
+Value Value::fromExpressionF(MatrixExpressionF value) {
+    return fromObject(new ObjectOf<MatrixExpressionF>{{Value::Type::MATRIXF}, std::move(value)});
 }
 
-Value Value::fromMatrixF(const MatrixF &value) {
-    return {Value::Type::MATRIXF, value};
+Value Value::fromExpressionD(MatrixExpressionD value) {
+    return fromObject(new ObjectOf<MatrixExpressionD>{{Value::Type::MATRIXD}, std::move(value)});
 }
 
-Value Value::fromMatrixD(const MatrixD &value) {
-    return {Value::Type::MATRIXD, value};
+void Value::destroy(Object* object) {
+    switch (object->type) {
+        case Type::STRING:  delete static_cast<ObjectOf<std::string>*>(object); break;
+        case Type::MATRIXF: delete static_cast<ObjectOf<MatrixExpressionF>*>(object); break;
+        case Type::MATRIXD: delete static_cast<ObjectOf<MatrixExpressionD>*>(object); break;
+        default:            break;
+    }
 }
 
 std::string Value::toString() const {
-    switch (type) {
-        case Type::BOOL:    return std::get<bool>(data) ? "true" : "false";
+    switch (type()) {
+        case Type::BOOL:    return toType<bool>() ? "true" : "false";
         case Type::NIL:     return "null";
-        case Type::NUMBER:  return std::to_string(std::get<double>(data));
-        case Type::STRING:  return std::get<std::string>(data);
-        case Type::MATRIXF: return std::get<MatrixF>(data).toString();
-        case Type::MATRIXD: return std::get<MatrixD>(data).toString();
+        case Type::NUMBER:  return std::to_string(toType<double>());
+        case Type::STRING:  return asString();
+        case Type::MATRIXF: return asMatrixF().toString();
+        case Type::MATRIXD: return asMatrixD().toString();
         default:            return "Unknown type.";
     }
 }
 
 bool Value::operator==(const Value &rhs) const {
-    if (this->type != rhs.type) return false;
-    switch (this->type) {
-        case Type::BOOL:    return std::get<bool>(data) == std::get<bool>(rhs.data);
-        case Type::NIL:     return true;
-        case Type::NUMBER:  return std::get<double>(data) == std::get<double>(rhs.data);
-        case Type::STRING:  return std::get<std::string>(data) == std::get<std::string>(rhs.data);
-        case Type::MATRIXF: return std::get<MatrixF>(data) == std::get<MatrixF>(rhs.data);
-        case Type::MATRIXD: return std::get<MatrixD>(data) == std::get<MatrixD>(rhs.data);
+    if (isNumber() && rhs.isNumber()) return toType<double>() == rhs.toType<double>();
+    //Identical immediates, or two references to the same object.
+    if (bits == rhs.bits) return true;
+    if (this->type() != rhs.type()) return false;
+    switch (this->type()) {
+        case Type::STRING:  return asString() == rhs.asString();
+        case Type::MATRIXF: return asMatrixF() == rhs.asMatrixF();
+        case Type::MATRIXD: return asMatrixD() == rhs.asMatrixD();
         default:            return false;
     }
 }
@@ -60,5 +65,3 @@ std::string Value::typeToString(Value::Type type) {
         default:            return "Unknown type.";
     }
 }
-
-
@@ -8,16 +8,28 @@
  * @brief The Value class, represents a Titan variable.
  */
 
+#include <cstdint>
 #include <string>
-#include <variant>
 #include "Matrix.h"
+#include "MatrixExpression.h"
+
+struct Object;
 
 /**
- * Value is essentially a tagged-union structure with utility functions.
+ * Value is a NaN-boxed 64-bit word.
+ *
+ * Numbers are stored as plain doubles. Every other type hides in the unused payload
+ * bits of a quiet NaN: null and booleans are immediate tag values, while strings and
+ * matrices are reference-counted heap Objects whose pointer is stored in the low 48 bits
+ * with the sign bit set. Copying a Value is therefore a single word copy, plus a
+ * reference count increment if it refers to an Object.
+ *
+ * Every NaN number is stored as CanonicalNaN, so a NaN read from a matrix or a file
+ * can never carry a payload that looks like a tag or an Object pointer.
  *
  * @note A Titan Value instance can only ever be one value type at any point in time,
- * so a union is appropriate, however this means developers must check that the types
- * of Values match if performing operations with multiple values.
+ * so developers must check that the types of Values match if performing operations
+ * with multiple values.
  *
  * @brief Represents a variable or value in Titan.
  * @class Value
@@ -33,49 +45,134 @@ struct Value {
         MATRIXD, ///< A numeric matrix of doubles.
     };
 
-    Value::Type type = Value::Type::NIL;                            ///< This Object's value type.
-    std::variant<bool, double, std::string, MatrixF, MatrixD> data; ///< Each value instance can only represent one type of value at once.
+    static const uint64_t SignBit      = 0x8000000000000000; ///< Set on boxed Object pointers.
+    static const uint64_t QuietNaN     = 0x7ffc000000000000; ///< Exponent and quiet bits shared by every non-number.
+    static const uint64_t NilTag       = 1;                  ///< Payload tag for null.
+    static const uint64_t FalseTag     = 2;                  ///< Payload tag for false.
+    static const uint64_t TrueTag      = 3;                  ///< Payload tag for true.
+    static const uint64_t UndefinedTag = 4;                  ///< Payload tag for the internal undefined marker.
+    static const uint64_t CanonicalNaN = 0x7ff8000000000000; ///< The bits of every NaN number, outside the boxed range.
+
+    uint64_t bits = QuietNaN | NilTag; ///< The boxed representation of this value.
+
+    /**
+     * @brief Creates a null value.
+     */
+    Value() = default;
+
+    /**
+     * @brief Copies a value, sharing its Object if it has one.
+     */
+    inline Value(const Value& other);
+
+    /**
+     * @brief Moves a value, leaving the source null.
+     */
+    inline Value(Value&& other) noexcept;
+
+    /**
+     * @brief Copies a value, sharing its Object if it has one.
+     */
+    inline Value& operator=(const Value& other);
+
+    /**
+     * @brief Moves a value, leaving the source null.
+     */
+    inline Value& operator=(Value&& other) noexcept;
+
+    /**
+     * @brief Releases this value's reference to its Object, if it has one.
+     */
+    inline ~Value();
 
     /**
      * @brief Converts a C++ boolean value to a Titan Value object.
      * @param value The boolean value the Value object will represent.
      * @return A Value object representing the given boolean.
      */
-    static Value fromBool(bool value);
+    static inline Value fromBool(bool value);
 
     /**
      * @brief Converts a null value to a Titan Value object.
      * @return A Value object representing null.
      */
-    static Value fromNull();
+    static inline Value fromNull();
 
     /**
-     * @brief Converts a C++ double value to a Titan Value object.
+     * @brief Converts a C++ double value to a Titan Value object, replacing any NaN with CanonicalNaN.
      * @param value The double value the Value object will represent.
      * @return A Value object representing the given C++ double.
      */
-    static Value fromNumber(double value);
+    static inline Value fromNumber(double value);
 
     /**
      * @brief Converts a C++ string to a Titan Value object.
      * @param value The string that the Value object will represent.
      * @return A Value object representing the given C++ string.
      */
-    static Value fromString(const std::string& value);
+    static Value fromString(std::string value);
 
     /**
      * @brief Converts a MatrixF to a Titan Value object.
      * @param value The matrix to be converted.
      * @return A Value object representing the given MatrixF.
      */
-    static Value fromMatrixF(const MatrixF& value);
+    static Value fromMatrixF(MatrixF value);
 
     /**
      * @brief Converts a MatrixD to a Titan Value object.
      * @param value The matrix to be converted.
      * @return A Value object representing the given MatrixD.
      */
-    static Value fromMatrixD(const MatrixD& value);
+    static Value fromMatrixD(MatrixD value);
+
+    /**
+     * @brief Converts a possibly unevaluated MatrixF expression to a Titan Value object.
+     * @param value The expression to be converted.
+     * @return A Value object of type MATRIXF representing the value of the expression.
+     */
+    static Value fromExpressionF(MatrixExpressionF value);
+
+    /**
+     * @brief Converts a possibly unevaluated MatrixD expression to a Titan Value object.
+     * @param value The expression to be converted.
+     * @return A Value object of type MATRIXD representing the value of the expression.
+     */
+    static Value fromExpressionD(MatrixExpressionD value);
+
+    /**
+     * Marks storage that has never been assigned, such as a global slot that has been
+     * resolved by the compiler but not yet defined. Never visible to Titan code.
+     *
+     * @brief Creates the internal undefined marker.
+     * @return The undefined marker value.
+     */
+    static inline Value undefined();
+
+    /**
+     * @brief Returns true if this value is the internal undefined marker.
+     */
+    inline bool isUndefined() const;
+
+    /**
+     * @brief Returns the Titan type of this value.
+     */
+    inline Value::Type type() const;
+
+    /**
+     * @brief Returns true if this value is a number.
+     */
+    inline bool isNumber() const;
+
+    /**
+     * @brief Returns true if this value is a boxed pointer to a heap Object.
+     */
+    inline bool isObject() const;
+
+    /**
+     * @brief Returns true if the value evaluates to false, i.e. it is null or false.
+     */
+    inline bool isFalsey() const;
 
     /**
      * @brief Returns the data this object represents as the specified type.
@@ -85,6 +182,53 @@ struct Value {
     template<typename T>
     inline T toType() const;
 
+    /**
+     * @brief Returns the heap Object this value points to. The value must be an Object.
+     */
+    inline Object* asObject() const;
+
+    /**
+     * @brief Returns a reference to the string this value holds, without copying it.
+     */
+    inline const std::string& asString() const;
+
+    /**
+     * @brief Returns a reference to the MatrixF this value holds, evaluating it first if it is a pending expression.
+     */
+    inline const MatrixF& asMatrixF() const;
+
+    /**
+     * @brief Returns a reference to the MatrixD this value holds, evaluating it first if it is a pending expression.
+     */
+    inline const MatrixD& asMatrixD() const;
+
+    /**
+     * Used by elementwise operators, so chains of them build one fused expression
+     * instead of evaluating each operator separately.
+     *
+     * @brief Returns a reference to the MatrixF expression this value holds, without evaluating it.
+     */
+    inline const MatrixExpressionF& asExpressionF() const;
+
+    /**
+     * @brief Returns a reference to the MatrixD expression this value holds, without evaluating it.
+     */
+    inline const MatrixExpressionD& asExpressionD() const;
+
+    /**
+     * Values share their Object when copied, so this gives the value its own copy of the
+     * expression first if another value shares it. The copy shares the matrix's entries
+     * until one of them is written (copy-on-write).
+     *
+     * @brief Returns a mutable reference to the MatrixF expression this value holds, for writing in place.
+     */
+    inline MatrixExpressionF& uniqueExpressionF();
+
+    /**
+     * @brief Returns a mutable reference to the MatrixD expression this value holds, for writing in place.
+     */
+    inline MatrixExpressionD& uniqueExpressionD();
+
     /**
      * @brief Creates a string representation of this object.
      * @return A string representation of the Titan Value.
@@ -107,6 +251,43 @@ struct Value {
      * @return A human readable std::string representation of the given Value::Type.
      */
     static std::string typeToString(Value::Type type);
+
+protected:
+    /**
+     * @brief Wraps a heap Object in a value, taking over its initial reference.
+     * @param object The object to box.
+     * @return A Value pointing to the object.
+     */
+    static inline Value fromObject(Object* object);
+
+    /**
+     * @brief Drops one reference to this value's Object and frees it when none remain.
+     */
+    inline void release();
+
+    /**
+     * @brief Frees an Object whose reference count has reached zero.
+     * @param object The Object to free.
+     */
+    static void destroy(Object* object);
+};
+
+/**
+ * @brief The header shared by every heap-allocated Titan value.
+ * @class Object
+ */
+struct Object {
+    Value::Type type;      ///< The Titan type of the data that follows this header.
+    uint32_t refCount = 1; ///< The number of Values referring to this object.
+};
+
+/**
+ * @brief A heap-allocated Titan value holding data of type T.
+ * @tparam T The C++ type of the data, std::string, MatrixExpressionF or MatrixExpressionD.
+ */
+template <typename T>
+struct ObjectOf : Object {
+    T data; ///< The data the object holds.
 };
 
 #include "Value.tpp"
@@ -1,12 +1,157 @@
 #ifndef TITANPLUSPLUS_VALUE_TPP
 #define TITANPLUSPLUS_VALUE_TPP
 
-#include <variant>
+#include <bit>
 #include "Value.h"
 
-template <typename T>
-inline T Value::toType() const {
-    return std::get<T>(this->data);
+static_assert(sizeof(Value) == sizeof(uint64_t), "Values must fit in a single 64-bit word.");
+
+inline Value::Value(const Value& other) : bits(other.bits) {
+    if (isObject()) asObject()->refCount++;
+}
+
+inline Value::Value(Value&& other) noexcept : bits(other.bits) {
+    other.bits = QuietNaN | NilTag;
+}
+
+inline Value& Value::operator=(const Value& other) {
+    if (other.isObject()) other.asObject()->refCount++;
+    release();
+    bits = other.bits;
+    return *this;
+}
+
+inline Value& Value::operator=(Value&& other) noexcept {
+    if (this != &other) {
+        release();
+        bits = other.bits;
+        other.bits = QuietNaN | NilTag;
+    }
+    return *this;
+}
+
+inline Value::~Value() {
+    release();
+}
+
+inline Value Value::fromBool(bool value) {
+    Value boxed;
+    boxed.bits = QuietNaN | (value ? TrueTag : FalseTag);
+    return boxed;
+}
+
+inline Value Value::fromNull() {
+    return {};
+}
+
+inline Value Value::fromNumber(double value) {
+    Value boxed;
+    //A NaN's payload could otherwise alias a boxed tag or Object.
+    boxed.bits = value != value ? CanonicalNaN : std::bit_cast<uint64_t>(value);
+    return boxed;
+}
+
+inline Value Value::undefined() {
+    Value boxed;
+    boxed.bits = QuietNaN | UndefinedTag;
+    return boxed;
+}
+
+inline bool Value::isUndefined() const {
+    return bits == (QuietNaN | UndefinedTag);
+}
+
+inline Value Value::fromObject(Object* object) {
+    Value boxed;
+    boxed.bits = SignBit | QuietNaN | reinterpret_cast<uint64_t>(object);
+    return boxed;
+}
+
+inline Value::Type Value::type() const {
+    if (isNumber()) return Type::NUMBER;
+    if (isObject()) return asObject()->type;
+    return bits == (QuietNaN | NilTag) ? Type::NIL : Type::BOOL;
+}
+
+inline bool Value::isNumber() const {
+    return (bits & QuietNaN) != QuietNaN;
+}
+
+inline bool Value::isObject() const {
+    return (bits & (QuietNaN | SignBit)) == (QuietNaN | SignBit);
+}
+
+inline bool Value::isFalsey() const {
+    return bits == (QuietNaN | NilTag) || bits == (QuietNaN | FalseTag);
+}
+
+inline Object* Value::asObject() const {
+    return reinterpret_cast<Object*>(bits & ~(SignBit | QuietNaN));
+}
+
+inline const std::string& Value::asString() const {
+    return static_cast<ObjectOf<std::string>*>(asObject())->data;
+}
+
+inline const MatrixF& Value::asMatrixF() const {
+    return asExpressionF().matrix();
+}
+
+inline const MatrixD& Value::asMatrixD() const {
+    return asExpressionD().matrix();
+}
+
+inline const MatrixExpressionF& Value::asExpressionF() const {
+    return static_cast<ObjectOf<MatrixExpressionF>*>(asObject())->data;
+}
+
+inline const MatrixExpressionD& Value::asExpressionD() const {
+    return static_cast<ObjectOf<MatrixExpressionD>*>(asObject())->data;
+}
+
+inline MatrixExpressionF& Value::uniqueExpressionF() {
+    if (asObject()->refCount > 1) {
+        *this = fromExpressionF(asExpressionF());
+    }
+    return static_cast<ObjectOf<MatrixExpressionF>*>(asObject())->data;
+}
+
+inline MatrixExpressionD& Value::uniqueExpressionD() {
+    if (asObject()->refCount > 1) {
+        *this = fromExpressionD(asExpressionD());
+    }
+    return static_cast<ObjectOf<MatrixExpressionD>*>(asObject())->data;
+}
+
+inline void Value::release() {
+    if (isObject() && --asObject()->refCount == 0) {
+        destroy(asObject());
+    }
+}
+
+template <>
+inline bool Value::toType<bool>() const {
+    return bits == (QuietNaN | TrueTag);
+}
+
+template <>
+inline double Value::toType<double>() const {
+    return std::bit_cast<double>(bits);
+}
+
+template <>
+inline std::string Value::toType<std::string>() const {
+    return asString();
+}
+
+template <>
+inline MatrixF Value::toType<MatrixF>() const {
+    return asMatrixF();
+}
+
+template <>
+inline MatrixD Value::toType<MatrixD>() const {
+    return asMatrixD();
 }
 
 #endif //TITANPLUSPLUS_VALUE_TPP
@@ -1,35 +1,116 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 #include "Batch.h"
 #include "Ops.h"
 #include "Debug.h"
 #include "Memory.h"
 #include "VM.h"
+#include "BatchFile.h"
+#include "Jit.h"
+#include "MappedFile.h"
+#include "RegisterGenerator.h"
 
 enum ExitCodes {
     OK = 0,
     TOO_MANY_ARGS = -1,
     COMPILE_ERROR = -2,
-    INTERPRET_ERROR = -3
+    INTERPRET_ERROR = -3,
+    IO_ERROR = -4
+};
+
+///How a script is executed.
+enum class Engine {
+    Stack,     ///< Interpreted by the stack machine.
+    Registers, ///< Interpreted by the register machine.
+    Native,    ///< Compiled to machine code by the JIT.
 };
 
 static void repl(VM& vm) {
     std::string line;
     for (;;) {
         std::cout << "> ";
-        std::getline(std::cin, line);
+        if (!std::getline(std::cin, line)) break;
         std::cout << "\n";
         vm.interpret(line);
     }
 }
 
-static std::string fileToString(const std::string& path) {
-    std::ifstream file(path);
-    std::stringstream stream;
-    stream << file.rdbuf();
-    return stream.str();
+static int toExitCode(VM::InterpretResult result) {
+    switch (result) {
+        case VM::InterpretResult::OK:            return OK;
+        case VM::InterpretResult::COMPILE_ERROR: return COMPILE_ERROR;
+        default:                                 return INTERPRET_ERROR;
+    }
+}
+
+static int runBatch(VM& vm, Batch& batch, Engine engine) {
+    if (engine == Engine::Stack) {
+        return toExitCode(vm.interpret(batch));
+    }
+    if (engine == Engine::Native) {
+        NativeBatch native;
+        if (!Jit::compile(batch, native)) {
+            std::cerr << "Could not compile the script to native code.\n";
+            return COMPILE_ERROR;
+        }
+        return toExitCode(vm.interpret(batch, native));
+    }
+    RegisterBatch registerBatch;
+    if (!RegisterGenerator::generate(batch, registerBatch)) {
+        std::cerr << "Too many values on the stack to run on the register machine.\n";
+        return COMPILE_ERROR;
+    }
+    if (vm.isDisassembling()) {
+        Debug::disassembleRegisterBatch(registerBatch, batch);
+    }
+    return toExitCode(vm.interpret(batch, registerBatch));
+}
+
+static int runFile(VM& vm, const std::string& path, Engine engine) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Could not open '" << path << "'.\n";
+        return IO_ERROR;
+    }
+
+    //Compiled batches skip the scanner and compiler entirely.
+    if (BatchFile::isBatchFile(file)) {
+        Batch batch;
+        if (!BatchFile::load(file, batch, vm.getGlobals(), vm.getStrings())) {
+            return IO_ERROR;
+        }
+        if (vm.isDisassembling()) {
+            Debug::disassembleBatch(batch);
+        }
+        return runBatch(vm, batch, engine);
+    }
+    if (engine != Engine::Stack) {
+        Batch batch;
+        if (!vm.compile(file.view(), batch)) {
+            return COMPILE_ERROR;
+        }
+        return runBatch(vm, batch, engine);
+    }
+    //The source is scanned and compiled in place in the mapping.
+    return toExitCode(vm.interpret(file.view()));
+}
+
+static int emitBatch(VM& vm, const std::string& path, const std::string& outputPath) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Could not open '" << path << "'.\n";
+        return IO_ERROR;
+    }
+
+    Batch batch;
+    if (!vm.compile(file.view(), batch)) {
+        return COMPILE_ERROR;
+    }
+    if (!BatchFile::save(batch, vm.getGlobals(), outputPath)) {
+        std::cerr << "Could not write '" << outputPath << "'.\n";
+        return IO_ERROR;
+    }
+    return OK;
 }
 
 int main(int argc, const char** argv) {
@@ -65,14 +146,43 @@ int main(int argc, const char** argv) {
     vm.interpret(batch);
      */
 
+    //Debugging options come first, and apply to the REPL or whatever script follows them.
+    while (argc > 1) {
+        const std::string option = argv[1];
+        if (option == "--trace") vm.setTracing(true);
+        else if (option == "--disassemble") vm.setDisassembling(true);
+        else break;
+        --argc;
+        ++argv;
+    }
+
     if (argc == 1) {
         repl(vm);
     }
     else if (argc == 2) {
-        vm.interpret(fileToString(argv[1]));
+        return runFile(vm, argv[1], Engine::Stack);
+    }
+    else if (argc == 3 && std::string(argv[1]) == "--registers") {
+        return runFile(vm, argv[2], Engine::Registers);
+    }
+    else if (argc == 3 && std::string(argv[1]) == "--jit") {
+        if (!Jit::isAvailable()) {
+            //Reported like a batch Jit::compile() rejects, see runBatch().
+            std::cerr << "The JIT is only available on Linux x86-64.\n";
+            return COMPILE_ERROR;
+        }
+        return runFile(vm, argv[2], Engine::Native);
+    }
+    else if (argc == 4 && std::string(argv[1]) == "--emit") {
+        return emitBatch(vm, argv[3], argv[2]);
     }
     else {
-        std::cout << "Usage: Titan [path]\n";
+        std::cout << "Usage: Titan [--trace] [--disassemble] [path]\n";
+        std::cout << "       Titan --registers <path>      Run path on the register machine instead of the stack machine.\n";
+        std::cout << "       Titan --jit <path>            Compile path to x86-64 machine code before running it (Linux x86-64 only).\n";
+        std::cout << "       Titan --emit <output> <path>  Compile path to a batch file that Titan can run directly.\n";
+        std::cout << "       --trace                       Print the stack and each instruction as the stack machine runs it.\n";
+        std::cout << "       --disassemble                 Disassemble each batch before it runs.\n";
         return TOO_MANY_ARGS;
     }
 
@@ -0,0 +1,117 @@
+//
+// Created by Bryn McKerracher on 17/10/2026.
+//
+
+#ifndef TITANPLUSPLUS_SCRIPTTESTING_H
+#define TITANPLUSPLUS_SCRIPTTESTING_H
+
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <gtest/gtest.h>
+#include "../Jit.h"
+#include "../MatrixFile.h"
+#include "../RegisterGenerator.h"
+#include "../VM.h"
+
+///How runScript() executes a script.
+enum class Engine {
+    Stack,     ///< Interpreted by the stack machine.
+    Registers, ///< Interpreted by the register machine.
+    Native,    ///< Compiled to machine code by the JIT.
+};
+
+/**
+ * @brief What a script printed, and how it finished.
+ */
+struct ScriptResult {
+    VM::InterpretResult result; ///< OK, or the kind of error the script stopped with.
+    std::string output;         ///< Everything printed to stdout, including runtime error messages.
+    std::string errors;         ///< Everything printed to stderr, such as the lines of runtime errors.
+};
+
+/**
+ * The prelude is run on the stack machine first, in its own batch, so the script can
+ * use globals it didn't define itself. Engines that can't run the script, e.g. the JIT
+ * off Linux x86-64, report COMPILE_ERROR.
+ *
+ * @brief Compiles and runs a script on a fresh VM, capturing what it prints.
+ */
+inline ScriptResult runScript(std::string_view source, Engine engine = Engine::Stack, std::string_view prelude = {}) {
+    VM vm;
+    Batch batch;
+    RegisterBatch registers;
+    NativeBatch native;
+    testing::internal::CaptureStdout();
+    testing::internal::CaptureStderr();
+
+    VM::InterpretResult result = VM::InterpretResult::COMPILE_ERROR;
+    if (!prelude.empty()) vm.interpret(prelude);
+    if (vm.compile(source, batch)) {
+        switch (engine) {
+            case Engine::Stack:
+                result = vm.interpret(batch);
+                break;
+            case Engine::Registers:
+                if (RegisterGenerator::generate(batch, registers)) result = vm.interpret(batch, registers);
+                break;
+            case Engine::Native:
+                if (Jit::compile(batch, native)) result = vm.interpret(batch, native);
+                break;
+        }
+    }
+
+    std::string output = testing::internal::GetCapturedStdout();
+    std::string errors = testing::internal::GetCapturedStderr();
+    return {result, std::move(output), std::move(errors)};
+}
+
+/**
+ * @brief Expects a script to print the same output and errors, and finish the same way, on the stack machine and another engine.
+ */
+inline void expectSameAsStack(std::string_view source, Engine engine, std::string_view prelude = {}) {
+    const ScriptResult expected = runScript(source, Engine::Stack, prelude);
+    const ScriptResult actual = runScript(source, engine, prelude);
+    ASSERT_NE(expected.result, VM::InterpretResult::COMPILE_ERROR) << source << "\n" << expected.output;
+    EXPECT_EQ(actual.result, expected.result) << source;
+    EXPECT_EQ(actual.output, expected.output) << source;
+    EXPECT_EQ(actual.errors, expected.errors) << source;
+}
+
+///NaNs whose payloads overlap the boxed tags and Object pointers, including signalling and negative ones.
+inline constexpr uint64_t AdversarialNaNs[] = {
+    0x7ff0000000000001, //Signalling.
+    0x7ff4000000000000, //Signalling, with the bit just below the quiet bit set.
+    0x7ffc000000000001, //The null tag.
+    0x7ffc000000000003, //The true tag.
+    0x7ffc000000000004, //The undefined tag.
+    0xfffc000000000010, //A negative payload, which looks like an Object pointer.
+    0xfff4000000000010, //A negative signalling payload.
+    0xffffffffffffffff,
+};
+
+///The output of adversarialNaNScript() for each of AdversarialNaNs.
+inline constexpr std::string_view AdversarialNaNOutput = "nan\nfalse\nfalse\nnan\n";
+
+/**
+ * Each NaN is read into a global, then printed, compared with true and with itself, and added to.
+ *
+ * @brief Saves AdversarialNaNs to a matrix file, and returns a script that reads them back.
+ */
+inline std::string adversarialNaNScript(const std::string& path) {
+    const int count = (int)std::size(AdversarialNaNs);
+    MatrixD matrix(count, 1);
+    for (int x = 0; x < count; ++x) matrix.data()[x] = std::bit_cast<double>(AdversarialNaNs[x]);
+    EXPECT_TRUE(MatrixWriter<double>::save(matrix.block(0, 0, count, 1), path));
+
+    std::string script = "var m = load(\"" + path + "\");\n";
+    for (int x = 0; x < count; ++x) {
+        const std::string name = "x" + std::to_string(x);
+        script += "var " + name + " = m[0, " + std::to_string(x) + "];\n";
+        script += "print " + name + "; print " + name + " == true; print " + name + " == " + name + "; print " + name + " + 1;\n";
+    }
+    return script;
+}
+
+#endif //TITANPLUSPLUS_SCRIPTTESTING_H
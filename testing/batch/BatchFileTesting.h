@@ -0,0 +1,249 @@
+//
+// Created by Bryn McKerracher on 17/10/2026.
+//
+
+#ifndef TITANPLUSPLUS_BATCHFILETESTING_H
+#define TITANPLUSPLUS_BATCHFILETESTING_H
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <gtest/gtest.h>
+#include "../../BatchFile.h"
+#include "../ScriptTesting.h"
+
+///Where the op code stream starts in a batch file, after the magic and the three uint32 and three uint64 header fields.
+const size_t OpCodesOffset = 4 + 3 * sizeof(uint32_t) + 3 * sizeof(uint64_t);
+
+/**
+ * @brief Compiles a script on a fresh VM and returns the bytes BatchFile::save() writes for it.
+ * @param batch Set to the compiled batch.
+ */
+inline std::string emitBatch(std::string_view source, Batch& batch) {
+    VM vm;
+    EXPECT_TRUE(vm.compile(source, batch)) << source;
+    const std::string path = testing::TempDir() + "titan_emit.tbc";
+    EXPECT_TRUE(BatchFile::save(batch, vm.getGlobals(), path));
+    std::ifstream stream(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    stream.close();
+    std::remove(path.c_str());
+    return bytes;
+}
+
+/**
+ * The prelude is run first, so the batch's globals can be given different slots from the ones
+ * it was compiled against. Batches BatchFile::load() rejects report COMPILE_ERROR, with the
+ * loader's message in the errors.
+ *
+ * @brief Writes batch file bytes to disk, then maps, loads and runs them on a fresh VM, capturing what is printed.
+ */
+inline ScriptResult runBatchFile(const std::string& bytes, Engine engine = Engine::Stack, std::string_view prelude = {}) {
+    const std::string path = testing::TempDir() + "titan_load.tbc";
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream.write(bytes.data(), (std::streamsize)bytes.size());
+    }
+    VM vm;
+    Batch batch;
+    RegisterBatch registers;
+    NativeBatch native;
+    MappedFile file;
+    EXPECT_TRUE(file.open(path));
+    testing::internal::CaptureStdout();
+    testing::internal::CaptureStderr();
+
+    VM::InterpretResult result = VM::InterpretResult::COMPILE_ERROR;
+    if (!prelude.empty()) vm.interpret(prelude);
+    if (BatchFile::load(file, batch, vm.getGlobals(), vm.getStrings())) {
+        switch (engine) {
+            case Engine::Stack:
+                result = vm.interpret(batch);
+                break;
+            case Engine::Registers:
+                if (RegisterGenerator::generate(batch, registers)) result = vm.interpret(batch, registers);
+                break;
+            case Engine::Native:
+                if (Jit::compile(batch, native)) result = vm.interpret(batch, native);
+                break;
+        }
+    }
+
+    std::string output = testing::internal::GetCapturedStdout();
+    std::string errors = testing::internal::GetCapturedStderr();
+    file.close();
+    std::remove(path.c_str());
+    return {result, std::move(output), std::move(errors)};
+}
+
+/**
+ * @brief Expects batch file bytes to be rejected with the given loader message.
+ */
+inline void expectRejected(const std::string& bytes, std::string_view message) {
+    const ScriptResult result = runBatchFile(bytes);
+    EXPECT_EQ(result.result, VM::InterpretResult::COMPILE_ERROR) << message;
+    EXPECT_NE(result.errors.find(message), std::string::npos) << result.errors;
+    EXPECT_EQ(result.output, "");
+}
+
+/**
+ * @brief Overwrites the value at the given byte offset of a batch file.
+ */
+template <typename T>
+void patchBytes(std::string& bytes, size_t offset, T value) {
+    std::memcpy(&bytes[offset], &value, sizeof(T));
+}
+
+/**
+ * @brief Overwrites the Op::Code at the given index of a batch file's op code stream.
+ */
+inline void patchOpCode(std::string& bytes, size_t index, Op::Code code) {
+    patchBytes(bytes, OpCodesOffset + index * sizeof(Op::Code), code);
+}
+
+//Local slots index straight into the VM's stack, so a slot at or above the stack top is rejected.
+TEST(BatchFile, LocalSlots) {
+    for (const char* script : {"var a = 1; { var b = 2; print b + a; }",
+                               "var a = 1; { var b = 2; b = a; print b; }",
+                               "{ var m = [[1, 2]]; m[0, 1] = 5; print m; }"}) {
+        Batch batch;
+        const std::string bytes = emitBatch(script, batch);
+        EXPECT_EQ(runBatchFile(bytes).output, runScript(script).output) << script;
+
+        for (Op::Code op : {Op::Code::GetLocal, Op::Code::SetLocal, Op::Code::SetLocalIndex}) {
+            size_t index = 0;
+            while (index < batch.opcodes.size() && batch.opcodes[index] != op) index += Op::instructionLength(batch.opcodes[index]);
+            if (index == batch.opcodes.size()) continue;
+            for (Op::Code slot : {(Op::Code)1, (Op::Code)0xFFFF}) {
+                std::string corrupt = bytes;
+                patchOpCode(corrupt, index + 1, slot);
+                const ScriptResult result = runBatchFile(corrupt);
+                EXPECT_EQ(result.result, VM::InterpretResult::COMPILE_ERROR) << script << " op " << op << " slot " << slot;
+                EXPECT_NE(result.errors.find("Compiled batch has corrupt instructions."), std::string::npos) << result.errors;
+            }
+        }
+    }
+}
+
+//A saved batch prints the same when loaded and run on each engine, with its globals resolved in the running VM.
+TEST(BatchFile, RoundTrip) {
+    const char* script = "var s = \"str\"; var m = [[1, 2] [3, 4]]; var n = 2; var t = true; var u = nil;\n"
+                         "print s + \"!\"; print m * m; print n * 3 + 1; print !t; print u == nil; print m[1, 0];\n"
+                         "{ var l = n + 1; l = l * 2; print l; } print -0; print 1 / 0;";
+    Batch batch;
+    const std::string bytes = emitBatch(script, batch);
+    const ScriptResult expected = runScript(script);
+    ASSERT_EQ(expected.result, VM::InterpretResult::OK) << expected.output;
+
+    for (Engine engine : {Engine::Stack, Engine::Registers, Engine::Native}) {
+        if (engine == Engine::Native && !Jit::isAvailable()) continue;
+        const ScriptResult result = runBatchFile(bytes, engine);
+        EXPECT_EQ(result.result, VM::InterpretResult::OK) << result.errors;
+        EXPECT_EQ(result.output, expected.output);
+        EXPECT_EQ(result.errors, "");
+    }
+
+    //Globals defined first take the batch's slots, so every global operand is rewritten.
+    const ScriptResult moved = runBatchFile(bytes, Engine::Stack, "var x = 1; var y = 2; var n = 7; var z = 3;");
+    EXPECT_EQ(moved.result, VM::InterpretResult::OK) << moved.errors;
+    EXPECT_EQ(moved.output, expected.output);
+}
+
+TEST(BatchFile, Header) {
+    Batch batch;
+    const std::string bytes = emitBatch("print 1;", batch);
+
+    std::string magic = bytes;
+    magic[0] = 'X';
+    expectRejected(magic, "Not a compiled Titan batch.");
+    expectRejected(bytes.substr(0, 3), "Not a compiled Titan batch.");
+    expectRejected(bytes.substr(0, OpCodesOffset - 1), "Not a compiled Titan batch.");
+
+    //The version, then the size and count of Op::Codes.
+    for (size_t offset : {4, 8, 12}) {
+        std::string version = bytes;
+        patchBytes<uint32_t>(version, offset, 1000);
+        expectRejected(version, "incompatible version of Titan");
+    }
+}
+
+//Every prefix of a batch file is rejected, as are counts that run past its end.
+TEST(BatchFile, Truncated) {
+    Batch batch;
+    const std::string bytes = emitBatch("var g = \"global\"; print g + \"s\"; print [[1, 2]];", batch);
+    for (size_t size = 0; size < bytes.size(); ++size) {
+        const ScriptResult result = runBatchFile(bytes.substr(0, size));
+        EXPECT_EQ(result.result, VM::InterpretResult::COMPILE_ERROR) << size;
+        EXPECT_EQ(result.output, "") << size;
+    }
+
+    //The op code, constant and global name counts.
+    for (size_t offset : {16, 24, 32}) {
+        for (uint64_t count : {(uint64_t)bytes.size(), UINT64_MAX / 4 + 1, UINT64_MAX}) {
+            std::string counts = bytes;
+            patchBytes<uint64_t>(counts, offset, count);
+            const ScriptResult result = runBatchFile(counts);
+            EXPECT_EQ(result.result, VM::InterpretResult::COMPILE_ERROR) << offset << " " << count;
+        }
+    }
+}
+
+TEST(BatchFile, CorruptConstants) {
+    Batch batch;
+    const std::string number = emitBatch("print 1.5;", batch);
+    //The constant pool is last, the number's type byte then its 8 bytes.
+    std::string type = number;
+    patchBytes<uint8_t>(type, number.size() - 9, 0xFF);
+    expectRejected(type, "Compiled batch has a corrupt constant pool.");
+
+    Batch matrixBatch;
+    const std::string matrix = emitBatch("print [[1, 2, 3]];", matrixBatch);
+    ASSERT_EQ(matrixBatch.constantPool.size(), 1u);
+    const size_t entrySize = matrixBatch.constantPool[0].type() == Value::Type::MATRIXF ? sizeof(float) : sizeof(double);
+    //The width, then the entry count, then the entries.
+    const size_t width = matrix.size() - 3 * entrySize - sizeof(uint64_t) - sizeof(int32_t);
+    for (int32_t badWidth : {0, -3, 2}) {
+        std::string corrupt = matrix;
+        patchBytes<int32_t>(corrupt, width, badWidth);
+        expectRejected(corrupt, "Compiled batch has a corrupt constant pool.");
+    }
+    std::string entries = matrix;
+    patchBytes<uint64_t>(entries, width + sizeof(int32_t), 6);
+    expectRejected(entries, "Compiled batch has a corrupt constant pool.");
+}
+
+TEST(BatchFile, CorruptOpCodes) {
+    Batch batch;
+    const std::string bytes = emitBatch("var g = 1; print g + 2; print g * g; print sum([[1, 2]]);", batch);
+    const size_t constant = 0;
+    ASSERT_EQ(batch.opcodes[constant], Op::Code::Constant);
+
+    //An unknown op code, and a batch that doesn't end with Return.
+    for (auto [index, code] : std::initializer_list<std::pair<size_t, Op::Code>>{
+            {constant, Op::Code::SIZE}, {batch.opcodes.size() - 1, Op::Code::Pop}}) {
+        std::string corrupt = bytes;
+        patchOpCode(corrupt, index, code);
+        expectRejected(corrupt, "Compiled batch has corrupt instructions.");
+    }
+
+    //Operands past the end of the constant pool, the global names and the builtins.
+    for (size_t index = 0; index < batch.opcodes.size(); index += Op::instructionLength(batch.opcodes[index])) {
+        const Op::Code op = batch.opcodes[index];
+        if (op != Op::Code::Constant && op != Op::Code::GetGlobal && op != Op::Code::DefineGlobal
+            && op != Op::Code::CallBuiltin && op != Op::Code::GetGlobalAddConstant && op != Op::Code::MultiplyConstant
+            && op != Op::Code::AddConstant) continue;
+        std::string corrupt = bytes;
+        patchOpCode(corrupt, index + 1, (Op::Code)0xFFFF);
+        expectRejected(corrupt, "Compiled batch has corrupt instructions.");
+    }
+
+    //An instruction whose operands run past the end of the batch.
+    std::string cut = bytes;
+    patchOpCode(cut, batch.opcodes.size() - 1, Op::Code::Constant);
+    expectRejected(cut, "Compiled batch has corrupt instructions.");
+}
+
+#endif //TITANPLUSPLUS_BATCHFILETESTING_H
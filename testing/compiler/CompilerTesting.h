@@ -0,0 +1,249 @@
+//
+// Created by Bryn McKerracher on 17/10/2026.
+//
+
+#ifndef TITANPLUSPLUS_COMPILERTESTING_H
+#define TITANPLUSPLUS_COMPILERTESTING_H
+
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../ScriptTesting.h"
+
+/**
+ * @brief Compiles a script against a fresh VM, capturing any compile errors.
+ * @return True if the script compiled.
+ */
+inline bool compileScript(std::string_view source, Batch& batch, std::string* errors = nullptr) {
+    VM vm;
+    testing::internal::CaptureStderr();
+    const bool compiled = vm.compile(source, batch);
+    const std::string captured = testing::internal::GetCapturedStderr();
+    if (errors != nullptr) *errors = captured;
+    return compiled;
+}
+
+/**
+ * @brief Returns the Op::Code of each instruction in a batch, without their operands.
+ */
+inline std::vector<Op::Code> instructions(const Batch& batch) {
+    std::vector<Op::Code> ops;
+    for (size_t index = 0; index < batch.opcodes.size(); index += Op::instructionLength(batch.opcodes[index])) {
+        ops.push_back(batch.opcodes[index]);
+    }
+    return ops;
+}
+
+TEST(Locals, Shadowing) {
+    EXPECT_EQ(runScript("{ var a = 1; { var a = 2; print a; { var a = 3; print a; } print a; } print a; }").output,
+              "2.000000\n3.000000\n2.000000\n1.000000\n");
+    EXPECT_EQ(runScript("var a = 1; { var a = 2; print a; } print a;").output, "2.000000\n1.000000\n");
+
+    Batch batch;
+    std::string errors;
+    EXPECT_FALSE(compileScript("{ var a = 1; var a = 2; }", batch, &errors));
+    EXPECT_NE(errors.find("Already a variable with this name in this scope."), std::string::npos) << errors;
+}
+
+TEST(Locals, SelfInitialisation) {
+    //The new local shadows an outer local or global of the same name from its declaration on.
+    for (const char* script : {"{ var a = a; }", "{ var a = 1; { var a = a + 1; } }", "var a = 1; { var a = a; }"}) {
+        Batch batch;
+        std::string errors;
+        EXPECT_FALSE(compileScript(script, batch, &errors)) << script;
+        EXPECT_NE(errors.find("Can't read local variable in its own initialiser."), std::string::npos) << errors;
+    }
+}
+
+TEST(Locals, AssignOuter) {
+    EXPECT_EQ(runScript("{ var a = 1; { var b = 2; a = b + 3; print a; } print a; a = a * 2; print a; }").output,
+              "5.000000\n5.000000\n10.000000\n");
+
+    Batch batch;
+    ASSERT_TRUE(compileScript("{ var a = 1; { var b = 2; a = b; } }", batch));
+    const std::vector<Op::Code> expected = {
+        Op::Code::Constant, Op::Code::Constant, Op::Code::GetLocal, Op::Code::SetLocal,
+        Op::Code::Pop, Op::Code::Pop, Op::Code::Pop, Op::Code::Return,
+    };
+    EXPECT_EQ(instructions(batch), expected);
+    //The assignment reads slot 1 and writes slot 0.
+    EXPECT_EQ(batch.opcodes[5], 1);
+    EXPECT_EQ(batch.opcodes[7], 0);
+}
+
+//Each local is popped when its block ends, innermost block first.
+TEST(Locals, ScopeEndPops) {
+    Batch batch;
+    ASSERT_TRUE(compileScript("{ var a = 1; { var b = 2; var c = 3; print b; } print a; } print 4;", batch));
+    const std::vector<Op::Code> expected = {
+        Op::Code::Constant, Op::Code::Constant, Op::Code::Constant, Op::Code::GetLocal, Op::Code::Print,
+        Op::Code::Pop, Op::Code::Pop, Op::Code::GetLocal, Op::Code::Print, Op::Code::Pop,
+        Op::Code::Constant, Op::Code::Print, Op::Code::Return,
+    };
+    EXPECT_EQ(instructions(batch), expected);
+    EXPECT_EQ(batch.maxStackDepth, 4u);
+
+    //A later block reuses the slots an earlier one released.
+    EXPECT_EQ(runScript("{ var a = 1; } { var b = 2; print b; } { var c; print c; }").output, "2.000000\nnull\n");
+}
+
+TEST(ConstantFolding, Numbers) {
+    Batch batch;
+    ASSERT_TRUE(compileScript("print 1 + 2 * 3 - 4 / 2;", batch));
+    EXPECT_EQ(instructions(batch), (std::vector<Op::Code>{Op::Code::Constant, Op::Code::Print, Op::Code::Return}));
+    //The operands folded away are rewound out of the pool.
+    ASSERT_EQ(batch.constantPool.size(), 1u);
+    EXPECT_EQ(batch.constantPool[0].toType<double>(), 5.0);
+
+    Batch comparisons;
+    ASSERT_TRUE(compileScript("print 1 < 2; print 2 <= 1; print 3 > 2; print 1 >= 1; print 1 == 1; print 1 != 1;", comparisons));
+    EXPECT_EQ(instructions(comparisons), (std::vector<Op::Code>{
+        Op::Code::True, Op::Code::Print, Op::Code::False, Op::Code::Print, Op::Code::True, Op::Code::Print,
+        Op::Code::True, Op::Code::Print, Op::Code::True, Op::Code::Print, Op::Code::False, Op::Code::Print, Op::Code::Return,
+    }));
+    EXPECT_TRUE(comparisons.constantPool.empty());
+}
+
+TEST(ConstantFolding, Unary) {
+    Batch batch;
+    ASSERT_TRUE(compileScript("print -(2 + 3); print !nil; print !1; print --4;", batch));
+    EXPECT_EQ(instructions(batch), (std::vector<Op::Code>{
+        Op::Code::Constant, Op::Code::Print, Op::Code::True, Op::Code::Print,
+        Op::Code::False, Op::Code::Print, Op::Code::Constant, Op::Code::Print, Op::Code::Return,
+    }));
+    ASSERT_EQ(batch.constantPool.size(), 2u);
+    EXPECT_EQ(batch.constantPool[0].toType<double>(), -5.0);
+    EXPECT_EQ(batch.constantPool[1].toType<double>(), 4.0);
+}
+
+TEST(ConstantFolding, Strings) {
+    Batch batch;
+    ASSERT_TRUE(compileScript("print \"ti\" + \"t\" + \"an\"; print \"a\" == \"a\";", batch));
+    EXPECT_EQ(instructions(batch), (std::vector<Op::Code>{Op::Code::Constant, Op::Code::Print, Op::Code::True, Op::Code::Print, Op::Code::Return}));
+    ASSERT_EQ(batch.constantPool.size(), 1u);
+    EXPECT_EQ(batch.constantPool[0].asString(), "titan");
+}
+
+//Operands that aren't both literals, or whose operation could fail or is run on matrices, are left to the VM.
+TEST(ConstantFolding, Unfolded) {
+    Batch mixed;
+    ASSERT_TRUE(compileScript("print 1 + \"a\";", mixed));
+    EXPECT_EQ(instructions(mixed), (std::vector<Op::Code>{Op::Code::Constant, Op::Code::AddConstant, Op::Code::Print, Op::Code::Return}));
+
+    Batch matrices;
+    ASSERT_TRUE(compileScript("print [[1]] == [[1]]; print -[[1]];", matrices));
+    EXPECT_EQ(instructions(matrices), (std::vector<Op::Code>{
+        Op::Code::Constant, Op::Code::Constant, Op::Code::Equal, Op::Code::Print,
+        Op::Code::Constant, Op::Code::Negate, Op::Code::Print, Op::Code::Return,
+    }));
+
+    //Only the literal subexpression is folded.
+    Batch partial;
+    ASSERT_TRUE(compileScript("var g = 1; print g * (2 + 3);", partial));
+    EXPECT_EQ(instructions(partial), (std::vector<Op::Code>{
+        Op::Code::Constant, Op::Code::DefineGlobal, Op::Code::GetGlobal, Op::Code::MultiplyConstant, Op::Code::Print, Op::Code::Return,
+    }));
+    EXPECT_EQ(partial.constantPool[partial.opcodes[7]].toType<double>(), 5.0);
+}
+
+//An undefined global read by a fused GetGlobalAddConstant is reported on the global's line, as it is unfused.
+TEST(Optimiser, FusedErrorLine) {
+    const ScriptResult result = runScript("print 1;\nprint zz\n+ 1;");
+    EXPECT_EQ(result.result, VM::InterpretResult::RUNTIME_ERROR);
+    EXPECT_EQ(result.errors, "[Line 1] in script\n");
+    EXPECT_EQ(runScript("print 1;\nprint zz\n+ 1;", Engine::Registers).errors, result.errors);
+}
+
+TEST(Optimiser, GetGlobalAddConstant) {
+    Batch batch;
+    ASSERT_TRUE(compileScript("var g = 1; print g + 2;", batch));
+    EXPECT_EQ(instructions(batch), (std::vector<Op::Code>{Op::Code::Constant, Op::Code::DefineGlobal, Op::Code::GetGlobalAddConstant, Op::Code::Print, Op::Code::Return}));
+    //The global's slot, then the constant's index.
+    EXPECT_EQ(batch.opcodes[5], batch.opcodes[3]);
+    EXPECT_EQ(batch.constantPool[batch.opcodes[6]].toType<double>(), 2.0);
+    EXPECT_EQ(runScript("var g = 1; print g + 2; print g + \"s\";").output, "3.000000\nOperands must be two numbers, two strings or two matrices of the same precision.\n");
+}
+
+TEST(Optimiser, ConstantOperands) {
+    Batch batch;
+    ASSERT_TRUE(compileScript("var g = 8; print g - 2; print g * 3; print g / 4; { var l = 1; print l + 5; }", batch));
+    EXPECT_EQ(instructions(batch), (std::vector<Op::Code>{
+        Op::Code::Constant, Op::Code::DefineGlobal,
+        Op::Code::GetGlobal, Op::Code::SubtractConstant, Op::Code::Print,
+        Op::Code::GetGlobal, Op::Code::MultiplyConstant, Op::Code::Print,
+        Op::Code::GetGlobal, Op::Code::DivideConstant, Op::Code::Print,
+        Op::Code::Constant, Op::Code::GetLocal, Op::Code::AddConstant, Op::Code::Print, Op::Code::Pop, Op::Code::Return,
+    }));
+    EXPECT_EQ(runScript("var g = 8; print g - 2; print g * 3; print g / 4; { var l = 1; print l + 5; }").output,
+              "6.000000\n24.000000\n2.000000\n6.000000\n");
+}
+
+TEST(Optimiser, NegatedEquality) {
+    Batch batch;
+    ASSERT_TRUE(compileScript("var g = 1; print !(g == 2); print !(g != 2);", batch));
+    EXPECT_EQ(instructions(batch), (std::vector<Op::Code>{
+        Op::Code::Constant, Op::Code::DefineGlobal,
+        Op::Code::GetGlobal, Op::Code::Constant, Op::Code::NotEqual, Op::Code::Print,
+        Op::Code::GetGlobal, Op::Code::Constant, Op::Code::Equal, Op::Code::Print, Op::Code::Return,
+    }));
+    EXPECT_EQ(runScript("var g = 1; print !(g == 2); print !(g != 2);").output, "true\nfalse\n");
+}
+
+//A value that is pushed only to be popped again is never pushed.
+TEST(Optimiser, DeadLoads) {
+    Batch batch;
+    ASSERT_TRUE(compileScript("1; \"s\"; true; nil; { var l = 1; } { var m = 2; m; }", batch));
+    EXPECT_EQ(instructions(batch), (std::vector<Op::Code>{Op::Code::Constant, Op::Code::Pop, Op::Code::Return}));
+}
+
+TEST(ConstantPool, Deduplication) {
+    Batch batch;
+    EXPECT_EQ(batch.addConstant(Value::fromNumber(1.5)), 0u);
+    EXPECT_EQ(batch.addConstant(Value::fromString("titan")), 1u);
+    EXPECT_EQ(batch.addConstant(Value::fromNumber(1.5)), 0u);
+    //Strings are shared by their characters, not by their Object.
+    EXPECT_EQ(batch.addConstant(Value::fromString("titan")), 1u);
+    EXPECT_EQ(batch.addConstant(Value::fromBool(true)), 2u);
+    EXPECT_EQ(batch.addConstant(Value::fromBool(true)), 2u);
+    EXPECT_EQ(batch.addConstant(Value::fromNull()), 3u);
+
+    //0 and -0 print differently, so they must stay distinct, while NaNs can share an entry.
+    EXPECT_EQ(batch.addConstant(Value::fromNumber(0.0)), 4u);
+    EXPECT_EQ(batch.addConstant(Value::fromNumber(-0.0)), 5u);
+    EXPECT_EQ(batch.addConstant(Value::fromNumber(0.0)), 4u);
+    EXPECT_EQ(batch.addConstant(Value::fromNumber(NAN)), 6u);
+    EXPECT_EQ(batch.addConstant(Value::fromNumber(-NAN)), 6u);
+
+    //Matrices always get an entry of their own.
+    EXPECT_EQ(batch.addConstant(Value::fromMatrixF(MatrixF("[1]"))), 7u);
+    EXPECT_EQ(batch.addConstant(Value::fromMatrixF(MatrixF("[1]"))), 8u);
+    EXPECT_EQ(batch.constantPool.size(), 9u);
+}
+
+//Constants removed by a rewind are forgotten, so adding them again gives a fresh index inside the pool.
+TEST(ConstantPool, Rewind) {
+    Batch batch;
+    batch.addConstant(Value::fromNumber(1));
+    batch.addConstant(Value::fromNumber(2));
+    batch.addConstant(Value::fromString("s"));
+    batch.rewind(0, 1);
+    ASSERT_EQ(batch.constantPool.size(), 1u);
+    EXPECT_EQ(batch.addConstant(Value::fromString("s")), 1u);
+    EXPECT_EQ(batch.addConstant(Value::fromNumber(2)), 2u);
+    EXPECT_EQ(batch.addConstant(Value::fromNumber(1)), 0u);
+    EXPECT_EQ(batch.constantPool.size(), 3u);
+
+    //Folding rewinds the operands it replaces.
+    Batch folded;
+    ASSERT_TRUE(compileScript("print 2 + 3; print 2; print 5; print 0; print -0;", folded));
+    ASSERT_EQ(folded.constantPool.size(), 4u);
+    EXPECT_EQ(folded.constantPool[0].toType<double>(), 5.0);
+    EXPECT_EQ(folded.constantPool[1].toType<double>(), 2.0);
+    EXPECT_EQ(folded.constantPool[2].bits, Value::fromNumber(0.0).bits);
+    EXPECT_EQ(folded.constantPool[3].bits, Value::fromNumber(-0.0).bits);
+    EXPECT_EQ(runScript("print 0; print -0;").output, "0.000000\n-0.000000\n");
+}
+
+#endif //TITANPLUSPLUS_COMPILERTESTING_H
@@ -5,8 +5,12 @@
 #ifndef TITANPLUSPLUS_MATRIXTESTING_H
 #define TITANPLUSPLUS_MATRIXTESTING_H
 
+#include <algorithm>
+#include <cmath>
 #include <gtest/gtest.h>
 #include "../../Matrix.h"
+#include "../../MatrixExpression.h"
+#include "../../MatrixFile.h"
 
 TEST(Matrix, Equal) {
     MatrixF m1("[4, 54, 3.4, 6.4, 122.3345] 4, 54, 3.4, 6.4, 122.3345 4, 54, 3.4, 6.4, 122.3345");
@@ -18,6 +22,20 @@ TEST(Matrix, Equal) {
     EXPECT_EQ(m1, m2);
 }
 
+//A NaN entry is unequal to everything, whichever size of matrix or device compares it.
+TEST(Matrix, EqualNaN) {
+    for (int n : {4, 1024}) {
+        MatrixD a(n, n);
+        std::fill(a.data(), a.data() + a.size(), 1.0);
+        a(n - 1, n / 2) = std::nan("");
+        MatrixD b(n, n);
+        std::copy(a.data(), a.data() + a.size(), b.data());
+        EXPECT_NE(a, b) << n;
+        EXPECT_EQ(MatrixBackend::reduce<double>(n, n, Reduction::Unequal, a.data(), n, b.data(), n), 1) << n;
+        EXPECT_EQ(MatrixBackend::reduce<double>(n, n - 1, Reduction::Unequal, a.data(), n, b.data(), n), 0) << n;
+    }
+}
+
 // Test addition
 TEST(Matrix, Add) {
     MatrixF m1("[4, 54, 3.4, 6.4, 122.3345] 4, 54, 3.4, 6.4, 122.3345 4, 54, 3.4, 6.4, 122.3345");
@@ -58,6 +76,240 @@ TEST(Matrix, Transpose) {
     m1 = MatrixF::identity(10000);
     transpose = m1.transpose();
     EXPECT_EQ(m1, transpose);
+
+    //Shapes that don't divide into tiles, large enough to split across threads.
+    for (auto [width, height] : {std::pair{1000, 77}, std::pair{33, 4000}, std::pair{1, 70000}}) {
+        MatrixD m(width, height);
+        for (size_t i = 0; i < m.size(); ++i) m.data()[i] = (double)i;
+        const MatrixD t = m.transpose();
+        ASSERT_EQ(t.getWidth(), height);
+        bool matches = true;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) matches &= t(y, x) == m(x, y);
+        }
+        EXPECT_TRUE(matches) << width << "x" << height;
+
+        m.transposeInPlace();
+        EXPECT_EQ(m, t);
+    }
+
+    for (int width : {1, 31, 33, 700}) {
+        MatrixF m(width, width);
+        for (size_t i = 0; i < m.size(); ++i) m.data()[i] = (float)i;
+        const MatrixF shared = m;
+        m.transposeInPlace();
+        EXPECT_EQ(m, shared.transpose());
+        m.transposeInPlace();
+        EXPECT_EQ(m, shared);
+    }
+}
+
+TEST(Matrix, ScalarMultiply) {
+    MatrixF m1("[1, 2, 3] 4, 5, 6");
+    MatrixF product("[2, 4, 6] 8, 10, 12");
+    EXPECT_EQ(m1 * 2.f, product);
+
+    //Large enough to be split across threads by the CPU backend.
+    MatrixD identity = MatrixD::identity(1000);
+    MatrixD doubled = identity + identity;
+    EXPECT_EQ(identity * 2.0, doubled);
+    EXPECT_EQ(doubled(10, 10), 2.0);
+    EXPECT_EQ(doubled(10, 11), 0.0);
+}
+
+TEST(Matrix, Copy) {
+    MatrixD m1("[1, 2] 3, 4");
+    MatrixD m2 = m1;
+    m2(0, 0) = 5;
+    EXPECT_EQ(m1(0, 0), 1.0);
+    EXPECT_NE(m1, m2);
+}
+
+TEST(Matrix, CopyOnWrite) {
+    MatrixD m1("[1, 2] 3, 4");
+    MatrixD m2 = m1;
+    const MatrixD& shared = m2;
+    EXPECT_TRUE(m1.isShared());
+    EXPECT_EQ(shared.data(), static_cast<const MatrixD&>(m1).data());
+
+    //Writing gives the written matrix its own entries and leaves the other unshared.
+    m2(1, 1) = 8;
+    EXPECT_FALSE(m1.isShared());
+    EXPECT_FALSE(m2.isShared());
+    EXPECT_NE(shared.data(), static_cast<const MatrixD&>(m1).data());
+    EXPECT_EQ(m1(1, 1), 4.0);
+
+    //Moving takes the entries without copying and leaves the source empty.
+    const double* entries = shared.data();
+    MatrixD m3 = std::move(m2);
+    EXPECT_EQ(static_cast<const MatrixD&>(m3).data(), entries);
+    EXPECT_EQ(m2.size(), 0u);
+    EXPECT_EQ(m2.getWidth(), 0);
+
+    m3 = m1;
+    m1 = m1;
+    EXPECT_TRUE(m1.isShared());
+    m1 = std::move(m3);
+    EXPECT_FALSE(m1.isShared());
+    EXPECT_EQ(m1, MatrixD("[1, 2] 3, 4"));
+}
+
+TEST(Matrix, Parse) {
+    MatrixD m1("[-1.5, +2e3] [3E-2, 4]");
+    EXPECT_EQ(m1.getWidth(), 2);
+    EXPECT_EQ(m1.getHeight(), 2);
+    EXPECT_EQ(m1(0, 0), -1.5);
+    EXPECT_EQ(m1(1, 0), 2000.0);
+    EXPECT_EQ(m1(0, 1), 0.03);
+    EXPECT_EQ(m1, MatrixD("[-1.5, 2000] 0.03, 4]"));
+
+    EXPECT_THROW(MatrixD("[1, 2] 3]"), std::invalid_argument);
+    EXPECT_THROW(MatrixD("[1, , 2]"), std::invalid_argument);
+    EXPECT_THROW(MatrixD("[1, 2x]"), std::invalid_argument);
+    EXPECT_THROW(MatrixD("[1, 2"), std::invalid_argument);
+    EXPECT_THROW(MatrixD("[]"), std::invalid_argument);
+    EXPECT_THROW(MatrixF("[1e99]"), std::invalid_argument);
+    EXPECT_THROW(MatrixD("[+-5, 1] [3, 4]"), std::invalid_argument);
+    EXPECT_THROW(MatrixD("[++5]"), std::invalid_argument);
+    EXPECT_THROW(MatrixD("[1, +]"), std::invalid_argument);
+}
+
+TEST(Matrix, Multiply) {
+    MatrixF m1("[1, 2, 3] 4, 5, 6");
+    MatrixF m2("[7, 8] 9, 10, 11, 12");
+    EXPECT_EQ(m1 * m2, MatrixF("[58, 64] 139, 154"));
+    EXPECT_EQ(m2 * m1, MatrixF("[39, 54, 69] 49, 68, 87, 59, 82, 105"));
+
+    //Matrix-vector product with a column vector.
+    MatrixD vector("[1] 0, -1");
+    EXPECT_EQ(MatrixD("[1, 2, 3] 4, 5, 6") * vector, MatrixD("[-2] -2"));
+    EXPECT_EQ(MatrixD::identity(3) * vector, vector);
+
+    EXPECT_THROW(m1 * m1, std::invalid_argument);
+    EXPECT_THROW(vector * vector, std::invalid_argument);
+
+    //Large and uneven enough to use every block and partial tile of the CPU backend.
+    const int m = 131, k = 300, n = 77;
+    MatrixD a(k, m);
+    MatrixD b(n, k);
+    for (int y = 0; y < m; ++y) for (int x = 0; x < k; ++x) a(x, y) = (x * 7 + y * 3) % 5 - 2;
+    for (int y = 0; y < k; ++y) for (int x = 0; x < n; ++x) b(x, y) = (x * 5 + y * 11) % 7 - 3;
+    MatrixD expected = MatrixD::zero(n, m);
+    for (int y = 0; y < m; ++y) for (int x = 0; x < n; ++x) for (int p = 0; p < k; ++p) expected(x, y) += a(p, y) * b(x, p);
+    MatrixD product = a * b;
+    EXPECT_EQ(product.getWidth(), n);
+    EXPECT_EQ(product.getHeight(), m);
+    EXPECT_EQ(product, expected);
+}
+
+TEST(Matrix, Expression) {
+    MatrixD a("[1, 2] 3, 4");
+    MatrixD b("[10, 20] 30, 40");
+    MatrixD c("[1, 1] 1, 1");
+
+    MatrixExpressionD fused = MatrixExpressionD(a) + b - MatrixExpressionD(c) * 2.0;
+    EXPECT_FALSE(fused.isEvaluated());
+    EXPECT_EQ(fused.matrix(), a + b - c * 2.0);
+    EXPECT_TRUE(fused.isEvaluated());
+    EXPECT_EQ((-(fused - a)).matrix(), MatrixD("[-8, -18] -28, -38"));
+    EXPECT_EQ((MatrixExpressionD(a) - a).matrix(), MatrixD::zero(2, 2));
+
+    EXPECT_THROW(MatrixExpressionD(a) + MatrixD("[1, 2, 3]"), std::invalid_argument);
+
+    //Longer than a single program, so parts are evaluated along the way.
+    MatrixExpressionF sum = MatrixF::zero(300, 300);
+    MatrixF expected = MatrixF::zero(300, 300);
+    for (int i = 0; i < 50; ++i) {
+        MatrixF term = MatrixF::identity(300) * (float)i;
+        sum = sum + (i % 2 ? MatrixExpressionF(term) : -MatrixExpressionF(term) * 0.5f);
+        expected = i % 2 ? expected + term : expected - term * 0.5f;
+    }
+    EXPECT_EQ(sum.matrix(), expected);
+}
+
+TEST(Matrix, Reduce) {
+    MatrixD m("[1, -2] 3, 4");
+    EXPECT_DOUBLE_EQ(m.sum(), 6);
+    EXPECT_DOUBLE_EQ(m.mean(), 1.5);
+    EXPECT_DOUBLE_EQ(m.min(), -2);
+    EXPECT_DOUBLE_EQ(m.max(), 4);
+    EXPECT_DOUBLE_EQ(m.norm1(), 10);
+    EXPECT_DOUBLE_EQ(m.norm2(), std::sqrt(30.0));
+    EXPECT_DOUBLE_EQ(m.dot(m * 2.0), 60);
+    EXPECT_THROW(m.dot(MatrixD("[1, 2, 3, 4]")), std::invalid_argument);
+    EXPECT_DOUBLE_EQ(MatrixD(0, 0).sum(), 0);
+    EXPECT_THROW(MatrixD(0, 0).min(), std::invalid_argument);
+
+    //Large enough to split across threads. Summed one entry at a time, 0.1f drifts by several percent.
+    const int n = 2048;
+    MatrixF tenths(n, n);
+    std::fill(tenths.data(), tenths.data() + tenths.size(), 0.1f);
+    tenths(5, 1000) = -7;
+    tenths(2000, 3) = 9;
+    EXPECT_NEAR(tenths.sum(), 0.1 * n * n - 0.1 * 2 + 2, 0.1 * n * n * 1e-5);
+    EXPECT_EQ(tenths.min(), -7);
+    EXPECT_EQ(tenths.max(), 9);
+    EXPECT_NEAR(tenths.dot(MatrixF::identity(n)), 0.1 * n, 1e-3);
+}
+
+TEST(Matrix, View) {
+    MatrixD m("[1, 2, 3] 4, 5, 6, 7, 8, 9");
+    EXPECT_EQ(m.row(1).matrix(), MatrixD("[4, 5, 6]"));
+    EXPECT_EQ(m.column(2).matrix(), MatrixD("[3] 6, 9"));
+    MatrixViewD block = m.block(1, 1, 2, 2);
+    EXPECT_EQ(block.matrix(), MatrixD("[5, 6] 8, 9"));
+    EXPECT_EQ(block.column(0).matrix(), MatrixD("[5] 8"));
+    EXPECT_DOUBLE_EQ(block.sum(), 28);
+    EXPECT_DOUBLE_EQ(block.dot(m.block(0, 0, 2, 2)), 5 + 12 + 32 + 45);
+    EXPECT_THROW(m.block(2, 0, 2, 1), std::invalid_argument);
+    EXPECT_EQ((MatrixExpressionD(block) * 2.0 - m.block(0, 0, 2, 2)).matrix(), MatrixD("[9, 10] 12, 13"));
+
+    //A view keeps the entries it was taken from, and assigning a matrix's own block to it reads the old entries.
+    MatrixD copy = m;
+    m.assign(0, 1, m.block(0, 0, 3, 2));
+    EXPECT_EQ(m, MatrixD("[1, 2, 3] 1, 2, 3, 4, 5, 6"));
+    EXPECT_EQ(block.matrix(), MatrixD("[5, 6] 8, 9"));
+    EXPECT_EQ(copy, MatrixD("[1, 2, 3] 4, 5, 6, 7, 8, 9"));
+    EXPECT_THROW(m.assign(2, 0, block), std::invalid_argument);
+
+    //Large enough that strided reductions and expressions split across threads.
+    const int n = 1024;
+    MatrixF large(n, n);
+    for (int y = 0; y < n; ++y) for (int x = 0; x < n; ++x) large(x, y) = (float)((x * 7 + y * 3) % 11);
+    MatrixViewF inner = large.block(3, 5, n - 10, n - 20);
+    MatrixF innerCopy = inner.matrix();
+    EXPECT_EQ(inner.sum(), innerCopy.sum());
+    EXPECT_EQ(inner.max(), innerCopy.max());
+    EXPECT_EQ(inner.norm1(), innerCopy.norm1());
+    EXPECT_EQ((MatrixExpressionF(inner) + innerCopy).matrix(), innerCopy * 2.0f);
+}
+
+TEST(Matrix, File) {
+    const std::string path = testing::TempDir() + "titan_matrix_file.ttm";
+    MatrixF m("[1, 2, 3] 4, 5, 6, 7, 8, 9");
+
+    //Streamed in pieces, so the height is only known once the writer is closed.
+    MatrixWriter<float> writer;
+    ASSERT_TRUE(writer.open(path, 2));
+    ASSERT_TRUE(writer.write(m.block(1, 0, 2, 2)));
+    const float row[] = {-1, -2};
+    ASSERT_TRUE(writer.write(row, 1));
+    EXPECT_FALSE(writer.write(m.row(0)));
+    ASSERT_TRUE(writer.close());
+
+    MatrixF loaded = MatrixFile::load<float>(path);
+    EXPECT_EQ(loaded, MatrixF("[2, 3] 5, 6, -1, -2"));
+    //Writing to a loaded matrix leaves the file as it was.
+    loaded(0, 0) = 100;
+    EXPECT_EQ(MatrixFile::load<float>(path), MatrixF("[2, 3] 5, 6, -1, -2"));
+    EXPECT_THROW(MatrixFile::load<double>(path), std::invalid_argument);
+
+    ASSERT_TRUE(MatrixWriter<double>::save(MatrixD::identity(300), path));
+    EXPECT_EQ(MatrixFile::load<double>(path), MatrixD::identity(300));
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "TTNM";
+    EXPECT_THROW(MatrixFile::load<double>(path), std::invalid_argument);
+    EXPECT_THROW(MatrixFile::load<double>(path + ".missing"), std::invalid_argument);
+    std::remove(path.c_str());
 }
 
 #endif //TITANPLUSPLUS_MATRIXTESTING_H
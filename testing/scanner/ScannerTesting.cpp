@@ -0,0 +1,5 @@
+//
+// Created by Bryn McKerracher on 17/10/2026.
+//
+
+#include "ScannerTesting.h"
@@ -0,0 +1,136 @@
+//
+// Created by Bryn McKerracher on 17/10/2026.
+//
+
+#ifndef TITANPLUSPLUS_SCANNERTESTING_H
+#define TITANPLUSPLUS_SCANNERTESTING_H
+
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../../Scanner.h"
+#include "../../ScanSimd.h"
+
+///Longest run tested, long enough to put a boundary at every offset in two AVX2 blocks after the Scanner's short run.
+const size_t MaxRunLength = 80;
+
+/**
+ * @brief Returns every level this build and CPU can scan at, scalar first.
+ */
+inline std::vector<ScanSimd::Level> supportedLevels() {
+    std::vector<ScanSimd::Level> levels;
+    for (ScanSimd::Level level : {ScanSimd::Level::Scalar, ScanSimd::Level::SSE2, ScanSimd::Level::AVX2}) {
+        if (ScanSimd::supported(level)) levels.push_back(level);
+    }
+    return levels;
+}
+
+/**
+ * @brief Restores the active level when a test ends.
+ */
+struct LevelGuard {
+    ScanSimd::Level saved = ScanSimd::level();
+    ~LevelGuard() { ScanSimd::setLevel(saved); }
+};
+
+/**
+ * @brief Returns characters that continue a run of the given kind, cycling through the kind's classes.
+ * @param kind The run: 'w' whitespace, 'i' identifier, 'd' digits or 'f' anything but ']'.
+ * @param length The number of characters to return.
+ */
+inline std::string runOf(char kind, size_t length) {
+    const std::string_view alphabet = kind == 'w' ? " \t\r\n \n"
+                                    : kind == 'i' ? "aZ_9qB0z"
+                                    : kind == 'd' ? "0123456789"
+                                    : "a \n[!/9\t\"";
+    std::string run;
+    for (size_t i = 0; i < length; ++i) run += alphabet[i % alphabet.size()];
+    return run;
+}
+
+/**
+ * @brief Returns every token in the source as (type, start, length, line), up to and including the end of the file.
+ */
+inline std::vector<std::tuple<int, size_t, size_t, int>> scanAll(std::string_view source) {
+    Scanner scanner;
+    scanner.init(source);
+    std::vector<std::tuple<int, size_t, size_t, int>> tokens;
+    //Bounded in case a scanner bug stops it reaching the end of the file.
+    for (size_t i = 0; i <= source.size() + 1; ++i) {
+        const Token token = scanner.scanToken();
+        tokens.emplace_back(token.type, token.start, token.length, token.line);
+        if (token.type == Token::Type::END_OF_FILE) break;
+    }
+    return tokens;
+}
+
+//Each skip routine stops at the same index and counts the same lines at every level, for a run ending at each offset
+//of a block and for one running to the end of the buffer.
+TEST(ScanSimd, Runs) {
+    LevelGuard guard;
+    for (size_t length = 0; length <= MaxRunLength; ++length) {
+        for (char kind : {'w', 'i', 'd', 'f'}) {
+            const std::string run = runOf(kind, length);
+            //Padding after the terminator lets the vector loops, which only load whole blocks, reach it.
+            const std::string terminated = run + std::string(33, kind == 'f' ? ']' : '+');
+            for (const std::string& source : {terminated, run}) {
+                std::vector<std::pair<size_t, int>> results;
+                for (ScanSimd::Level level : supportedLevels()) {
+                    ASSERT_TRUE(ScanSimd::setLevel(level));
+                    int lines = 0;
+                    size_t end = 0;
+                    switch (kind) {
+                        case 'w': end = ScanSimd::skipWhitespace(source, 0, lines); break;
+                        case 'i': end = ScanSimd::skipIdentifier(source, 0); break;
+                        case 'd': end = ScanSimd::skipDigits(source, 0); break;
+                        default:  end = ScanSimd::find(source, 0, ']', lines); break;
+                    }
+                    results.emplace_back(end, lines);
+                }
+                for (const auto& result : results) {
+                    EXPECT_EQ(result, results.front()) << "kind " << kind << ", length " << source.size();
+                }
+                EXPECT_EQ(results.front().first, run.size()) << "kind " << kind << ", length " << source.size();
+            }
+        }
+    }
+}
+
+//The Scanner produces identical tokens at every level, with runs of each kind ending at each offset of a block and
+//sources that end mid-run without a trailing newline.
+TEST(ScanSimd, Tokens) {
+    LevelGuard guard;
+    std::vector<std::string> sources;
+    for (size_t length = 0; length <= MaxRunLength; ++length) {
+        const std::string name = "v" + runOf('i', length);
+        const std::string digits = "1" + runOf('d', length);
+        std::string text = runOf('f', length);
+        std::erase(text, '"');
+        const std::string elements = runOf('f', length);
+
+        sources.push_back("print a;\n" + runOf('w', length) + "print b;");
+        sources.push_back("var " + name + " = " + digits + ";\nprint " + name);
+        sources.push_back("print " + digits + "." + digits + " + " + digits);
+        sources.push_back("print 1; //" + text + "\nprint 2; //" + text);
+        sources.push_back("print \"" + text + "\";\nprint \"" + text + "\"");
+        sources.push_back("print \"" + text);
+        sources.push_back("var m = [[" + elements + "] [1]];\nprint [[" + elements + "]]");
+        sources.push_back("print [[" + elements);
+    }
+
+    for (const std::string& source : sources) {
+        std::vector<std::vector<std::tuple<int, size_t, size_t, int>>> results;
+        for (ScanSimd::Level level : supportedLevels()) {
+            ASSERT_TRUE(ScanSimd::setLevel(level));
+            results.push_back(scanAll(source));
+        }
+        for (const auto& tokens : results) {
+            EXPECT_EQ(tokens, results.front()) << source;
+        }
+        EXPECT_EQ(std::get<0>(results.front().back()), Token::Type::END_OF_FILE) << source;
+    }
+}
+
+#endif //TITANPLUSPLUS_SCANNERTESTING_H
@@ -0,0 +1,338 @@
+//
+// Created by Bryn McKerracher on 16/10/2026.
+//
+
+/**
+ * @file Benchmark.cpp
+ * @brief Times the scanner, compiler, VM and matrix hot paths.
+ *
+ * Usage: TitanBenchmark [--min-time <seconds>] [filter]
+ *
+ * Each benchmark is repeated until it has run for at least the minimum time, then
+ * reports the mean time and host heap bytes allocated per operation. What counts as
+ * one operation is given in brackets after each benchmark's name. Only benchmarks
+ * whose names contain the filter are run.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <utility>
+#include "../../Compiler.h"
+#include "../../Jit.h"
+#include "../../Matrix.h"
+#include "../../MatrixBackend.h"
+#include "../../MatrixExpression.h"
+#include "../../MatrixFile.h"
+#include "../../RegisterGenerator.h"
+#include "../../Scanner.h"
+#include "../../ScanSimd.h"
+#include "../../VM.h"
+
+namespace {
+std::atomic<size_t> bytesAllocated{0}; ///< Total bytes requested from operator new since startup.
+
+/**
+ * @brief Stops the optimiser from discarding a value that is otherwise unused.
+ */
+template <typename T>
+void keep(const T& value) {
+#ifdef __GNUC__
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+#endif //__GNUC__
+}
+
+/**
+ * @brief Runs and reports benchmarks whose names match a filter.
+ */
+class Runner {
+public:
+    Runner(double minTime, std::string filter) : minTime(minTime), filter(std::move(filter)) {}
+
+    /**
+     * Runs body once to warm up, then doubles the number of iterations until a
+     * timed run takes at least minTime seconds.
+     *
+     * @brief Times one benchmark and prints its results.
+     * @param name The benchmark's name.
+     * @param opsPerIteration The number of operations a single call of body performs.
+     * @param body The code to time.
+     */
+    void run(const std::string& name, size_t opsPerIteration, const std::function<void()>& body) {
+        if (name.find(filter) == std::string::npos) return;
+        body();
+
+        for (size_t iterations = 1;; iterations *= 2) {
+            const size_t bytesBefore = bytesAllocated.load(std::memory_order_relaxed);
+            const auto begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; ++i) {
+                body();
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+            const size_t bytes = bytesAllocated.load(std::memory_order_relaxed) - bytesBefore;
+
+            if (elapsed.count() >= minTime) {
+                const double ops = (double)iterations * (double)opsPerIteration;
+                std::cout << std::left << std::setw(40) << name << std::right
+                          << std::setw(12) << iterations
+                          << std::setw(14) << std::fixed << std::setprecision(2) << elapsed.count() * 1e9 / ops
+                          << std::setw(14) << std::setprecision(1) << (double)bytes / ops << "\n";
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Prints the column headings.
+     */
+    static void printHeader() {
+        std::cout << std::left << std::setw(40) << "Benchmark" << std::right
+                  << std::setw(12) << "Iterations" << std::setw(14) << "ns/op" << std::setw(14) << "bytes/op" << "\n";
+    }
+
+private:
+    double minTime;     ///< Minimum seconds each benchmark is timed for.
+    std::string filter; ///< Substring that benchmark names must contain to run.
+};
+
+/**
+ * @brief Repeats a Titan statement to build a script with the given number of lines.
+ */
+std::string repeat(const std::string& statement, size_t lines) {
+    std::string script;
+    script.reserve((statement.size() + 1) * lines);
+    for (size_t i = 0; i < lines; ++i) {
+        script += statement;
+        script += '\n';
+    }
+    return script;
+}
+
+/**
+ * @brief Returns the number of instructions in a batch, which is the number it executes since Titan has no jumps.
+ */
+size_t countInstructions(const Batch& batch) {
+    size_t instructions = 0;
+    for (size_t index = 0; index < batch.opcodes.size(); index += Op::instructionLength(batch.opcodes[index])) {
+        ++instructions;
+    }
+    return instructions;
+}
+
+const size_t ScriptLines = 1000; ///< Number of statements in each generated script.
+
+const std::string Prelude = "var a = 1.5; var b = 2; var s = \"titan\"; var t = \"plus\";\n"; ///< Globals used by the VM workloads.
+
+/**
+ * @brief Scripts for the scanner, compiler and VM benchmarks.
+ */
+struct Workload {
+    std::string name;   ///< Short name of the workload.
+    std::string script; ///< The Titan source of the workload.
+};
+
+const Workload Workloads[] = {
+    {"arithmetic", Prelude + repeat("a * b + a - b / a * b - a;", ScriptLines)},
+    {"global",     Prelude + repeat("var c = a; var d = c; var e = d;", ScriptLines)},
+    {"local",      Prelude + repeat("{ var c = a; var d = c; var e = d; }", ScriptLines)},
+    {"string",     Prelude + repeat("s + t == t + s;", ScriptLines)},
+    {"literal",    Prelude + repeat("var m = [[1.5, 2.25, 3.125, 4] 5.5, 6.75, 7, 8]]; // A row of sample data.", ScriptLines)},
+};
+
+void scannerBenchmarks(Runner& runner) {
+    const std::pair<ScanSimd::Level, std::string> levels[] = {
+        {ScanSimd::Level::Scalar, "scalar"}, {ScanSimd::Level::SSE2, "sse2"}, {ScanSimd::Level::AVX2, "avx2"},
+    };
+    const ScanSimd::Level defaultLevel = ScanSimd::level();
+
+    for (const auto& [level, levelName] : levels) {
+        if (!ScanSimd::setLevel(level)) continue;
+        for (const auto& workload : Workloads) {
+            runner.run("scanner-" + levelName + "/" + workload.name + " (byte)", workload.script.size(), [&] {
+                Scanner scanner;
+                scanner.init(workload.script);
+                for (Token token = scanner.scanToken(); token.type != Token::Type::END_OF_FILE; token = scanner.scanToken()) {
+                    keep(token);
+                }
+            });
+        }
+    }
+    ScanSimd::setLevel(defaultLevel);
+}
+
+void compilerBenchmarks(Runner& runner) {
+    for (const auto& workload : Workloads) {
+        runner.run("compiler/" + workload.name + " (line)", ScriptLines, [&] {
+            Globals globals;
+            Strings strings;
+            Batch batch;
+            Compiler compiler;
+            keep(compiler.compile(workload.script, batch, globals, strings));
+        });
+    }
+}
+
+void vmBenchmarks(Runner& runner) {
+    for (const auto& workload : Workloads) {
+        VM vm;
+        Batch batch;
+        if (!vm.compile(workload.script, batch)) {
+            std::cerr << "Failed to compile the " << workload.name << " workload.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        runner.run("vm/" + workload.name + " (instruction)", countInstructions(batch), [&] {
+            keep(vm.interpret(batch));
+        });
+
+        //Timed per stack instruction too, so the two machines' ns/op compare the same script.
+        RegisterBatch registers;
+        RegisterGenerator::generate(batch, registers);
+        runner.run("vm-reg/" + workload.name + " (stack instruction)", countInstructions(batch), [&] {
+            keep(vm.interpret(batch, registers));
+        });
+
+        NativeBatch native;
+        if (Jit::compile(batch, native)) {
+            runner.run("vm-jit/" + workload.name + " (stack instruction)", countInstructions(batch), [&] {
+                keep(vm.interpret(batch, native));
+            });
+        }
+    }
+}
+
+template <typename T>
+void matrixBenchmarks(Runner& runner, const std::string& type) {
+    for (int n : {64, 256, 1024}) {
+        const std::string size = std::to_string(n) + "x" + std::to_string(n);
+        const Matrix<T> a = Matrix<T>::identity(n);
+        const Matrix<T> b = a * (T)2;
+        const size_t elements = (size_t)n * n;
+
+        runner.run("matrix" + type + "/add/" + size + " (element)", elements, [&] { keep(a + b); });
+        runner.run("matrix" + type + "/subtract/" + size + " (element)", elements, [&] { keep(a - b); });
+        runner.run("matrix" + type + "/scalar/" + size + " (element)", elements, [&] { keep(a * (T)3); });
+        runner.run("matrix" + type + "/equal/" + size + " (element)", elements, [&] { keep(a == b); });
+        runner.run("matrix" + type + "/transpose/" + size + " (element)", elements, [&] { keep(b.transpose()); });
+        Matrix<T> square = b * (T)1;
+        runner.run("matrix" + type + "/transpose-in-place/" + size + " (element)", elements, [&] {
+            square.transposeInPlace();
+            keep(square);
+        });
+        runner.run("matrix" + type + "/identity/" + size + " (element)", elements, [&] { keep(Matrix<T>::identity(n)); });
+        runner.run("matrix" + type + "/share/" + size + " (element)", elements, [&] { keep(Matrix<T>(a)); });
+        //Copies share entries until they are written to, so take a writable pointer to force the copy.
+        runner.run("matrix" + type + "/copy/" + size + " (element)", elements, [&] {
+            Matrix<T> copy(a);
+            keep(copy.data());
+        });
+        //The same expression as separate operations, then fused into one pass.
+        runner.run("matrix" + type + "/eager/" + size + " (element)", elements, [&] { keep(a + b - a * (T)2); });
+        runner.run("matrix" + type + "/fused/" + size + " (element)", elements, [&] {
+            keep((MatrixExpression<T>(a) + b - MatrixExpression<T>(a) * (T)2).matrix());
+        });
+        runner.run("matrix" + type + "/sum/" + size + " (element)", elements, [&] { keep(b.sum()); });
+        runner.run("matrix" + type + "/max/" + size + " (element)", elements, [&] { keep(b.max()); });
+        runner.run("matrix" + type + "/norm2/" + size + " (element)", elements, [&] { keep(b.norm2()); });
+        runner.run("matrix" + type + "/dot/" + size + " (element)", elements, [&] { keep(a.dot(b)); });
+        //The inner block, read in place through a view rather than copied out first.
+        const size_t inner = (size_t)(n - 2) * (n - 2);
+        runner.run("matrix" + type + "/block-sum/" + size + " (element)", inner, [&] { keep(b.block(1, 1, n - 2, n - 2).sum()); });
+        runner.run("matrix" + type + "/block-copy/" + size + " (element)", inner, [&] { keep(b.block(1, 1, n - 2, n - 2).matrix()); });
+    }
+
+    //Products are timed per multiply-add, so ns/op is comparable across sizes.
+    for (int n : {64, 256, 1024}) {
+        const std::string size = std::to_string(n) + "x" + std::to_string(n);
+        Matrix<T> a(n, n);
+        for (size_t i = 0; i < a.size(); ++i) a.data()[i] = (T)(i % 7) - 3;
+        Matrix<T> vector(1, n);
+        for (size_t i = 0; i < vector.size(); ++i) vector.data()[i] = (T)(i % 5) - 2;
+        runner.run("matrix" + type + "/multiply/" + size + " (multiply-add)", (size_t)n * n * n, [&] { keep(a * a); });
+        runner.run("matrix" + type + "/multiply-vector/" + size + " (multiply-add)", (size_t)n * n, [&] { keep(a * vector); });
+    }
+
+    //Matrix literals are parsed from their source text by the compiler.
+    std::string literal = "[";
+    for (int y = 0; y < 64; ++y) {
+        for (int x = 0; x < 64; ++x) {
+            literal += std::to_string(x + y * 64) + (x < 63 ? ", " : "");
+        }
+        literal += y < 63 ? "] " : "]";
+    }
+    runner.run("matrix" + type + "/parse/64x64 (element)", 64 * 64, [&] { keep(Matrix<T>(literal)); });
+
+    //Matrix files are memory-mapped instead, summed so every page is read.
+    for (int n : {64, 1024}) {
+        const std::string size = std::to_string(n) + "x" + std::to_string(n);
+        const std::string path = "titan_benchmark" + type + ".ttm";
+        MatrixWriter<T>::save(Matrix<T>::identity(n), path);
+        runner.run("matrix" + type + "/load/" + size + " (element)", (size_t)n * n, [&] { keep(MatrixFile::load<T>(path).sum()); });
+        std::remove(path.c_str());
+    }
+}
+}
+
+void* operator new(size_t size) {
+    bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+    const size_t align = (size_t)alignment;
+    //aligned_alloc requires a non-zero size that is a multiple of the alignment.
+    const size_t rounded = size ? (size + align - 1) / align * align : align;
+    if (void* memory = std::aligned_alloc(align, rounded)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+int main(int argc, char* argv[]) {
+    double minTime = 0.25;
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            minTime = std::atof(argv[++i]);
+        }
+        else {
+            filter = argv[i];
+        }
+    }
+
+    std::cout << "Matrix device: " << (MatrixBackend::device() == MatrixBackend::Device::CUDA ? "CUDA" : "CPU")
+              << " (bytes/op counts host heap allocations only)\n\n";
+    Runner runner(minTime, filter);
+    Runner::printHeader();
+    scannerBenchmarks(runner);
+    compilerBenchmarks(runner);
+    vmBenchmarks(runner);
+    matrixBenchmarks<float>(runner, "F");
+    matrixBenchmarks<double>(runner, "D");
+    return EXIT_SUCCESS;
+}
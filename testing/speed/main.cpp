@@ -3,6 +3,6 @@
 
 int main() {
     MatrixD matrix = MatrixD::identity(20000);
-    auto m2 = matrix.transpose();
+    matrix.transposeInPlace();
     return 0;
 }
@@ -0,0 +1,44 @@
+//
+// Created by Bryn McKerracher on 17/10/2026.
+//
+
+#ifndef TITANPLUSPLUS_VALUETESTING_H
+#define TITANPLUSPLUS_VALUETESTING_H
+
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <gtest/gtest.h>
+#include "../../Value.h"
+#include "../ScriptTesting.h"
+
+TEST(Value, NaNRoundTrip) {
+    for (uint64_t bits : AdversarialNaNs) {
+        const Value value = Value::fromNumber(std::bit_cast<double>(bits));
+        EXPECT_TRUE(value.isNumber()) << std::hex << bits;
+        EXPECT_FALSE(value.isObject()) << std::hex << bits;
+        EXPECT_FALSE(value.isUndefined()) << std::hex << bits;
+        EXPECT_EQ(value.type(), Value::Type::NUMBER) << std::hex << bits;
+        EXPECT_TRUE(std::isnan(value.toType<double>())) << std::hex << bits;
+        EXPECT_FALSE(value == Value::fromBool(true)) << std::hex << bits;
+    }
+
+    //Numbers that aren't NaN keep their exact bits.
+    for (double number : {0.0, -0.0, 1.5, -HUGE_VAL, HUGE_VAL, 5e-324}) {
+        EXPECT_EQ(Value::fromNumber(number).bits, std::bit_cast<uint64_t>(number));
+    }
+}
+
+TEST(Value, NaNFromMatrixFile) {
+    const std::string path = testing::TempDir() + "titan_value_nans.ttm";
+    const ScriptResult result = runScript(adversarialNaNScript(path));
+    EXPECT_EQ(result.result, VM::InterpretResult::OK) << result.output;
+
+    std::string expected;
+    for (size_t i = 0; i < std::size(AdversarialNaNs); ++i) expected += AdversarialNaNOutput;
+    EXPECT_EQ(result.output, expected);
+    std::remove(path.c_str());
+}
+
+#endif //TITANPLUSPLUS_VALUETESTING_H
@@ -0,0 +1,93 @@
+//
+// Created by Bryn McKerracher on 17/10/2026.
+//
+
+#ifndef TITANPLUSPLUS_JITTESTING_H
+#define TITANPLUSPLUS_JITTESTING_H
+
+#include <cstdio>
+#include <string>
+#include <gtest/gtest.h>
+#include "../ScriptTesting.h"
+
+///Globals defined before the scripts below are compiled, which native code speculates are numbers.
+const char* const JitPrelude = "var n = 4; var s = \"str\"; var m = [[1, 2] [3, 4]]; var t = true; var u = nil;";
+
+TEST(Jit, Numbers) {
+    if (!Jit::isAvailable()) GTEST_SKIP() << "The JIT isn't available on this platform.";
+    for (const char* script : {
+        "var a = 1.5; var b = 2; print a * b + a - b / a * b - a; print -a; print !a;",
+        "var a = 2; var b = 3; print a < b; print a <= b; print a > b; print a >= b; print a == b; print a != b; print a == 2;",
+        "var z = 0; var q = z / z; print q == q; print q != q; print q < 1; print -q;",
+        "var z = 0; var q = z / z; print q; print q * 1; print q + 1; print -q; print -(-q); { var l = z / z; print l; print l - 1; print -l; }",
+        "var c = 1 + 0.5; c = c * 2; c = c - 1; print c; print !(c < 2); print !nil; print true == !false;",
+        "{ var x = 1; var y = x * 2; x = y - 1; print x; { var x = 5; print x * y; } print x + y; print x + (x = 2); print x; }",
+    }) {
+        expectSameAsStack(script, Engine::Native);
+    }
+}
+
+//A global the batch didn't define is speculated to be a number, and the rest of the batch falls back to the stack machine when it isn't.
+TEST(Jit, GlobalDespeculation) {
+    if (!Jit::isAvailable()) GTEST_SKIP() << "The JIT isn't available on this platform.";
+    for (const char* script : {
+        "print n * n + 1; print s; print n;",
+        "var a = 2; { var l = 3; print l * a; print s + \"!\"; print l + a; } print a;",
+        "print n * 2 == s; print n;",
+        "{ var l = n; print l - 1; print m * l; print l; }",
+        "print t; print !t; print u == nil; print n + 1;",
+        "s = 5; print s + 1; n = \"now a string\"; print n;",
+        "var k = n; k = k + s; print k;",
+    }) {
+        expectSameAsStack(script, Engine::Native, JitPrelude);
+    }
+}
+
+//Strings, matrices, subscripts and builtins call into the runtime from native code.
+TEST(Jit, SlowPaths) {
+    if (!Jit::isAvailable()) GTEST_SKIP() << "The JIT isn't available on this platform.";
+    for (const char* script : {
+        "var s = \"ti\"; print s + \"tan\"; print s == \"ti\"; print s != \"ti\"; print !s; var c = s; s = 1; print c;",
+        "{ var m = [[1, 2] [3, 4]]; var n = m; m[0, 0] = 9; print m; print n; print m[0:1, :]; print sum(m); print -m; }",
+        "var g = [[1, 2, 3] [4, 5, 6]]; g[1, 0:2] = 7; print g; print g[:, 1]; print dot(g, g); print g * 2 - g; print g == g;",
+        "{ var p = 1; var q = \"s\"; p = q; print p; var r = p; print r; q = p + q; print q; }",
+        "var a = [[1, 2] [3, 4]]; var b = a * a; print b; print norm2(a - b); print max(a) + min(b);",
+    }) {
+        expectSameAsStack(script, Engine::Native);
+    }
+}
+
+TEST(Jit, RuntimeErrors) {
+    if (!Jit::isAvailable()) GTEST_SKIP() << "The JIT isn't available on this platform.";
+    for (const char* script : {
+        "print 1;\nprint 1 + \"a\";\nprint 2;",
+        "var a = 1;\nprint -\"s\";",
+        "print 1;\nprint zz;",
+        "var m = [[1, 2]];\nprint m[5, 5];",
+        "{ var l = \"s\";\nprint l * 2; }",
+        "var a = 1 < 2;\nprint a - 1;",
+    }) {
+        expectSameAsStack(script, Engine::Native);
+    }
+    //Errors raised by the stack machine after native code has handed the batch over to it.
+    for (const char* script : {
+        "print n;\nprint s - 1;",
+        "print n + 1;\nprint s;\nprint m < 1;",
+    }) {
+        expectSameAsStack(script, Engine::Native, JitPrelude);
+    }
+}
+
+//NaNs read from a matrix are numbers to native code's inline type checks, as they are to Value.
+TEST(Jit, AdversarialNaNs) {
+    if (!Jit::isAvailable()) GTEST_SKIP() << "The JIT isn't available on this platform.";
+    const std::string path = testing::TempDir() + "titan_jit_nans.ttm";
+    const std::string script = adversarialNaNScript(path) + "print -x5; print x5 * x0 - 2; print !x3;\n";
+    const ScriptResult result = runScript(script, Engine::Native);
+    EXPECT_EQ(result.result, VM::InterpretResult::OK) << result.output;
+    EXPECT_EQ(result.output.substr(0, AdversarialNaNOutput.size()), AdversarialNaNOutput);
+    expectSameAsStack(script, Engine::Native);
+    std::remove(path.c_str());
+}
+
+#endif //TITANPLUSPLUS_JITTESTING_H
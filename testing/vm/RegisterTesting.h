@@ -0,0 +1,73 @@
+//
+// Created by Bryn McKerracher on 17/10/2026.
+//
+
+#ifndef TITANPLUSPLUS_REGISTERTESTING_H
+#define TITANPLUSPLUS_REGISTERTESTING_H
+
+#include <string>
+#include <gtest/gtest.h>
+#include "../ScriptTesting.h"
+
+TEST(Registers, Numbers) {
+    for (const char* script : {
+        "var a = 1.5; var b = 2; print a * b + a - b / a * b - a; print -a; print !a;",
+        "var a = 2; var b = 3; print a < b; print a <= b; print a > b; print a >= b; print a == b; print a != b; print a == 2;",
+        "var c = 1 + 0.5; c = c * 2; c = c - 1; print c; print !(c < 2); print !nil; print true == !false;",
+    }) {
+        expectSameAsStack(script, Engine::Registers);
+    }
+}
+
+//Constants and locals are used as RK operands in place, rather than loaded into registers first.
+TEST(Registers, Operands) {
+    for (const char* script : {
+        "var g = 3; print g * 2 + 1; print 10 - g; print g / 4; print \"a\" + \"b\"; print nil == nil;",
+        "{ var x = 2; var y = x * 3; print y + x; x = y; print x - 1; print x == y; print -x; print !y; }",
+        "{ var a = 1; var b = a; a = 5; print b; print a; print a + (a = 2); print a; }",
+        "{ var a = 1; var b = a; var c = b; b = 3; print a; print b; print c; a = c + b; print a; }",
+        "{ var q = 1; { var q = 2; print q; } print q; var r = q; print r; }",
+        "{ var m = [[1, 2] [3, 4]]; var n = m; m[0, 0] = 9; print m; print n; print m[0:1, :]; print sum(m); }",
+        "var g = [[1, 2, 3] [4, 5, 6]]; g[1, 0:2] = 7; print g; print g[:, 1]; print dot(g, g); print g * 2 - g;",
+        "var s = \"str\"; { var l = s; s = 1; print l; print s; }",
+    }) {
+        expectSameAsStack(script, Engine::Registers);
+    }
+}
+
+//Constants and globals past the reach of short operands use LoadConstant32 and the 32-bit global instructions.
+TEST(Registers, WideOperands) {
+    std::string script;
+    for (int i = 0; i < 70000; ++i) script += "var v" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+    script += "print v69999 + 0.5; v69998 = v69997 * 2; print v69998; var w = [[1, 2]]; w[0, 1] = 69999.5; print w;\n";
+    script += "{ var l = v69999; print l - 69999.25; }\n";
+    expectSameAsStack(script, Engine::Registers);
+}
+
+TEST(Registers, RuntimeErrors) {
+    for (const char* script : {
+        "print 1;\nprint 1 + \"a\";\nprint 2;",
+        "var a = 1;\nprint -\"s\";",
+        "print 1;\nprint zz;",
+        "var m = [[1, 2]];\nprint m[5, 5];",
+        "{ var l = \"s\";\nprint l * 2; }",
+    }) {
+        expectSameAsStack(script, Engine::Registers);
+    }
+}
+
+//A frame needs more registers than an RK operand can address.
+TEST(Registers, TooManyValues) {
+    std::string script = "{\n";
+    for (size_t i = 0; i <= RegisterOp::MaxRegisters; ++i) script += "var l" + std::to_string(i) + " = 0;\n";
+    //Reading the last local keeps the optimiser from dropping its push and pop.
+    script += "print l" + std::to_string(RegisterOp::MaxRegisters) + ";\n}\n";
+
+    VM vm;
+    Batch batch;
+    ASSERT_TRUE(vm.compile(script, batch));
+    RegisterBatch registers;
+    EXPECT_FALSE(RegisterGenerator::generate(batch, registers));
+}
+
+#endif //TITANPLUSPLUS_REGISTERTESTING_H
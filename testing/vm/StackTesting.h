@@ -0,0 +1,102 @@
+//
+// Created by Bryn McKerracher on 17/10/2026.
+//
+
+#ifndef TITANPLUSPLUS_STACKTESTING_H
+#define TITANPLUSPLUS_STACKTESTING_H
+
+#include <string>
+#include <string_view>
+#include <gtest/gtest.h>
+#include "../ScriptTesting.h"
+
+///The number of values the VM's stack holds, VM::MaxStackSize.
+const size_t StackSize = 4096;
+
+/**
+ * Optimisation can't fold the additions of a global, so each level holds one more value on the stack.
+ *
+ * @brief Returns a script printing a + (a + (... a)) nested the given number of levels deep.
+ */
+inline std::string nestedSum(size_t depth) {
+    std::string script = "var a = 1; print ";
+    for (size_t i = 0; i < depth; ++i) script += "a + (";
+    script += "a";
+    script += std::string(depth, ')');
+    return script + ";";
+}
+
+//Batches deeper than the VM's stack are rejected before they run, on every engine.
+TEST(Stack, Overflow) {
+    Batch batch;
+    VM vm;
+    ASSERT_TRUE(vm.compile(nestedSum(StackSize - 1), batch));
+    EXPECT_EQ(batch.maxStackDepth, StackSize);
+
+    for (Engine engine : {Engine::Stack, Engine::Registers, Engine::Native}) {
+        if (engine == Engine::Native && !Jit::isAvailable()) continue;
+        const ScriptResult fits = runScript(nestedSum(StackSize - 1), engine);
+        EXPECT_EQ(fits.result, VM::InterpretResult::OK) << fits.output;
+        EXPECT_EQ(fits.output, std::to_string(StackSize) + ".000000\n");
+
+        for (size_t depth : {StackSize, (size_t)5000}) {
+            const ScriptResult overflow = runScript(nestedSum(depth), engine);
+            EXPECT_EQ(overflow.result, VM::InterpretResult::RUNTIME_ERROR) << depth;
+            EXPECT_EQ(overflow.output, "Stack overflow.\n") << depth;
+            EXPECT_EQ(overflow.errors, "[Line 0] in script\n") << depth;
+        }
+    }
+}
+
+/**
+ * @brief Runs a script on the stack machine of a fresh VM with tracing and disassembly set as given, returning what it prints.
+ */
+inline std::string runDebugged(std::string_view source, bool tracing, bool disassembling) {
+    VM vm;
+    vm.setTracing(tracing);
+    vm.setDisassembling(disassembling);
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(vm.interpret(source), VM::InterpretResult::OK) << source;
+    return testing::internal::GetCapturedStdout();
+}
+
+//The traced loop prints the stack and each instruction before running it, the default loop only what the script prints.
+TEST(Stack, Tracing) {
+    const char* script = "var a = 2; print a * 3;";
+    EXPECT_EQ(runDebugged(script, false, false), "6.000000\n");
+    EXPECT_EQ(runDebugged(script, true, false),
+              "0\t0 OP_CONSTANT\t0 2.000000\n"
+              "\t\t[2.000000]\n"
+              "2\t| OP_DEFINE_GLOBAL\tslot 0\n"
+              "4\t| OP_GET_GLOBAL\tslot 0\n"
+              "\t\t[2.000000]\n"
+              "6\t| OP_MULTIPLY_CONSTANT\t1 3.000000\n"
+              "\t\t[6.000000]\n"
+              "8\t| OP_PRINT\t\n"
+              "6.000000\n"
+              "9\t| OP_RETURN\t\n");
+    EXPECT_EQ(runDebugged(script, false, true),
+              "== Batch Disassembly ==\n"
+              "[Constants]:\n"
+              "'2.000000'\n"
+              "'3.000000'\n"
+              "[Op Codes]:\n"
+              "0\t0 OP_CONSTANT\t0 2.000000\n"
+              "2\t| OP_DEFINE_GLOBAL\tslot 0\n"
+              "4\t| OP_GET_GLOBAL\tslot 0\n"
+              "6\t| OP_MULTIPLY_CONSTANT\t1 3.000000\n"
+              "8\t| OP_PRINT\t\n"
+              "9\t| OP_RETURN\t\n"
+              "\n"
+              "6.000000\n");
+
+    //Tracing stops once it is turned off.
+    VM vm;
+    vm.setTracing(true);
+    vm.setTracing(false);
+    testing::internal::CaptureStdout();
+    vm.interpret(script);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "6.000000\n");
+}
+
+#endif //TITANPLUSPLUS_STACKTESTING_H